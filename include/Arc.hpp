@@ -56,6 +56,7 @@ class Arc
         inline void changeWeight( double change ) { ( weight >= 0 && sign != Sign::NEG ) ? weight += change : weight -= change; restrictSign(); } 
         inline void restrictSign() { if( ( sign == Sign::POS && weight < 0.0 ) || ( sign == Sign::NEG && weight > 0.0 ) ) weight = 0.0; } //fit the sign restrictions. Used after crossover of mutation in GA
         double forwardProp(); //forward pass. Called from the same method in Node
+        void forwardPropBounds( double& lOutput, double& uOutput ); //forward pass of value intervals instead of values. Called from the same method in Node
 
 
     private:
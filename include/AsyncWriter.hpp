@@ -0,0 +1,63 @@
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include "defines.hpp"
+
+#include <string> //file names, buffers
+#include <vector> //failedFileNames
+#include <deque> //requests
+#include <map> //files
+#include <memory> //std::shared_ptr<std::ofstream> files
+#include <fstream> //open files
+#include <thread> //writerThread
+#include <mutex> //mutex
+#include <condition_variable> //producers and writer waits
+
+
+///writes buffers to files from a background thread, so the thread that makes them does not wait for the disk. The queue is bounded in bytes: write() waits only while it is full.
+///Files stay open between writes until closed (FLAG_WRITE_CLOSE). Everything queued is written when flushed and when the writer is destroyed
+class AsyncWriter
+{
+    public:
+    //---static
+        static void appendNumber( std::string& buffer, double value ); //same text as std::ostream << value (6 significant digits), without the stream
+        static void appendNumber( std::string& buffer, uint64_t value );
+        static bool writeFile( const std::string& fileName, const std::string& buffer, uint64_t options = FLAG_WRITE_NEW ); //write a buffer in the calling thread. Same options as write()
+
+        AsyncWriter( size_t maxQueuedBytes = EMITTER_WRITER_MAX_QUEUED_BYTES );
+        virtual ~AsyncWriter(); //write everything queued, report the failed files and close them
+        AsyncWriter( const AsyncWriter& ) = delete; //owns the thread, share it with a shared_ptr
+        AsyncWriter& operator=( const AsyncWriter& ) = delete;
+
+    //---API
+        void write( const std::string& fileName, std::string&& buffer, uint64_t options = FLAG_NULL ); //queue a buffer for the end of the file (or the start of a new file with FLAG_WRITE_NEW)
+        inline void close( const std::string& fileName ) { write( fileName, std::string(), FLAG_WRITE_CLOSE ); }
+        bool flush(); //wait until everything queued is in the files (checkpoint). False if any write failed since the last flush. The failed files are reported
+
+
+    private:
+        ///a buffer waiting to be written
+        struct Request
+        {
+            std::string fileName;
+            std::string buffer;
+            uint64_t options; //FLAG_WRITE_*
+        };
+
+        size_t maxQueuedBytes; //write() waits while more bytes than this are queued
+        size_t queuedBytes; //bytes in the queue
+        std::deque<Request> requests; //queue, in order of arrival
+        bool bWriting; //whether the writer thread is writing a request already out of the queue
+        bool bStop; //tells the writer thread to finish once the queue is empty
+        std::map<std::string, std::shared_ptr<std::ofstream>> files; //open files. Only used by the writer thread
+        std::vector<std::string> failedFileNames; //files that could not be written since the last flush
+        std::mutex mutex; //guards the queue, the flags and failedFileNames
+        std::condition_variable queueCondition; //signals the writer thread that there are requests or it must stop
+        std::condition_variable doneCondition; //signals the producers that there is room or the queue is done
+        std::thread writerThread;
+
+        void run(); //writer thread loop
+        void writeRequest( const Request& request, std::vector<std::string>& requestFailedFileNames ); //write a request to its file, opening or closing it as needed. The files that fail are added to requestFailedFileNames
+};
+
+#endif //ASYNC_WRITER_HPP
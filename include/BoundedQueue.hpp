@@ -0,0 +1,85 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include "defines.hpp"
+
+#include <deque> //items
+#include <mutex> //mutex
+#include <condition_variable> //producer and consumer waits
+#include <chrono> //wait times
+#include <algorithm> //std::max
+
+
+///queue between the threads of a pipeline holding at most capacity items: push() waits while it is full (backpressure on the producer) and pop() while it is empty.
+///Closing it tells the consumer that nothing more will come once the queue is drained, and the producer that nothing more is wanted. The time each side spends waiting tells which stage is the bottleneck
+template<typename T>
+class BoundedQueue
+{
+    public:
+        BoundedQueue( uint capacity ) : capacity( std::max( 1u, capacity ) ), bClosed(false), peakSize(0), pushWaitSeconds(0.0), popWaitSeconds(0.0) {}
+        BoundedQueue( const BoundedQueue& ) = delete; //shared by the threads
+        BoundedQueue& operator=( const BoundedQueue& ) = delete;
+
+    //---get
+        inline uint getCapacity() const { return capacity; }
+        inline uint getPeakSize() const { std::lock_guard<std::mutex> lock( mutex ); return peakSize; } //most items queued at once
+        inline double getPushWaitSeconds() const { std::lock_guard<std::mutex> lock( mutex ); return pushWaitSeconds; } //time the producer waited for room
+        inline double getPopWaitSeconds() const { std::lock_guard<std::mutex> lock( mutex ); return popWaitSeconds; } //time the consumer waited for items
+
+    //---API
+        bool push( T&& item ) //add an item at the end, waiting for room. False (item dropped) if the queue is closed
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            if( items.size() >= capacity && ! bClosed )
+            {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                notFullCondition.wait( lock, [this]{ return items.size() < capacity || bClosed; } );
+                pushWaitSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            }
+            if( bClosed )
+                return false;
+            items.push_back( std::move( item ) );
+            peakSize = std::max<uint>( peakSize, items.size() );
+            notEmptyCondition.notify_one();
+            return true;
+        }
+
+        bool pop( T& item ) //take the first item, waiting for one. False if the queue is closed and empty
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            if( items.empty() && ! bClosed )
+            {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                notEmptyCondition.wait( lock, [this]{ return ! items.empty() || bClosed; } );
+                popWaitSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            }
+            if( items.empty() )
+                return false;
+            item = std::move( items.front() );
+            items.pop_front();
+            notFullCondition.notify_one();
+            return true;
+        }
+
+        void close() //no more pushes. The items already queued can still be popped
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            bClosed = true;
+            notFullCondition.notify_all();
+            notEmptyCondition.notify_all();
+        }
+
+
+    private:
+        uint capacity; //maximum number of queued items
+        bool bClosed;
+        std::deque<T> items; //in order of arrival
+        uint peakSize;
+        double pushWaitSeconds;
+        double popWaitSeconds;
+        mutable std::mutex mutex; //guards everything but capacity
+        std::condition_variable notFullCondition; //signals the producer that there is room or the queue is closed
+        std::condition_variable notEmptyCondition; //signals the consumer that there are items or the queue is closed
+};
+
+#endif //BOUNDED_QUEUE_HPP
@@ -0,0 +1,82 @@
+#ifndef COMBINATION_SEARCH_HPP
+#define COMBINATION_SEARCH_HPP
+
+#include "defines.hpp"
+#include "Parser.hpp" //Params constructor
+#include "NeuralWebBase.hpp" //const NeuralWebBase* net, predictBounds()
+#include "DatasetBase.hpp" //const DatasetBase* filterDataset
+#include "InstanceFilterIndex.hpp" //filterIndex
+
+#include <vector> //lInputs, uInputs, results
+#include <utility> //std::pair in results
+#include <string> //makeSummary()
+
+
+///branch-and-bound search over all the input combinations with a given number of 0s. The inputs are decided one by one and the output of every partial assignment is bounded by NeuralWebBase::predictBounds(), so whole subtrees are pruned without predicting their combinations.
+///Two modes: keep the combinations with predicted output in [ thresholdL, thresholdU ] (same result as predicting all the combinations and filtering them) or keep the top K highest (lowest) predicted outputs
+class CombinationSearch
+{
+    public:
+        ///search params
+        struct Params
+        {
+            uint zerosNum; //number of 0 inputs in the combinations
+            double thresholdL; //lower predicted output threshold for keeping a combination (threshold mode)
+            double thresholdU; //upper predicted output threshold for keeping a combination (threshold mode)
+            uint topK; //number of combinations kept in top K mode. 0 = threshold mode
+            bool bTopKHighest; //whether the top K are the highest (true) or the lowest (false) predicted outputs
+            uint filterMode; //filter related to the main dataset. 0 = no filter, 1 = remove repeated and supersets, 2 = remove supersets of instances with given output
+            uint filterInput; //if filter mode = 1 or 2, instance value to use for determining that one instance is a superset of another one
+            uint filterClass; //if filter mode = 1 or 2, output value to remove
+
+            Params( const Parser& parser ) : zerosNum( parser.getUintParam( "zerosNum" ) )
+            , thresholdL( parser.getRealParam( "predictionPrintThresholdL" ) ), thresholdU( parser.getRealParam( "predictionPrintThresholdU" ) )
+            , topK( parser.getUintParam( "predictionTopK" ) ), bTopKHighest( parser.getIntParam( "predictionTopKHighest" ) )
+            , filterMode( parser.getUintParam( "combisFilterMode" ) ), filterInput( parser.getUintParam( "combisFilterInput" ) ), filterClass( parser.getUintParam( "combisFilterClass" ) ) {;}
+        };
+
+        CombinationSearch( const Parser& parser, const NeuralWebBase* net, const DatasetBase* filterDataset = nullptr ) : params(parser), net(net), filterDataset(filterDataset)
+        , visitedNum(0), prunedNum(0), leafNum(0) {;}
+        virtual ~CombinationSearch() {}
+
+    //---get
+        const std::vector<std::vector<double>>& getInputs() const { return inputs; }
+        const std::vector<double>& getOutputs() const { return outputs; }
+        inline uint64_t getVisitedNum() const { return visitedNum; }
+        inline uint64_t getPrunedNum() const { return prunedNum; }
+        inline uint64_t getLeafNum() const { return leafNum; }
+
+    //---API
+        //search the combinations of inputNum inputs. Results in lexicographic order (threshold mode) or sorted by predicted output (top K mode)
+        void search( uint inputNum );
+        std::string makeSummary() const; //number of partial assignments visited, pruned and predicted vs the total number of combinations. For the summary file
+
+
+    private:
+        Params params;
+        const NeuralWebBase* net; //single net or ensemble used for predicting and bounding
+        const DatasetBase* filterDataset; //main dataset used for filtering. Can be nullptr if no filter
+
+    //current partial assignment. Undecided inputs are in [ 0.0, 1.0 ]
+        std::vector<double> lInputs;
+        std::vector<double> uInputs;
+    //filter
+        InstanceFilterIndex filterIndex; //index of filterDataset according to filterMode
+    //results
+        std::vector<std::pair<double, std::vector<double>>> results; //( predicted output, inputs ). Min-heap by key in top K mode
+        std::vector<std::vector<double>> inputs;
+        std::vector<double> outputs;
+    //counters
+        uint64_t visitedNum; //partial assignments whose output was bounded
+        uint64_t prunedNum; //partial assignments discarded together with their whole subtree
+        uint64_t leafNum; //complete combinations predicted
+
+        void searchRec( uint inputIndex, uint zerosLeft ); //decide input inputIndex and go on deeper. zerosLeft = number of 0s still to place
+        void evaluateLeaf(); //predict a complete combination and keep it if required
+        bool bPrune( double lOutput, double uOutput ) const; //whether no combination with predicted output in [ lOutput, uOutput ] can be kept
+        //whether every completion of the current partial assignment is a superset of an instance of the filter class. Undecided inputs are taken as not having the filter value
+        inline bool bSupersetFiltered() const { return filterIndex.findSubset( params.filterInput == 0 ? uInputs : lInputs ); }
+        inline double key( double output ) const { return params.bTopKHighest ? output : - output; } //higher key = better in top K mode
+};
+
+#endif //COMBINATION_SEARCH_HPP
@@ -0,0 +1,46 @@
+#ifndef COMBINATION_STREAM_HPP
+#define COMBINATION_STREAM_HPP
+
+#include "defines.hpp"
+
+#include <vector> //currentCombination, nextChunk()
+
+
+///lazy source of all the input combinations of n elements with k 0s (bInverted = true) or k 1s (bInverted = false), in the same lexicographic order as DatasetBase::makeAllCombinations().
+///Combinations are identified by their rank in that order, so the stream can be restricted to an index range and the ranges run in separate processes and merged afterwards
+class CombinationStream
+{
+    public:
+    //---static
+        static uint64_t binomial( uint n, uint k ); //C(n, k). 0 if it does not fit in uint64_t
+        static void partRange( uint64_t combinationNum, uint partIndex, uint partNum, uint64_t& first, uint64_t& last ); //index range [ first, last ) of the part partIndex when splitting combinationNum combinations in partNum parts of equal size
+
+        //stream over the combinations with rank in [ first, last ). The range is clamped to the number of combinations
+        CombinationStream( uint n, uint k, bool bInverted = DEFAULT_DATASET_COMBI_INVERTED, uint64_t first = 0, uint64_t last = UINT64_MAX );
+        virtual ~CombinationStream() {}
+
+    //---get
+        inline uint64_t getCombinationNum() const { return combinationNum; }
+        inline uint64_t getFirst() const { return first; }
+        inline uint64_t getLast() const { return last; }
+        inline uint64_t getCurrent() const { return current; }
+        inline bool getBDone() const { return current >= last; }
+
+    //---API
+        std::vector<double> unrank( uint64_t rank ) const; //combination with the given rank
+        uint64_t rank( const std::vector<double>& combination ) const; //rank of the given combination
+        bool nextChunk( std::vector<std::vector<double>>& chunk, uint chunkSize = DEFAULT_DATASET_COMBI_CHUNK_SIZE ); //replace chunk with the next (up to) chunkSize combinations. False if there are no more combinations
+        inline void restart() { current = first; currentCombination.clear(); } //go back to the beginning of the range
+
+
+    private:
+        uint n; //number of inputs
+        uint zerosNum; //number of 0s in every combination
+        uint64_t combinationNum; //total number of combinations C(n, zerosNum)
+        uint64_t first; //rank of the first combination in the range
+        uint64_t last; //rank after the last combination in the range
+        uint64_t current; //rank of the next combination returned
+        std::vector<double> currentCombination; //combination with rank current. Empty until the first nextChunk()
+};
+
+#endif //COMBINATION_STREAM_HPP
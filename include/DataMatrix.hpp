@@ -0,0 +1,111 @@
+#ifndef DATA_MATRIX_HPP
+#define DATA_MATRIX_HPP
+
+#include "defines.hpp"
+
+#include <vector> //values, rows, order
+#include <memory> //std::shared_ptr<Block> block, std::shared_ptr<const std::vector<uint>> order, std::shared_ptr<const void> owner
+#include <new> //::operator new in AlignedAllocator
+#include <cstddef> //size_t
+#include <algorithm> //std::copy in copyRow()
+
+
+///allocator for std::vector that aligns the first element to DATA_MATRIX_ALIGNMENT bytes. Over-allocates and keeps the original pointer just before the aligned block
+template<typename T>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    AlignedAllocator() {}
+    template<typename U> AlignedAllocator( const AlignedAllocator<U>& ) {}
+
+    T* allocate( size_t n )
+    {
+        void* raw = ::operator new( n * sizeof( T ) + DATA_MATRIX_ALIGNMENT + sizeof( void* ) );
+        size_t aligned = ( reinterpret_cast<size_t>( raw ) + sizeof( void* ) + DATA_MATRIX_ALIGNMENT - 1 ) & ~static_cast<size_t>( DATA_MATRIX_ALIGNMENT - 1 );
+        reinterpret_cast<void**>( aligned )[-1] = raw;
+        return reinterpret_cast<T*>( aligned );
+    }
+    void deallocate( T* p, size_t ) { ::operator delete( reinterpret_cast<void**>( p )[-1] ); }
+
+    template<typename U> struct rebind { typedef AlignedAllocator<U> other; };
+    template<typename U> bool operator==( const AlignedAllocator<U>& ) const { return true; }
+    template<typename U> bool operator!=( const AlignedAllocator<U>& ) const { return false; }
+};
+
+
+///read-only view of the input values of one instance: a row of a DataMatrix or a whole std::vector<double>. Does not own the values
+struct InputSpan
+{
+    const double* values;
+    uint length;
+
+    InputSpan() : values(nullptr), length(0) {}
+    InputSpan( const double* values, uint length ) : values(values), length(length) {}
+    InputSpan( const std::vector<double>& vector ) : values( vector.data() ), length( vector.size() ) {} //implicit, so vectors can be passed where a span is expected
+
+    inline double operator[]( uint i ) const { return values[i]; }
+    inline uint size() const { return length; }
+    inline const double* begin() const { return values; }
+    inline const double* end() const { return values + length; }
+    inline std::vector<double> toVector() const { return std::vector<double>( values, values + length ); }
+};
+
+
+///inputs of a set of instances in a single contiguous, aligned block. Row-major with each row padded (with 0s) to a multiple of DATA_MATRIX_ALIGNMENT bytes, so every row starts aligned.
+///Reads like a std::vector<std::vector<double>> ( size(), [row][input] ) for the code that iterates datasets.
+///The block is shared: copies are shallow and gather() makes a view (a row order over the same block), so subsets and folds do not copy inputs. Copy on write is explicit: makeOwn() copies the rows of a shared matrix or a view into an own block, and is called by the modifying API and before writing through row()
+class DataMatrix
+{
+    public:
+        DataMatrix() : rowNum(0), colNum(0), stride(0), block( std::make_shared<Block>() ) {}
+        DataMatrix( uint rowNum, uint colNum, double value = 0.0 );
+        DataMatrix( const std::vector<std::vector<double>>& rows ); //implicit: copy rows of equal size into a single block
+        DataMatrix( const double* values, uint rowNum, uint colNum, uint stride, const std::shared_ptr<const void>& owner ); //wrap rows stored elsewhere (e.g. a mapped file) without copying them. owner keeps the memory alive. Read-only: modifying copies the rows first
+
+    //---get
+        inline uint size() const { return rowNum; }
+        inline bool empty() const { return rowNum == 0; }
+        inline uint getRowNum() const { return rowNum; }
+        inline uint getColNum() const { return colNum; }
+        inline uint getStride() const { return stride; } //distance in doubles between the starts of two consecutive rows
+        inline bool getBView() const { return order != nullptr; } //whether the rows are picked from the block by an order, so they are not consecutive
+        inline bool getBExternal() const { return block->external != nullptr; } //whether the rows are not owned (wrapped memory)
+        inline const double* row( uint r ) const { return block->data() + static_cast<size_t>( order ? (*order)[r] : r ) * stride; }
+        inline double* row( uint r ) { return block->values.data() + static_cast<size_t>( r ) * stride; } //writable row. The matrix must own its rows: made by the ( rowNum, colNum ) or rows constructors, or makeOwn() called before the writes
+        inline InputSpan operator[]( uint r ) const { return InputSpan( row( r ), colNum ); }
+
+    //---API
+        inline void makeOwn() { if( order || block.use_count() > 1 || block->external != nullptr ) *this = compact(); } //copy on write: own copy of the rows if they are a view, external or shared with other copies. Out of the threads, before writing through row()
+        void appendRow( const InputSpan& newRow ); //add a row at the end. The first row of an empty matrix sets the number of columns
+        inline void copyRow( uint to, uint from ) { if( to != from ) std::copy( row( from ), row( from ) + stride, row( to ) ); } //overwrite a row with another one. For compacting in place, after makeOwn()
+        inline void resizeRows( uint newRowNum ) { makeOwn(); rowNum = newRowNum; block->values.resize( static_cast<size_t>( rowNum ) * stride, 0.0 ); } //keep the first rows (or add rows of 0s)
+        inline void clear() { rowNum = 0; order.reset(); block = std::make_shared<Block>(); }
+        DataMatrix gather( const std::vector<uint>& rowIndexes ) const; //view of the given rows in the given order over the same block. Only the row order is allocated
+        DataMatrix compact() const; //own contiguous copy of the rows. For consecutive rows when the matrix is a view
+        std::vector<std::vector<double>> toRows() const; //copy as a vector of rows
+        bool isBinary() const; //whether every value is 0 or 1
+
+
+    private:
+        ///rows shared by all the copies and views of a matrix
+        struct Block
+        {
+            std::vector<double, AlignedAllocator<double>> values; //rows * stride values. Empty if external
+            const double* external; //rows * stride values not owned by the block. Null if the values are owned
+            std::shared_ptr<const void> owner; //keeps the external values alive
+
+            Block() : external(nullptr) {}
+            inline const double* data() const { return external != nullptr ? external : values.data(); }
+        };
+
+        uint rowNum; //number of instances
+        uint colNum; //number of inputs
+        uint stride; //colNum rounded up to the alignment
+        std::shared_ptr<Block> block;
+        std::shared_ptr<const std::vector<uint>> order; //block row of each row. Null if the rows are the block rows in order (not a view)
+
+        static inline uint makeStride( uint colNum ) { const uint align = DATA_MATRIX_ALIGNMENT / sizeof( double ); return ( colNum + align - 1 ) / align * align; }
+};
+
+#endif //DATA_MATRIX_HPP
@@ -4,61 +4,60 @@
 #include "defines.hpp"
 #include "DatasetBase.hpp" //parent class
 
-#include <vector> //folds
-#include <memory> //std::vector<DatasetSP> foldsTraining, std::vector<DatasetSP> foldsTest
+#include <vector> //foldOrder, foldTestRanges
+#include <memory> //DatasetSP foldTraining, DatasetSP foldTest
+#include <utility> //std::pair in foldTestRanges
 
-///extends DatasetBase with data spliting functionality: LOO, stratified single split and stratified k-fold. Holds pointers to the resulting child datasets to iterate them
+///extends DatasetBase with data spliting functionality: LOO, stratified single split and stratified k-fold. The folds are kept as a single row order with the test range of each fold, and only the current fold is made, as child datasets that view the inputs of this one. So the splits take O(N) memory for any number of folds
 class Dataset : public DatasetBase
 {
     public:
-        Dataset( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights = {}, double classThreshold = DEFAULT_DATASET_CLASS_THRESHOLD ) //creation constructor
-        : DatasetBase::DatasetBase( inputs, outputs, instanceWeights, classThreshold )
-        {  initKFold( 1 ); initReflection(); }
+        Dataset( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights = {}, double classThreshold = DEFAULT_DATASET_CLASS_THRESHOLD, const std::vector<uint>& rowIds = {} ) //creation constructor
+        : DatasetBase::DatasetBase( inputs, outputs, instanceWeights, classThreshold, rowIds ), bFoldsBySimilarity(false)
+        {  initKFold( 1 ); }
 
-        Dataset() : DatasetBase::DatasetBase(), foldNum(0), currentTestFold(0), foldSize(0) { initReflection(); } //null constructor. Allows for not initializing Dataset member vars in constructor
+        Dataset() : DatasetBase::DatasetBase(), bFoldsBySimilarity(false), foldNum(0), currentTestFold(0), foldSize(0) {} //null constructor. Allows for not initializing Dataset member vars in constructor
         
-        Dataset( const Dataset* originalDataset ) //fake deep copy constructor: rely on DatasetBase default copy constructor for all DatasetBase vars. Make copies of the child Datasets
-        : DatasetBase::DatasetBase( *originalDataset )
+        Dataset( const Dataset* originalDataset ) //copy constructor: rely on DatasetBase default copy constructor for all DatasetBase vars (inputs are shared, not copied). Copy the fold order and ranges, and make the first fold again
+        : DatasetBase::DatasetBase( *originalDataset ), foldOrder( originalDataset->foldOrder ), foldTestRanges( originalDataset->foldTestRanges ), bFoldsBySimilarity( originalDataset->bFoldsBySimilarity )
         { 
-            foldsTraining.clear(); foldsTest.clear();
-            for( uint f = 0; f < originalDataset->foldsTraining.size(); f++ )
-                foldsTraining.push_back( std::make_shared<Dataset>( originalDataset->foldsTraining[f].get() ) );
-
-            for( uint f = 0; f < originalDataset->foldsTest.size(); f++ )
-                foldsTest.push_back( std::make_shared<Dataset>( originalDataset->foldsTest[f].get() ) );
-
-            initKFold( originalDataset->foldNum ); initReflection(); 
+            initKFold( originalDataset->foldNum );
         } 
 
         virtual ~Dataset() {}
 
     //----get
         //data splits
-        inline DatasetSP getTrainingFold() const { return foldsTraining[currentTestFold]; } //get current train fold
-        inline DatasetSP getTestFold() const { return foldsTest[currentTestFold]; } //get current val or fair test fold
-        inline DatasetSP getReflectedFold( uint index ) const { return ( *foldsReflection[index] )[ currentTestFold ]; } //get current fold, selecting either train or test by index
+        inline DatasetSP getTrainingFold() const { return foldTraining; } //get current train fold. Null if there are no folds
+        inline DatasetSP getTestFold() const { return foldTest; } //get current val or fair test fold. Null if there are no folds
+        inline DatasetSP getReflectedFold( uint index ) const { return index == 0 ? getTrainingFold() : getTestFold(); } //get current fold, selecting either train (0) or test (1) by index
 
     //---API
         //instance weighting by similarity
-        void dissimilaritySubsets(); //create the similarity matrix, dissimilarity score and make them the instance weights for all the contained data splits. Training splits: relative to self. Test splits: relative to the corresponding training split
+        inline void dissimilaritySubsets() { bFoldsBySimilarity = true; makeCurrentFold(); } //create the similarity matrix, dissimilarity score and make them the instance weights of the data splits (of each fold when it is made). Training splits: relative to self. Test splits: relative to the corresponding training split
 
         //data splits
-        inline void makeAllTraining() { foldsTest.clear(); foldsTraining = { std::make_shared<Dataset>( inputs, outputs, instanceWeights, classThreshold ) }; initKFold( 1 ); } //make a single training split with all the cases
-        inline void makeAllTest() { foldsTraining.clear(); foldsTest = { std::make_shared<Dataset>( inputs, outputs, instanceWeights, classThreshold ) }; initKFold( 1 );  } //make a single test split with all the cases
+        inline void makeAllTraining() { setFolds( {}, { std::make_pair( inputs.size(), inputs.size() ) } ); } //make a single training split with all the cases (and an empty test split)
+        inline void makeAllTest() { setFolds( {}, { std::make_pair( 0u, inputs.size() ) } ); } //make a single test split with all the cases (and an empty training split)
         void makeSingleFold( RandomEngine& randomEngine, uint instanceNum ); //separate a test split of instanceNum cases and a training split of total - instanceNum cases. Stratified
         void leaveOneOut(); //make as many train-test split pairs as cases, train with total - 1 cases and test with 1 case
         void makeStratifiedKFold( RandomEngine& randomEngine, uint k ); //make k train-test split pairs, train with total - total/k cases and test with total/k cases
         
-        inline void initReflection() { foldsReflection = { &foldsTraining, &foldsTest }; } //reflection of train ans test sets of splits to access them by index
-        inline void initKFold( uint k ) { foldNum = k; foldSize = inputs.size() / foldNum; currentTestFold = 0; } //initialize previously splitted k-fold to start iterating the folds from the first one
-        inline void nextFold() { currentTestFold = (currentTestFold + 1) % foldNum; } //circular iteration of the folds
+        inline void initKFold( uint k ) { foldNum = k; foldSize = inputs.size() / foldNum; currentTestFold = 0; makeCurrentFold(); } //initialize previously splitted k-fold to start iterating the folds from the first one
+        inline void nextFold() { currentTestFold = (currentTestFold + 1) % foldNum; makeCurrentFold(); } //circular iteration of the folds. The previous fold is released
         
 
     private:
+        DatasetSP makeSubset( const std::vector<uint>& indexes ) const; //child Dataset with the given rows (a view of the inputs), keeping their row ids. Bool outputs made and instance weights normalized
+        void setFolds( const std::vector<uint>& xFoldOrder, const std::vector<std::pair<uint, uint>>& xFoldTestRanges ); //keep the fold order and test ranges and start iterating the folds from the first one
+        void makeCurrentFold(); //make the train and test splits of the current fold: the test split is its range of foldOrder and the training split is the rest
+
     //data splits
-        std::vector<DatasetSP> foldsTraining; //splits for training. Used for single split, LOO and k-fold
-        std::vector<DatasetSP> foldsTest; //splits for val or fair test (depending on the dataset usage). Used for single split, LOO and k-fold
-        std::vector<std::vector<DatasetSP>*> foldsReflection; //reflection access to the 2 sets of splits by index
+        std::vector<uint> foldOrder; //cases in fold order: the test split of each fold is a range of it and its training split is the rest. Empty = dataset order
+        std::vector<std::pair<uint, uint>> foldTestRanges; //[ first, second ) range of foldOrder in the test split of each fold. Used for single split, LOO and k-fold
+        bool bFoldsBySimilarity; //whether the splits are weighted by similarity when made
+        DatasetSP foldTraining; //split for training of the current fold. Null if there are no folds
+        DatasetSP foldTest; //split for val or fair test (depending on the dataset usage) of the current fold. Null if there are no folds
         uint foldNum; //number of test splits = number of training splits = k. Used for single split, LOO and k-fold
         uint currentTestFold; //current split. Used for single split, LOO and k-fold
         uint foldSize; //number of cases per split in the case of k-fold
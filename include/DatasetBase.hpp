@@ -3,6 +3,8 @@
 
 #include "defines.hpp"
 #include "NeuralWebBase.hpp" //generateOutputs()
+#include "InstanceFilterIndex.hpp" //filterInstances()
+#include "DataMatrix.hpp" //DataMatrix inputs
 
 #include <vector> //inputs, outputs, instanceWeights
 
@@ -22,43 +24,55 @@ class DatasetBase
         //create the similarity matrix of a series of cases (1) relative to another series of cases (2)
         static std::vector<std::vector<double>> makeSimilarityMatrix( const std::vector<std::vector<double>>& inputs1, const std::vector<std::vector<double>>& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2 ); 
         static std::vector<double> sumSimilarityMatrix( const std::vector<std::vector<double>>& similarityMatrix ); //add up the similarity score for each case and reverse it (higher = more unique)
-
-
-        DatasetBase( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights = {}, double classThreshold = DEFAULT_DATASET_CLASS_THRESHOLD ) //creation constructor
-        : inputs(inputs), outputs(outputs), instanceWeights(instanceWeights), dataNum( inputs.size() ), classThreshold(classThreshold)
-        {  makeBoolOutputs(); }
-
-        DatasetBase() : dataNum(0), classThreshold(DEFAULT_DATASET_CLASS_THRESHOLD) {} //null constructor. Allows for not initializing Dataset member vars in constructor
+        //same as sumSimilarityMatrix( makeSimilarityMatrix() ) but by tiles and in parallel, from packed inputs if all of them are 0 or 1 (exact comparison of the values otherwise). The matrix is only filled if provided
+        static std::vector<double> sumDissimilarities( const DataMatrix& inputs1, const DataMatrix& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2, std::vector<std::vector<double>>* similarityMatrix = nullptr );
+        //same sums as sumDissimilarities() in O(N * inputs): the number of different inputs added up over all the cases (2) of a class only depends on how many of them have each input to 1 (each value of each input if not binary)
+        static std::vector<double> sumDissimilaritiesByCounts( const DataMatrix& inputs1, const DataMatrix& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2 );
+        //compare the sums of checkNum evenly spaced cases (1) with the pair-wise ones and print the max and mean error and the times
+        static void checkDissimilarities( const std::vector<double>& dissimilaritySums, const DataMatrix& inputs1, const DataMatrix& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2, uint checkNum, double countsSeconds );
+        static inline void setBKeepSimilarityMatrix( bool xBKeepSimilarityMatrix ) { bKeepSimilarityMatrix = xBKeepSimilarityMatrix; }
+        static inline void setSimilarityMode( uint xSimilarityMode, uint xSimilarityCheckNum = DEFAULT_DATASET_SIM_CHECK_NUM ) { similarityMode = xSimilarityMode; similarityCheckNum = xSimilarityCheckNum; }
+
+
+        //creation constructor. Rows get ids 0..N-1 unless given (subsets of another dataset keep the ids of their rows)
+        DatasetBase( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights = {}, double classThreshold = DEFAULT_DATASET_CLASS_THRESHOLD, const std::vector<uint>& rowIds = {} )
+        : inputs(inputs), rowIds(rowIds), outputs(outputs), instanceWeights(instanceWeights), dataNum( inputs.size() ), classThreshold(classThreshold), bSimilarityWeighted(false)
+        {  if( DatasetBase::rowIds.empty() ) makeRowIds(); makeBoolOutputs(); }
+
+        DatasetBase() : dataNum(0), classThreshold(DEFAULT_DATASET_CLASS_THRESHOLD), bSimilarityWeighted(false) {} //null constructor. Allows for not initializing Dataset member vars in constructor
         
         virtual ~DatasetBase() = default;
 
     //----get
-        inline const std::vector<std::vector<double>>& getInputs() const { return inputs; }
+        inline const DataMatrix& getInputs() const { return inputs; }
+        inline const std::vector<uint>& getRowIds() const { return rowIds; }
         inline const std::vector<double>& getOutputs() const { return outputs; }
         inline const std::vector<double>& getBoolOutputs() const { return boolOutputs; }
         inline const std::vector<double>& getInstanceWeights() const { return instanceWeights; }
         inline uint getDataNum() const { return dataNum; }
+        inline bool getBSimilarityWeighted() const { return bSimilarityWeighted; }
 
     //---set
-        inline void setInputs( const std::vector<std::vector<double>>& xInputs ) { inputs = xInputs; }
+        inline void setInputs( const DataMatrix& xInputs ) { inputs = xInputs; makeRowIds(); }
         inline void setOutputs( const std::vector<double>& xOutputs ) { outputs = xOutputs; makeBoolOutputs(); }
         
-        inline void addInput( const std::vector<double>& newInput ) { inputs.push_back( newInput ); }
+        inline void addInput( const InputSpan& newInput ) { rowIds.push_back( inputs.size() ); inputs.appendRow( newInput ); }
         inline void addOutput( double newOutput ) { outputs.push_back( newOutput ); }
 
     //---API
         //generate
         //make all posible input combinations of n inputs with k 1s ( bInverted = false ) or k 0s ( bInverted = true )
-        inline void makeInputCombinations( uint n, uint k, bool bInverted = DEFAULT_DATASET_COMBI_INVERTED ) { inputs = makeAllCombinations( n, k, bInverted ); outputs = std::vector<double>( inputs.size(), 1.0 ); makeBoolOutputs(); }
+        inline void makeInputCombinations( uint n, uint k, bool bInverted = DEFAULT_DATASET_COMBI_INVERTED ) { inputs = makeAllCombinations( n, k, bInverted ); makeRowIds(); outputs = std::vector<double>( inputs.size(), 1.0 ); makeBoolOutputs(); }
         void generateOutputs( const NeuralWebBase* net ); //generate output predictions for the current inputs by using either a single NeuralWeb or an ensemble
         void filterInstancesEqual( const DatasetBase* filter ); //remove the instances that are equal (input only) to any other in the digen dataset
         void filterInstancesSuperset( const DatasetBase* filter, uint inputValue = DEFAULT_DATASET_FILTER_INPUT, uint classValue = DEFAULT_DATASET_FILTER_CLASS ); //remove the instances that are supersets of any other with the given classValue in the provided dataset
+        void filterInstances( const InstanceFilterIndex& filterIndex ); //remove the instances found in an index of another dataset. For filtering several datasets (or chunks) with the same index
         //instance weighting
         void weightInstances( double instanceWeightByOutput, double instanceWeightByInput, bool bSimilarityAsWeights = false ); //make instance weights by inputs, output or similarity
         void normalizeInstanceWeights(); //make all instance weights add up to 1. Must be called after creating or modifying the weights and after spliting the data
 
         //instance weighting by similarity
-        void makeSimilarityMatrix( const DatasetBase* referenceDataset = nullptr ); //create the similarity matrix relative to a given dataset and the total dissimilarity score. If null dataset, relative to self
+        void makeSimilarityMatrix( const DatasetBase* referenceDataset = nullptr ); //create the total dissimilarity score relative to a given dataset (and the similarity matrix if bKeepSimilarityMatrix in pair-wise mode). If null dataset, relative to self
         inline void dissimilarityAsInstanceWeights() { instanceWeights = dissimilaritySum; normalizeInstanceWeights(); } //use the total dissimilarity score relative to self as instance weights
         inline void relativeDissimilarityAsInstanceWeights() { instanceWeights = dissimilaritySumRelative; normalizeInstanceWeights(); } //use the total dissimilarity score relative to another dataset as instance weights
 
@@ -69,7 +83,8 @@ class DatasetBase
 
     protected:
     //data
-        std::vector<std::vector<double>> inputs;
+        DataMatrix inputs; //contiguous aligned rows
+        std::vector<uint> rowIds; //stable id of each row: its index in the dataset it comes from. Kept through shuffles, filters and splits
         std::vector<double> outputs; //real output
         std::vector<double> boolOutputs; //binarized output. Typically matches outputs
         std::vector<double> instanceWeights;
@@ -77,6 +92,10 @@ class DatasetBase
         double classThreshold; //threshold using for binarizing real output. Tipically 0.5
 
     //instance weighting by similarity
+        static bool bKeepSimilarityMatrix; //whether to store the N x N similarity matrices or only the dissimilarity sums. Only for inspection, the sums do not need them
+        static uint similarityMode; //DATASET_SIM_MODE_PAIRWISE or DATASET_SIM_MODE_COUNTS
+        static uint similarityCheckNum; //number of cases checked against the pair-wise sums in counts mode
+        bool bSimilarityWeighted; //whether the instances were weighted by similarity, so the splits must be weighted the same way
         std::vector<std::vector<double>> similarityMatrix; //pair-wise similarity between cases in this dataset
         std::vector<std::vector<double>> similarityMatrixRelative; //pair-wise similarity of the cases in this dataset relative to another dataset
         std::vector<double> dissimilaritySum; //total dissimilarity score of each instance relative to all the other instances in this dataset. Can be used as instance weight for train splits
@@ -84,6 +103,7 @@ class DatasetBase
 
     //misc
         void makeBoolOutputs(); //binarize real outputs
+        inline void makeRowIds() { rowIds.resize( inputs.size() ); for( uint r = 0; r < rowIds.size(); r++ ) rowIds[r] = r; } //ids 0..N-1
 };
 
 #endif //DATASET_BASE_HPP
@@ -5,11 +5,16 @@
 #include "NeuralWeb.hpp" //std::vector<Metrics> totalMetrics
 #include "Dataset.hpp" //printDataset()
 #include "HistoricalTrack.hpp" //printHistorical()
+#include "AsyncWriter.hpp" //std::shared_ptr<AsyncWriter> writer
+#include "EnsembleSweep.hpp" //printEnsembleSweep()
+#include "ThresholdCurve.hpp" //printThresholdCurve()
+#include "KnockoutScreen.hpp" //printKnockoutScreen()
+#include "NodeAttribution.hpp" //printAttributions()
 
 #include <vector> //std::vector<std::string> metricNames, std::vector<std::string> setNames, std::vector<std::string> header, std::vector<Metrics> totalMetrics, many methods args
 #include <string> //std::vector<std::string> metricNames, std::vector<std::string> setNames, std::vector<std::string> header, many methods args
-#include <memory> //std::shared_pointer<std::ofstream> resultFile
-#include <fstream> //output files, std::ofstream* resultFile
+#include <memory> //std::shared_ptr<AsyncWriter> writer
+#include <fstream> //printHistorical(), mergeDatasetFiles()
 
 
 class Emitter
@@ -21,35 +26,60 @@ class Emitter
         //out files
         //save a net to a file with given options. If untrained, a single main file; if trained, additional scales and metrics files
         static bool printNetwork( const NeuralWeb* net, uint64_t options = DEFAULT_EMITTER_FLAG_NET, const std::string& netFileName = MAKE_FILENAME( OUTFILE_NET_W, 0 ), const std::string& activationFileName = MAKE_FILENAME( OUTFILE_NET_ACTI, 0 ), const std::string& metricsFileName = MAKE_FILENAME( OUTFILE_NET_METRICS, 0 ) );
+        static bool printNetworkBinary( const NeuralWeb* net, const std::string& fileName ); //save the parameter vector and metrics of a trained net in a single binary file (Parser::NetFileHeader)
+        static bool printEnsembleBinary( const std::vector<NeuralWebSP>& memberNets, uint firstNetIndex, const std::string& fileName ); //save the parameter vectors and metrics of nets with the same topology in a single ensemble bundle file (Parser::EnsembleFileHeader)
         static bool printHistorical( const HistoricalTrack& historicalTrack, const std::string& fileName = MAKE_FILENAME( OUTFILE_HISTORICAL, 0 ) );
+        static bool mergeDatasetFiles( const std::vector<std::string>& partFileNames, const std::string& fileName ); //concatenate dataset files printed by parts (printDatasetHeader() + printDatasetChunk()) keeping a single header
+        static bool mergePredictionFilesBinary( const std::vector<std::string>& partFileNames, const std::string& fileName ); //same for binary prediction files (FLAG_DATA_BINARY)
         static std::string resizeStr( const std::string& originalStr, uint targetSize ); //add spaces to str until target size. Used for equal-size-fields aligned output
  
-        Emitter() : totalMetrics( SET_NUM, Metrics( 0.0, nullptr ) ), resultFile( std::make_shared<std::ofstream>( OUTFILE_RESULT ) ) { resultFile->close(); }
-        virtual ~Emitter() { resultFile->close(); }
+        Emitter() : netFormat( NET_FORMAT_TEXT ), bSaveThresholdCurves(false), totalMetrics( SET_NUM, Metrics( 0.0, nullptr ) ), writer( std::make_shared<AsyncWriter>() ) { writer->write( OUTFILE_RESULT, std::string(), FLAG_WRITE_NEW ); } //the result file starts empty and stays open
+        virtual ~Emitter() {} //the writer writes everything left when the last copy of the emitter is destroyed
 
     //---get 
-        inline std::ofstream& getResultFile() { return *resultFile; } 
         const Metrics& getTotalMetrics( uint setIndex ) const { return totalMetrics[setIndex]; }
 
     //---set
         inline void setHeader( const std::vector<std::string>& xHeader ) { header = xHeader; }
+        inline void setNetFormat( uint xNetFormat ) { netFormat = xNetFormat; }
+        inline void setBSaveThresholdCurves( bool xBSaveThresholdCurves ) { bSaveThresholdCurves = xBSaveThresholdCurves; }
 
     //---API
         //metrics
         void addMetrics( const Metrics* metricsToAdd, uint setIndex ) { totalMetrics[setIndex].add( metricsToAdd ); } //add metrics to total metrics
         void resetTotalMetrics() { for( uint m = 0; m < totalMetrics.size(); m++ ) totalMetrics[m].reset( 0.0 ); }
         //out files
+        //files. Everything but the static methods is formatted in the calling thread and written by the writer thread: the files are complete after flush()
+        inline bool flush() { return writer->flush(); } //checkpoint: wait until all the output is in the files. False if any file could not be written
         //print dataset with given options (binarize, include predictions, count 0 inputs... ) filtered by output range of interest to keep file small. Not static because requires header
         bool printDataset( const Dataset& correctDataset, const Dataset& predictedDataset, uint64_t options = DEFAULT_EMITTER_FLAG_DATA, const std::string& fileName = MAKE_FILENAME( OUTFILE_DATAPRED, 0 ), double outputLBound = DEFAULT_EMITTER_DATA_LBOUND, double outputUBound = DEFAULT_EMITTER_DATA_UBOUND, double classThreshold = 0.5 );
+        //same as printDataset() in chunks for datasets that do not fit in memory: create the file with the header and then append the chunks. printedNum = rows already in the file, updated
+        bool printDatasetHeader( uint64_t options = DEFAULT_EMITTER_FLAG_DATA, const std::string& fileName = MAKE_FILENAME( OUTFILE_DATAPRED, 0 ) );
+        bool printDatasetChunk( const Dataset& correctDataset, const Dataset& predictedDataset, uint64_t& printedNum, uint64_t options = DEFAULT_EMITTER_FLAG_DATA, const std::string& fileName = MAKE_FILENAME( OUTFILE_DATAPRED, 0 ), double outputLBound = DEFAULT_EMITTER_DATA_LBOUND, double outputUBound = DEFAULT_EMITTER_DATA_UBOUND, double classThreshold = 0.5 );
+        bool printDatasetBinary( const Dataset& dataset, uint64_t options = DEFAULT_EMITTER_FLAG_DATA, const std::string& fileName = MAKE_FILENAME( OUTFILE_DATAPRED, 0 ) ); //save the dataset in the binary format the parser maps (Parser::DatasetFileHeader). Only FLAG_DATA_WEIGHT applies
         bool printExternalMetrics( const Metrics* metrics, const std::string& prefix = DEFAULT_EMITTER_METRICS_PREFIX ); //print metrics passed as arg (intead of it own total metrics) to the resultFile
         bool printMeanKfoldValues( uint k ); //make the average of metrics by dividing total metrics by k and print them
-        inline bool printMessage( const std::string& message ) { (*resultFile).open( OUTFILE_RESULT, std::ios_base::app ); if( ! (*resultFile).is_open() ) return false; (*resultFile) << message << "\n"; (*resultFile).close(); return true; } //print given msg to resultFile
-        void printAll( NeuralWebBase* currentNet, const Dataset* dataset, int setIndex, uint currentFold, bool bSaveNet, bool bSavePredictions, bool bEnsemble = false, const std::string& sufix = "" ); //evaluate and print metrics of best net (to resultFile and console) and (optional) save net and predictions
+        bool printThresholdCurve( const ThresholdCurve& thresholdCurve, const std::string& prefix, const std::string& fileName ); //print the areas and best thresholds to the resultFile and console, and the curve (a row per threshold) to its file
+        bool printEnsembleSweep( const EnsembleSweep& ensembleSweep, const std::string& fileName = OUTFILE_ENSEMBLE_SWEEP ); //csv table with a row per setting: criterion, threshold, weighting, number of members, metrics in both sets and member weights
+        bool printKnockoutScreen( const KnockoutScreen& knockoutScreen, const std::string& fileName = OUTFILE_KNOCKOUTS ); //csv table with the intact net and a row per knockout: name, cone size, prediction shifts, class flips and metrics
+        bool printAttributions( const NodeAttribution& nodeAttribution, const std::string& fileName = OUTFILE_ATTRIBUTIONS, const std::string& summaryFileName = OUTFILE_ATTRIBUTION_SUMMARY ); //csv matrix with a row per instance (prediction and the attribution of each node) and csv table with the summary of each node and arc
+        inline bool printMessage( const std::string& message ) { writer->write( OUTFILE_RESULT, message + "\n" ); return true; } //print given msg to the result file
+        void printAll( NeuralWebBase* currentNet, const Dataset* dataset, int setIndex, uint currentFold, bool bSaveNet, bool bSavePredictions, bool bEnsemble = false, const std::string& sufix = "", const std::vector<double>* predictions = nullptr ); //evaluate and print metrics of best net (to resultFile and console) and (optional) save net, predictions and threshold curves. The predictions of the set are made unless given
 
     private:
+        uint netFormat; //format of the trained nets saved by printAll(): NET_FORMAT_TEXT, NET_FORMAT_BINARY or NET_FORMAT_BOTH
+        bool bSaveThresholdCurves; //whether printAll() prints the metrics of every class threshold (ThresholdCurve) of each set
         std::vector<Metrics> totalMetrics; //sum of metrics over the folds or rounds for calculating the average. Not the best place for this
         std::vector<std::string> header; //names of the input nodes in the same order that appear in the nets' input layer. Must be set from a net before saving datasets in order to include the header in the file. Must match the parser's header
-        std::shared_ptr<std::ofstream> resultFile; //file where everything that is not a net or a dataset is printed. Typically, fold metrics and final avg metrics. Matches the console output
+        std::shared_ptr<AsyncWriter> writer; //writes the files in the background. The result file (OUTFILE_RESULT), where everything that is not a net or a dataset is printed (typically, fold metrics and final avg metrics, matching the console output), stays open in it
+
+        static std::string makeNetworkText( const NeuralWeb* net, uint64_t options ); //main net file: structure and weights (trained) or signs (untrained)
+        static std::string makeActivationText( const NeuralWeb* net ); //scales file of a trained net
+        static std::string makeMetricsText( const NeuralWeb* net ); //metrics file of a trained net
+        static std::string makeNetworkBinary( const NeuralWeb* net ); //binary trained net file (Parser::NetFileHeader)
+        std::string makeDatasetHeader( uint64_t options ) const; //header line of a dataset file. Used by printDataset() and printDatasetHeader()
+        uint64_t writeDatasetRows( const std::string& fileName, const Dataset& correctDataset, const Dataset& predictedDataset, uint64_t options, double outputLBound, double outputUBound, double classThreshold, bool bFirstRow ) const; //format the rows that pass the filter in parallel (batches of EMITTER_FORMAT_BATCH_ROWS) and queue them in order. Returns the number of rows queued
+        void appendDatasetRow( std::string& buffer, const Dataset& correctDataset, const Dataset& predictedDataset, uint d, uint64_t options, double classThreshold ) const; //text row (after a line break) or binary record of instance d
 };
 
 #endif //EMITTER_HPP
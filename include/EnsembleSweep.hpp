@@ -0,0 +1,70 @@
+#ifndef ENSEMBLE_SWEEP_HPP
+#define ENSEMBLE_SWEEP_HPP
+
+#include "defines.hpp"
+#include "Parser.hpp" //Params constructor
+#include "NeuralWebEnsemble.hpp" //const NeuralWebEnsemble* ensemble, EnsembleParams
+#include "MemberPredictions.hpp" //sweep()
+#include "DatasetBase.hpp" //selection and test sets
+#include "Metrics.hpp" //Result metrics
+
+#include <vector> //results, member weights
+#include <string> //makeSummary()
+
+
+///what-if tuning of an ensemble: its metrics for every member selection criterion, every threshold that changes the members and both weighting modes, plus a greedy forward selection of members.
+///Everything comes from the member predictions of a selection set and a test set (MemberPredictions), made once: each setting costs a weighted average and a pass over the metrics instead of evaluating every net again
+class EnsembleSweep
+{
+    public:
+        ///sweep params
+        struct Params
+        {
+            uint greedySteps; //maximum number of members added (repetitions allowed) by the greedy selection. 0 = no greedy selection
+            int greedyCriterion; //metric optimized in the selection set by the greedy selection and used for choosing the best setting: the ensemble criterion (lossW if none)
+
+            Params( const Parser& parser ) : greedySteps( parser.getUintParam( "sweepGreedySteps" ) )
+            , greedyCriterion( parser.getIntParam( "ensembleCriterion" ) == NO_METRIC ? DEFAULT_ENSEMBLE_QUALITY_CRITERION : parser.getIntParam( "ensembleCriterion" ) ) {;}
+        };
+
+        ///an ensemble setting and its metrics
+        struct Result
+        {
+            NeuralWebEnsemble::EnsembleParams ensembleParams; //criterion, threshold and weighting of the setting. Not used by greedy results
+            bool bGreedy; //whether the members were chosen by greedy selection
+            std::vector<double> memberWeights; //weight of each member (number of times chosen for greedy results)
+            uint memberNum; //members with weight > 0
+            Metrics selectionMetrics; //metrics in the selection set
+            Metrics testMetrics; //metrics in the test set
+
+            Result( const NeuralWebEnsemble::EnsembleParams& ensembleParams, bool bGreedy = false ) : ensembleParams(ensembleParams), bGreedy(bGreedy), memberNum(0), selectionMetrics(0.0), testMetrics(0.0) {;}
+        };
+
+        EnsembleSweep( const Parser& parser, const NeuralWebEnsemble* ensemble ) : params(parser), ensemble(ensemble), bestIndex(0) {;}
+        virtual ~EnsembleSweep() {}
+
+    //---get
+        inline const Params& getParams() const { return params; }
+        inline const std::vector<Result>& getResults() const { return results; } //grid settings (no criterion first, then each criterion by threshold and weighting), then the greedy selection
+        inline uint getBestIndex() const { return bestIndex; } //best grid setting by greedyCriterion in the selection set
+
+    //---API
+        //evaluate the grid settings in parallel and make the greedy selection. Member predictions of each set in the order of the ensemble members
+        void sweep( const MemberPredictions& selectionPredictions, const DatasetBase& selectionSet, const MemberPredictions& testPredictions, const DatasetBase& testSet );
+        std::string makeSummary() const; //best grid setting and greedy selection vs the current ensemble params. For the summary file
+
+
+    private:
+        Params params;
+        const NeuralWebEnsemble* ensemble; //members, their saved metrics and the metric calculation
+        std::vector<Result> results;
+        uint bestIndex;
+
+        void makeGrid(); //a result for each setting with members: no criterion and, for each criterion, the saved member values as thresholds (every different set of members) weighted and not
+        void evaluate( Result& result, const MemberPredictions& selectionPredictions, const DatasetBase& selectionSet, const MemberPredictions& testPredictions, const DatasetBase& testSet ) const; //metrics of the result member weights in both sets
+        void greedySelection( const MemberPredictions& selectionPredictions, const DatasetBase& selectionSet, const MemberPredictions& testPredictions, const DatasetBase& testSet ); //add the member that improves greedyCriterion the most in the selection set until none does or greedySteps are made
+        static inline bool bBetter( double value, double reference, int criterion ) { return criterion < METRIC_LOSS_NUM ? value < reference : value > reference; } //losses are better when lower, accuracies when higher
+        static std::string makeResultText( const Result& result, int criterion ); //setting, members and criterion metric of both sets
+};
+
+#endif //ENSEMBLE_SWEEP_HPP
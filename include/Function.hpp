@@ -29,6 +29,12 @@ class FunctionBase
         inline void setParams( const std::vector<double>& xParams ) { params = xParams; }
         //API
         virtual double calculate( const std::vector<double>& input ) = 0;
+        //bounds of the output when the input is in [ lInput, uInput ]. Valid for monotonic non-decreasing functions (all the current ones). Non-monotonic functions must override it
+        virtual void calculateBounds( double lInput, double uInput, double& lOutput, double& uOutput ) { lOutput = calculate( { lInput } ); uOutput = calculate( { uInput } ); }
+        //apply the function in place to valueNum single-input values. Same results as calculate(). Used by NetPlan for a node over a block of instances. Functions override it with a plain loop
+        virtual void calculateBatch( double* values, uint valueNum ) { for( uint v = 0; v < valueNum; v++ ) values[v] = calculate( { values[v] } ); }
+        //derivative of the function at valueNum single-input values, from the outputs calculated for them (so the inputs are not needed). Used by NetPlan for the reverse sweep of the attributions
+        virtual void derivativeBatch( const double* outputs, double* derivatives, uint valueNum ) = 0;
 
     protected:
         std::vector<double> params; //meaning depends on the specific function. SatExponential and sigmoid have no params
@@ -44,6 +50,8 @@ class SatExponential : public FunctionBase //saturating exponential with formula
         virtual ~SatExponential() {};
 
         double calculate( const std::vector<double>& input ) override { return input[0] > 0.0 ? 1.0 - std::exp( - input[0] ) : 0.0; }
+        void calculateBatch( double* values, uint valueNum ) override { for( uint v = 0; v < valueNum; v++ ) values[v] = values[v] > 0.0 ? 1.0 - std::exp( - values[v] ) : 0.0; }
+        void derivativeBatch( const double* outputs, double* derivatives, uint valueNum ) override { for( uint v = 0; v < valueNum; v++ ) derivatives[v] = outputs[v] > 0.0 ? 1.0 - outputs[v] : 0.0; } //exp(-x) = 1 - y if x > 0
 };
 
 
@@ -55,6 +63,8 @@ class Sigmoid : public FunctionBase
         virtual ~Sigmoid() {};
 
         double calculate( const std::vector<double>& input ) override { return 1.0 / ( 1.0 + std::exp( - input[0] ) ); }
+        void calculateBatch( double* values, uint valueNum ) override { for( uint v = 0; v < valueNum; v++ ) values[v] = 1.0 / ( 1.0 + std::exp( - values[v] ) ); }
+        void derivativeBatch( const double* outputs, double* derivatives, uint valueNum ) override { for( uint v = 0; v < valueNum; v++ ) derivatives[v] = outputs[v] * ( 1.0 - outputs[v] ); }
 };
 
 #endif //FUNCTION_HPP
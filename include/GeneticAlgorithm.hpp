@@ -69,8 +69,8 @@ class GeneticAlgorithm
     
     //---API
         //train for a given number of generations with the given instances
-        void train( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint generationNum = DEFAULT_GA_GENERATION_NUM, bool evaluateAll = DEFAULT_GA_EVALUATEALL );
-        void evaluateWholePopulation( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ); //update train metrics of all the nets in the population with the given instances
+        void train( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint generationNum = DEFAULT_GA_GENERATION_NUM, bool evaluateAll = DEFAULT_GA_EVALUATEALL );
+        void evaluateWholePopulation( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ); //update train metrics of all the nets in the population with the given instances
         
 
     private:
@@ -90,7 +90,7 @@ class GeneticAlgorithm
 
     //---GA steps: called in order every generation by train()
         void selectParents(); //roulette selection of parents for cross into selectedParents vector
-        void mmxCross( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ); //crossover of both scales and weights to generate children vector
+        void mmxCross( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ); //crossover of both scales and weights to generate children vector
         void mmxCrossScales(); //MMX crossover of node scales using the selected parents. Includes mutation
         void mmxCrossWeights(); //MMX crossover of arc weights using the selected parents. Includes mutation
         void death(); //deterministic replacement of the worst nets in population vector by nets in children vector
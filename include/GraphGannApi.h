@@ -0,0 +1,68 @@
+#ifndef GRAPHGANN_API_H
+#define GRAPHGANN_API_H
+
+/*
+    C API of libgraphgann (make lib): trained nets and ensembles loaded from explicit files and predicted in-process, without the GraphANN executable or its text files.
+    The library writes nothing to the console and uses no default file names: every file is given by the caller and the error messages of a failed load are returned in its error buffer.
+    A model is used from one thread at a time (the batch calls are already parallel, with the threadNum of its options). The version only changes when a function changes: check gg_api_version() against GG_API_VERSION
+*/
+
+#include <stddef.h> /* size_t */
+
+#ifdef _WIN32
+    #ifdef GRAPHGANN_EXPORTS
+        #define GG_API __declspec(dllexport)
+    #else
+        #define GG_API __declspec(dllimport)
+    #endif
+#else
+    #define GG_API
+#endif
+
+#define GG_API_VERSION 1
+
+/* return codes */
+#define GG_OK 0
+#define GG_ERROR_ARGUMENT -1 /* null model or buffer, or no rows */
+#define GG_ERROR_STRIDE -2 /* row stride smaller than the number of inputs */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gg_model gg_model; /* a loaded net or ensemble */
+
+GG_API int gg_api_version( void );
+
+/*
+    load a model. optionsFile: options file of the run that trained the nets (activation function, class threshold, ensemble criterion and threshold, netIndex and netNum of the bundle, threadNum...), NULL = the default options.
+    referenceNetFile: untrained reference net (data/net.txt of the run). Null on failure, with the reason in error (errorSize bytes, may be NULL)
+*/
+GG_API gg_model* gg_load_net( const char* optionsFile, const char* referenceNetFile, const char* trainedNetFile, char* error, size_t errorSize ); /* a trained net saved in binary (netFormat 1 or 2) */
+GG_API gg_model* gg_load_ensemble( const char* optionsFile, const char* referenceNetFile, const char* bundleFile, char* error, size_t errorSize ); /* the ensemble bundle of netNum nets starting at netIndex (as in the options) */
+GG_API void gg_free( gg_model* model );
+
+/* model info */
+GG_API unsigned gg_input_count( const gg_model* model );
+GG_API const char* gg_input_name( const gg_model* model, unsigned index ); /* name of the input node of a column of the inputs. NULL if out of range */
+GG_API unsigned gg_member_count( const gg_model* model ); /* nets in the ensemble, 1 for a net */
+
+/*
+    predictions of rowNum instances. inputs: row-major, gg_input_count() values per row, consecutive rows rowStride values apart (rowStride >= gg_input_count()).
+    predictions: rowNum values written by the call. Same values as the GraphANN programs
+*/
+GG_API int gg_predict( const gg_model* model, const double* inputs, size_t rowNum, size_t rowStride, double* predictions );
+
+/*
+    quality metrics of the model for rowNum instances with known outputs. instanceWeights: rowNum weights (normalized by the call), NULL = all the same.
+    metrics: gg_metric_count() values written by the call, in the order of gg_metric_name(). predictions: rowNum values written by the call, may be NULL
+*/
+GG_API int gg_evaluate( const gg_model* model, const double* inputs, size_t rowNum, size_t rowStride, const double* outputs, const double* instanceWeights, double* metrics, double* predictions );
+GG_API unsigned gg_metric_count( void );
+GG_API const char* gg_metric_name( unsigned index ); /* loss, lossW, lossOutW, acc, accW, accOutW. NULL if out of range */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GRAPHGANN_API_H */
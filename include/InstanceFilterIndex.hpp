@@ -0,0 +1,60 @@
+#ifndef INSTANCE_FILTER_INDEX_HPP
+#define INSTANCE_FILTER_INDEX_HPP
+
+#include "defines.hpp"
+
+#include <vector> //masks, pack()
+#include <unordered_set> //equalSet
+#include "DataMatrix.hpp" //InputSpan in pack() and find()
+
+
+class DatasetBase;
+
+///bitset index of the instances of a filter dataset for removing instances equal to (hash set) or supersets of (minimal masks sorted by popcount) any indexed instance. Used by DatasetBase filters and by the combination programs to filter by chunks
+class InstanceFilterIndex
+{
+    public:
+        typedef std::vector<uint64_t> Bits; //one bit per input
+
+        ///hash for Bits in the equality set
+        struct BitsHash
+        {
+            inline size_t operator()( const Bits& bits ) const { uint64_t h = 1469598103934665603ULL; for( uint w = 0; w < bits.size(); w++ ) h = ( h ^ bits[w] ) * 1099511628211ULL; return static_cast<size_t>( h ); }
+        };
+
+    //---static
+        static Bits pack( const InputSpan& instance, uint inputValue = 1 ); //bit i = whether input i has inputValue (binarized at 0.5)
+        static inline uint popcount( const Bits& bits ) { uint count = 0; for( uint w = 0; w < bits.size(); w++ ) count += popcount( bits[w] ); return count; }
+        static inline uint popcount( uint64_t word )
+        {
+        #if defined( __GNUC__ ) || defined( __clang__ )
+            return __builtin_popcountll( word );
+        #else
+            uint count = 0; for( ; word; count++ ) word &= word - 1; return count;
+        #endif
+        }
+
+        InstanceFilterIndex() : bEqual(false), bSuperset(false), supersetInputValue(DEFAULT_DATASET_FILTER_INPUT) {;}
+        virtual ~InstanceFilterIndex() {}
+
+    //---get
+        inline bool getBEmpty() const { return ! bEqual && ! bSuperset; } //whether nothing is filtered
+
+    //---API
+        void indexEqual( const DatasetBase* filter ); //filter the instances equal (input only) to any in the filter dataset
+        void indexSupersets( const DatasetBase* filter, uint inputValue = DEFAULT_DATASET_FILTER_INPUT, uint classValue = DEFAULT_DATASET_FILTER_CLASS ); //filter the instances that are supersets of any in the filter dataset with the given classValue
+        bool findEqual( const InputSpan& instance ) const; //whether an indexed instance is equal to the given one
+        bool findSubset( const InputSpan& instance ) const; //whether an indexed instance is a subset of the given one (the given one has inputValue in all its inputValue inputs)
+        inline bool find( const InputSpan& instance ) const { return findEqual( instance ) || findSubset( instance ); } //whether the instance must be filtered
+
+
+    private:
+        bool bEqual; //whether indexEqual() was called
+        bool bSuperset; //whether indexSupersets() was called
+        std::unordered_set<Bits, BitsHash> equalSet; //packed inputs of the filter instances
+        uint supersetInputValue; //input value that defines the superset relation
+        std::vector<Bits> supersetMasks; //minimal masks (no one contains another) of the filter instances with the filter class, sorted by popcount
+        std::vector<uint> supersetPopcounts; //popcount of each mask, same order
+};
+
+#endif //INSTANCE_FILTER_INDEX_HPP
@@ -0,0 +1,86 @@
+#ifndef KNOCKOUT_SCREEN_HPP
+#define KNOCKOUT_SCREEN_HPP
+
+#include "defines.hpp"
+#include "Parser.hpp" //Params constructor
+#include "NeuralWeb.hpp" //const NeuralWeb* referenceNet, node and arc names
+#include "NeuralWebBase.hpp" //const NeuralWebBase* evaluator
+#include "NetPlan.hpp" //const NetPlan* plan, knockouts
+#include "DatasetBase.hpp" //screened dataset
+#include "Metrics.hpp" //Result metrics
+#include "MetricsKernel.hpp" //KnockoutSums metric sums
+
+#include <vector> //results, sums
+#include <string> //names, makeSummary()
+
+
+///in silico knockout of the trained net or ensemble: each hidden node forced to 0 (a protein knocked out) and, optionally, each arc removed, in every member, over a dataset. Reports the shift of the predictions and the metrics of each knockout against the intact net.
+///The dataset goes by blocks of instances: the value of every node of the block is calculated once (baseline) with the compiled nets (NetPlan), and each knockout only recalculates the nodes downstream of it (its cone) from those cached values. Shifts and metrics are added up by blocks, so only the values of a block per thread are kept.
+///The knockouts (and the blocks, if there are fewer knockouts than threads) are screened in parallel
+class KnockoutScreen
+{
+    public:
+        ///screening params
+        struct Params
+        {
+            bool bArcs; //whether the arcs are knocked out too, besides the nodes
+            double classThreshold; //for the class flips
+
+            Params( const Parser& parser ) : bArcs( parser.getIntParam( "knockoutArcs" ) == 1 ), classThreshold( parser.getRealParam( "classThreshold" ) ) {;}
+        };
+
+        ///a knockout and its effect over the dataset
+        struct Result
+        {
+            std::string name; //node name, or "parent -> child" for an arc
+            bool bArc;
+            uint coneSize; //nodes recalculated: the knocked one and those downstream of it
+            double meanShift; //mean of knocked - baseline prediction over the instances
+            double meanAbsShift; //mean of | knocked - baseline |
+            double maxAbsShift;
+            uint flipNum; //instances whose predicted class (classThreshold) changes
+            Metrics metrics; //metrics of the knocked predictions
+
+            Result() : bArc(false), coneSize(0), meanShift(0.0), meanAbsShift(0.0), maxAbsShift(0.0), flipNum(0), metrics(0.0) {;}
+        };
+
+        KnockoutScreen( const Parser& parser, const NetPlan* plan, const NeuralWeb* referenceNet, const NeuralWebBase* evaluator ) : params(parser), plan(plan), referenceNet(referenceNet), evaluator(evaluator), baselineMetrics(0.0), rowNum(0), seconds(0.0) {;}
+        virtual ~KnockoutScreen() {}
+
+    //---get
+        inline const Params& getParams() const { return params; }
+        inline const std::vector<Result>& getResults() const { return results; } //by mean absolute shift, the largest first
+        inline const Metrics& getBaselineMetrics() const { return baselineMetrics; }
+
+    //---API
+        bool screen( const DatasetBase& dataset ); //knock out every hidden node (and arc) over the dataset. False if the nets are not compiled (plan not valid)
+        std::string makeSummary() const; //knockouts, time and the ones with the largest shifts. For the summary file
+
+
+    private:
+        Params params;
+        const NetPlan* plan; //compiled members: cached values and cone recalculation
+        const NeuralWeb* referenceNet; //node and arc names
+        const NeuralWebBase* evaluator; //metrics calculation of the net or ensemble
+        std::vector<Result> results;
+        Metrics baselineMetrics; //metrics of the intact net
+        uint rowNum; //instances screened
+        double seconds;
+
+        ///sums of a knockout over a range of blocks, merged into its Result
+        struct KnockoutSums
+        {
+            double shiftSum;
+            double absShiftSum;
+            double maxAbsShift;
+            uint flipNum;
+            MetricsKernelBase::Sums metricSums;
+
+            KnockoutSums() : shiftSum(0.0), absShiftSum(0.0), maxAbsShift(0.0), flipNum(0) {;}
+        };
+
+        std::vector<NetPlan::Knockout> makeKnockouts() const; //hidden nodes (not the output) and, if bArcs, the arcs with a parent (not the biases), in plan order
+        void addBlock( KnockoutSums& sums, const double* predictions, const double* baseline, uint first, uint blockRowNum, const DatasetBase& dataset ) const; //add the shifts, class flips and metric sums of the predictions of a knockout for the block of instances starting at first
+};
+
+#endif //KNOCKOUT_SCREEN_HPP
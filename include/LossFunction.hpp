@@ -2,33 +2,74 @@
 #define LOSS_FUNCTION_HPP
 
 #include "defines.hpp"
+#include "MetricsKernel.hpp" //makeMetricsKernel()
 
-#include <math.h> //std::log (cross entropy)
+#include <algorithm> //std::min, std::max in CrossEntropy
+#include <cstdint> //uint64_t in log()
+#include <memory> //std::make_shared in makeMetricsKernel()
 
 
 ///abstract base class for deriving custom loss functions
 class LossFunctionBase
 {
     public:
+    //---static
+        //natural log of a positive normal number without calls or branches, so loops that use it vectorize. Same reduction and polynomial as the C library (fdlibm), within 1 ulp of std::log
+        static inline double log( double x )
+        {
+            const double ln2Hi = 6.93147180369123816490e-01, ln2Lo = 1.90821492927058770002e-10;
+            const double lg1 = 6.666666666666735130e-01, lg2 = 3.999999999940941908e-01, lg3 = 2.857142874366239149e-01, lg4 = 2.222219843214978396e-01, lg5 = 1.818357216161805012e-01, lg6 = 1.531383769920937332e-01, lg7 = 1.479819860511658591e-01;
+            union { double value; uint64_t bits; } xBits = { x }, zBits, kBits; //bit casts through unions instead of std::memcpy: with a copy through memory GCC does not vectorize loops that choose x (clamps)
+            uint64_t offset = xBits.bits - 0x3fe6a09e667f3bcdULL; //x = 2^k * z with z in [ sqrt(2)/2, sqrt(2) )
+            zBits.bits = xBits.bits - ( offset & 0xfff0000000000000ULL );
+            kBits.bits = ( ( offset + 0x8000000000000000ULL ) >> 52 ) | 0x4330000000000000ULL; //2^52 + k + 2048 as a double (no signed shift or integer conversion: SSE2 has neither for 64 bits)
+            double z = zBits.value;
+            double kBiased = kBits.value;
+            double k = kBiased - 4503599627372544.0; //- ( 2^52 + 2048 )
+            double f = z - 1.0;
+            double s = f / ( 2.0 + f );
+            double s2 = s * s;
+            double s4 = s2 * s2;
+            double r = s2 * ( lg1 + s4 * ( lg3 + s4 * ( lg5 + s4 * lg7 ) ) ) + s4 * ( lg2 + s4 * ( lg4 + s4 * lg6 ) );
+            double halfF2 = 0.5 * f * f;
+            return k * ln2Hi - ( ( halfF2 - ( s * ( halfF2 + r ) + k * ln2Lo ) ) - f );
+        }
+
         LossFunctionBase() {;}
         virtual ~LossFunctionBase() {}
 
         virtual double evaluate( double predictedOutput, double actualOutput ) = 0;
+        virtual MetricsKernelBaseSP makeMetricsKernel( double classThreshold, double outputWeight0 ) const = 0; //metrics calculation with this loss compiled in. Made once per net
 };
 
 ///binary cross-entropy
 class CrossEntropy : public LossFunctionBase
 {   
     public:
-        CrossEntropy() {;}
-        virtual ~CrossEntropy() {}
-
-        double evaluate( double predictedOutput, double actualOutput ) override //safe version that avoids invalid logs by clamping the predicted output to [ NET_LOSS_CLAMP_E, 1 - NET_LOSS_CLAMP_E ]
+        //safe version that avoids invalid logs by clamping the predicted output to [ NET_LOSS_CLAMP_E, 1 - NET_LOSS_CLAMP_E ]
+        static inline double calculate( double predictedOutput, double actualOutput )
         { 
-            if( predictedOutput == actualOutput ) return 0.0;
             double clampedPredictedOutput = std::max( std::min( predictedOutput, 1.0 - NET_LOSS_CLAMP_E ), NET_LOSS_CLAMP_E );
-            return - ( actualOutput * std::log( clampedPredictedOutput ) + ( 1.0 - actualOutput ) * std::log( 1.0 - clampedPredictedOutput ) ); 
+            double loss = - ( actualOutput * log( clampedPredictedOutput ) + ( 1.0 - actualOutput ) * log( 1.0 - clampedPredictedOutput ) );
+            return predictedOutput == actualOutput ? 0.0 : loss;
         }
+
+        //calculate() of num instances for MetricsKernel, the same values. One step per loop: GCC does not if-convert a clamp or a choice made around the floating point operations of the log, so each loop has either the choices or the arithmetic and vectorizes
+        static inline void calculateBlock( const double* predictedOutputs, const double* actualOutputs, double* losses, uint num )
+        {
+            for( uint i = 0; i < num; i++ )
+                losses[i] = std::max( std::min( predictedOutputs[i], 1.0 - NET_LOSS_CLAMP_E ), NET_LOSS_CLAMP_E );
+            for( uint i = 0; i < num; i++ )
+                losses[i] = - ( actualOutputs[i] * log( losses[i] ) + ( 1.0 - actualOutputs[i] ) * log( 1.0 - losses[i] ) );
+            for( uint i = 0; i < num; i++ )
+                losses[i] = predictedOutputs[i] == actualOutputs[i] ? 0.0 : losses[i];
+        }
+
+        CrossEntropy() {;}
+        virtual ~CrossEntropy() {}
+
+        double evaluate( double predictedOutput, double actualOutput ) override { return calculate( predictedOutput, actualOutput ); }
+        MetricsKernelBaseSP makeMetricsKernel( double classThreshold, double outputWeight0 ) const override { return std::make_shared<const MetricsKernel<CrossEntropy>>( classThreshold, outputWeight0 ); }
 };
 
 #endif //LOSS_FUNCTION_HPP
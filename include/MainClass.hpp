@@ -10,6 +10,7 @@
 #include "MultiGa.hpp" //MultiGa* multiGa
 #include "Parser.hpp" //Parser parser, constructor
 #include "Emitter.hpp" //Emitter emitter
+#include "NeuralWebEnsemble.hpp" //loadEnsemble()
 
 #include <memory> //MultiGaSP multiGa, NeuralWebSP net, NeuralWebSP bestNet, std::vector<DatasetSP> partialDatasets, std::vector<DatasetSP> generatedDatasets
 
@@ -48,7 +49,7 @@ class MainClass
 
     //---API
         //programs
-        inline void runProgram( uint programIndex ) { if( programIndex < programs.size() ) { ( this->*programs[ programIndex ] )(); std::cout << "program finished ok\n"; } else std::cout << "Error: unknown program\n"; } //run a program by id 
+        inline void runProgram( uint programIndex ) { if( programIndex < programs.size() ) { ( this->*programs[ programIndex ] )(); emitter.flush(); std::cout << "program finished ok\n"; } else std::cout << "Error: unknown program\n"; } //run a program by id. All its output is in the files when it finishes 
         void progTrainOnly(); //trains one net usign a validation fraction for early termination and the rest of the dataset for training
         void progKFold(); //makes stratified k-fold with the whole dataset using the test part for validation (early termination)
         void progKFoldFair(); //same as progKFold but previously separating a fraction for fair test. This fraction is used for nothing but printing its metrics
@@ -56,18 +57,35 @@ class MainClass
         void progTrainAndSaveNets(); //train n nets by progTrainOnly and save them for future ensemble
         
         void progEvaluateEnsemble(); //load previously trained net and evaluate avg individual vs ensemble performance in fair test set
-        void progPredictOutputsEnsemble(); //uses nets saved in progTrainAndSaveNets in a weighted ensemble and the dataset generated with progMakeInputCombinations to predict the dataset outputs
+        void progPredictOutputsEnsemble(); //uses nets saved in progTrainAndSaveNets in a weighted ensemble and the dataset generated with progMakeInputCombinations to predict the dataset outputs. Streamed by chunks (PredictionPipeline)
+        void progSearchCombinationsEnsemble(); //uses nets saved in progTrainAndSaveNets in a weighted ensemble to search the input combinations with predicted output in the thresholds (or the top K) by branch and bound
+        void progPredictCombinationsStream(); //same as progPredictOutputsEnsemble but generating the input combinations by chunks instead of parsing them. Only one part (combisPartIndex) of the combinations
+        void progMergePredictionParts(); //merge the prediction parts made by progPredictCombinationsStream into the file progPredictOutputsEnsemble would make
+        void progConvertPredictions(); //write the text files with all the columns from the binary prediction files made by the combination programs with predictionFormat = 2
+        void progSweepEnsemble(); //evaluate the saved nets once and write the ensemble metrics of every criterion, threshold and weighting plus a greedy selection of members, so the ensemble params are tuned without evaluating again
+        void progServeEnsemble(); //load the saved nets once and answer prediction requests from other processes over a local socket (PredictionServer) until a client sends shutdown
+        void progKnockoutScreen(); //knock out each hidden node (and arc) of the saved nets in turn and write the shift of the predictions and metrics over the dataset (KnockoutScreen)
+        void progAttribution(); //contribution of every node and arc of the saved nets to the prediction of every instance of the dataset in a forward and a reverse sweep (NodeAttribution)
         
         void progSplitDataset(); //save train and test dataset splits following a k-fold
         void progMakeInputCombinations(); //save a dataset with all the posible input combinations and same output. For prediction in a future run
+        void progConvertDataset(); //save the dataset and its k splits (those made by progSplitDataset) as binary files, which are mapped instead of parsed when datasetFormat = 1
         
       
         //basic
-        void init(); //initialize: load reference net, set headers, load base dataset, weight the instances and initialize members
-        inline void run() { init(); runProgram( parser.getIntParam( "program" ) ); } //initialize + run program
-        NeuralWeb* loadTrainedNet( uint netIndex ); //load a trained net in a safe way: transferring the trained scales and weights to a copy of the reference net
+        bool init(); //initialize: load reference net, set headers, load base dataset, weight the instances and initialize members. False if the reference net cannot be loaded
+        inline void run() { if( init() ) runProgram( parser.getIntParam( "program" ) ); } //initialize + run program
+        bool loadReferenceNet( const std::string& fileName ); //parse an untrained net into net. False if the file is missing or malformed or the graph has cycles (reported)
+        inline NeuralWeb* loadTrainedNet( uint netIndex ) { return loadTrainedNet( netIndex, parser ); } //load a trained net in a safe way: transferring the trained scales and weights to a copy of the reference net. Null if the net files cannot be parsed (reported)
+        NeuralWeb* loadTrainedNet( uint netIndex, Parser& netParser ) const; //same, parsing with the given parser (one per thread when loading in parallel)
+        bool loadEnsemble( NeuralWebEnsemble& ensemble ); //add the netNum trained nets starting at netIndex to the ensemble. From the ensemble bundle if up to date, else from the net files in parallel (then the bundle is saved). False if a net cannot be loaded
         void trainNet( uint datasetIndex = DEFAULT_MAINC_DATASET, bool bMakeValSplit = DEFAULT_DATASET_TRAIN_VALSPLIT ); //trains a net with multiGA with the given dataset. It can make several trials while the resulting nets do not fulfil the quality requirements
         void printMetrics( uint datasetIndex = DEFAULT_MAINC_DATASET, uint fairDatasetIndex = DEFAULT_MAINC_DATASET_FAIR, uint netIndex = 0, bool bEnsemble = false, const std::string& sufix = "" ); //save metrics and (optional) net and predictions for train, val and (depending on the program) test sets
+        bool loadDataset( const std::string& fileName ); //parse a dataset or split file (text file name) in the datasetFormat. A missing binary file is made from the text one
+        bool saveDataset( const Dataset& datasetToSave, uint64_t options, const std::string& fileName ); //print a dataset or split file (text file name) in the datasetFormat
+        inline uint64_t makePredictionOptions( uint64_t options ) const { return options | ( parser.getIntParam( "predictionFormat" ) == PREDICTION_FORMAT_COMPACT ? FLAG_DATA_COMPACT : FLAG_NULL ) | ( parser.getIntParam( "predictionFormat" ) == PREDICTION_FORMAT_BINARY ? FLAG_DATA_BINARY : FLAG_NULL ); } //add the flags of the predictionFormat to the options of a combination prediction file
+        inline std::string makePredictionFileName( const std::string& fileName ) const { return parser.getIntParam( "predictionFormat" ) == PREDICTION_FORMAT_BINARY ? MAKE_BINARY_FILENAME( fileName ) : fileName; } //name of a combination prediction file (text file name) in the predictionFormat
+        InstanceFilterIndex makeCombinationsFilter() const; //index of the base dataset for filtering input combinations (or chunks of them) according to combisFilterMode
 
         
 
@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include "defines.hpp"
+
+#include <string> //fileName
+#include <cstddef> //size_t
+#include <cstdint> //int64_t
+#include <ostream> //open() messages
+
+
+///read-only memory mapping of a whole file (mmap on POSIX, file mapping on Windows). The pages are loaded by the OS when first read, so opening is instant regardless of the file size
+class MappedFile
+{
+    public:
+    //---static
+        static int64_t getModificationTime( const std::string& fileName ); //nanoseconds since the epoch of the last modification (as precise as the file system). -1 if the file does not exist
+
+        MappedFile() : data(nullptr), size(0), fileHandle(nullptr), mappingHandle(nullptr) {}
+        virtual ~MappedFile() { close(); }
+        MappedFile( const MappedFile& ) = delete; //the mapping is owned, share it with a shared_ptr
+        MappedFile& operator=( const MappedFile& ) = delete;
+
+    //---get
+        inline const char* getData() const { return data; }
+        inline size_t getSize() const { return size; }
+        inline bool getBOpen() const { return data != nullptr || fileHandle != nullptr; }
+
+    //---API
+        bool open( const std::string& fileName, std::ostream& messages = std::cout ); //map the file. False if it cannot be opened or mapped (reported to messages)
+        void close(); //unmap. Pointers to the data are no longer valid
+
+
+    private:
+        const char* data; //first byte of the file. Null if empty or not open
+        size_t size; //file size in bytes
+        void* fileHandle; //platform file handle (file descriptor + 1 on POSIX). Null if not open
+        void* mappingHandle; //platform mapping handle (Windows only)
+};
+
+#endif //MAPPED_FILE_HPP
@@ -0,0 +1,33 @@
+#ifndef MEMBER_PREDICTIONS_HPP
+#define MEMBER_PREDICTIONS_HPP
+
+#include "defines.hpp"
+
+#include <vector> //predictions
+
+
+///predictions of every member of an ensemble for every instance of a set, [ member ][ instance ] in a single block (NeuralWebEnsemble::predictMembers()).
+///Made once per set: the ensemble predictions for any member weights, the ensemble metrics and the metrics of each member come from it without predicting again
+class MemberPredictions
+{
+    public:
+        MemberPredictions( uint memberNum = 0, uint instanceNum = 0 ) : memberNum(memberNum), instanceNum(instanceNum), predictions( static_cast<size_t>( memberNum ) * instanceNum, 0.0 ) {}
+
+    //---get
+        inline uint getMemberNum() const { return memberNum; }
+        inline uint getInstanceNum() const { return instanceNum; }
+        inline const double* getMember( uint member ) const { return predictions.data() + static_cast<size_t>( member ) * instanceNum; } //predictions of a member for all the instances
+        inline double* getMemberEditable( uint member ) { return predictions.data() + static_cast<size_t>( member ) * instanceNum; }
+        inline double get( uint member, uint instance ) const { return getMember( member )[instance]; }
+
+    //---API
+        std::vector<double> combine( const std::vector<double>& memberWeights ) const; //weighted average of the member predictions for each instance, -1 if no member has weight > 0. Same values as NeuralWebEnsemble::predict() with those weights
+
+
+    private:
+        uint memberNum;
+        uint instanceNum;
+        std::vector<double> predictions; //[ member ][ instance ]
+};
+
+#endif //MEMBER_PREDICTIONS_HPP
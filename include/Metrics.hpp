@@ -17,6 +17,7 @@ struct Metrics
     inline Metrics( double iniValue = INI_NET_METRIC, const NeuralWebBase* net = nullptr ) : net(net), members(METRIC_NUM, iniValue ), fitness(iniValue) { ; } //init all members to the same value
     inline Metrics( const std::vector<double>& values, const NeuralWebBase* net = nullptr ) : net(net), members(METRIC_NUM ), fitness(INI_NET_METRIC) { setMembers( values, values.size(), 0 ); } //init members to different values
     inline Metrics( const Metrics& originalMetrics ) : net( originalMetrics.net), members( originalMetrics.members), fitness(originalMetrics.fitness) { ; } //copy constructor
+    inline Metrics& operator=( const Metrics& originalMetrics ) { net = originalMetrics.net; members = originalMetrics.members; fitness = originalMetrics.fitness; return *this; } //copy assignment, declared with the copy constructor
 
     virtual ~Metrics() {}
 
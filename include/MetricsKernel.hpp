@@ -0,0 +1,120 @@
+#ifndef METRICS_KERNEL_HPP
+#define METRICS_KERNEL_HPP
+
+#include "defines.hpp"
+#include "Metrics.hpp" //calculate()
+
+#include <algorithm> //std::min
+
+
+///calculation of the quality metrics of a set of predictions, made once per net from its loss function (LossFunctionBase::makeMetricsKernel()) with the params it needs.
+///A single virtual call per set: the loss is chosen when the kernel is made, not for every instance. The metrics are sums, so a set can also be added up by parts (accumulate()) and the parts merged
+class MetricsKernelBase
+{
+    public:
+        enum { SUM_LOSS, SUM_LOSS_W, SUM_LOSS_OUTW, SUM_ACC, SUM_ACC_W, SUM_ACC_OUTW, SUM_OUTPUT_WEIGHT, SUM_NUM }; //partial sums
+
+        ///lane sums of a part of the instances, made by accumulate(). The parts of a set are merged in any order and finish() makes their metrics
+        struct Sums
+        {
+            double values[SUM_NUM][NET_METRICS_LANES];
+            uint instanceNum;
+
+            Sums() : values(), instanceNum(0) {}
+            inline void merge( const Sums& sums ) { for( uint s = 0; s < SUM_NUM; s++ ) { for( uint l = 0; l < NET_METRICS_LANES; l++ ) values[s][l] += sums.values[s][l]; } instanceNum += sums.instanceNum; }
+        };
+
+        MetricsKernelBase( double classThreshold, double outputWeight0 ) : classThreshold(classThreshold), outputWeight0(outputWeight0) {}
+        virtual ~MetricsKernelBase() {}
+
+    //---API
+        //the METRIC_NUM metrics of instanceNum predictions with the given outputs and instance weights (adding up to 1). Output-weighted metrics weight the instances by class only ( outputWeight0 and 1 - outputWeight0 ), normalized
+        inline Metrics calculate( const double* predictions, const double* outputs, const double* instanceWeights, uint instanceNum ) const { Sums sums; accumulate( sums, predictions, outputs, instanceWeights, instanceNum ); return finish( sums ); }
+        //add instanceNum predictions to the sums: instance i to lane i % NET_METRICS_LANES, so parts starting at multiples of NET_METRICS_LANES keep the lanes of the whole set
+        virtual void accumulate( Sums& sums, const double* predictions, const double* outputs, const double* instanceWeights, uint instanceNum ) const = 0;
+        //the metrics of the instances added up in the sums
+        Metrics finish( Sums sums ) const
+        {
+        //---lanes added pairwise
+            for( uint width = NET_METRICS_LANES / 2; width > 0; width /= 2 )
+            {
+                for( uint s = 0; s < SUM_NUM; s++ )
+                {
+                    for( uint l = 0; l < width; l++ )
+                        sums.values[s][l] += sums.values[s][ l + width ];
+                }
+            }
+
+            Metrics result( 0.0 );
+            if( sums.instanceNum == 0 )
+                return result;
+            double outputWeightTotal = sums.values[SUM_OUTPUT_WEIGHT][0] > 0.0 ? sums.values[SUM_OUTPUT_WEIGHT][0] : 1.0;
+            result.setMember( sums.values[SUM_LOSS][0] / sums.instanceNum, INDEX_METRIC_LOSS );
+            result.setMember( sums.values[SUM_LOSS_W][0], INDEX_METRIC_LOSS_W );
+            result.setMember( sums.values[SUM_LOSS_OUTW][0] / outputWeightTotal, INDEX_METRIC_LOSS_OUTW );
+            result.setMember( sums.values[SUM_ACC][0] / sums.instanceNum, INDEX_METRIC_ACC );
+            result.setMember( sums.values[SUM_ACC_W][0], INDEX_METRIC_ACC_W );
+            result.setMember( sums.values[SUM_ACC_OUTW][0] / outputWeightTotal, INDEX_METRIC_ACC_OUTW );
+            return result;
+        }
+
+    protected:
+        double classThreshold; //threshold for converting outputs and predictions into classes
+        double outputWeight0; //weight of the instances with output 0 in the output-weighted metrics (instanceWeightByOutput). 1 - outputWeight0 for output 1
+};
+
+
+///fused pass over the predictions for a loss known at compile time (Loss::calculateBlock(), inlined): loss, accuracy and their 3 weightings calculated by blocks of NET_METRICS_BLOCK instances in straight loops without branches, which the compiler vectorizes (-O3).
+///Every sum is split in NET_METRICS_LANES lanes added pairwise at the end: the result depends only on the order of the instances
+template<typename Loss>
+class MetricsKernel : public MetricsKernelBase
+{
+    public:
+        MetricsKernel( double classThreshold, double outputWeight0 ) : MetricsKernelBase( classThreshold, outputWeight0 ) {}
+        virtual ~MetricsKernel() {}
+
+        void accumulate( Sums& sums, const double* predictions, const double* outputs, const double* instanceWeights, uint instanceNum ) const override
+        {
+            double losses[NET_METRICS_BLOCK], hits[NET_METRICS_BLOCK], outputWeights[NET_METRICS_BLOCK], weights[NET_METRICS_BLOCK];
+            double outputWeight1 = 1.0 - outputWeight0;
+            for( uint first = 0; first < instanceNum; first += NET_METRICS_BLOCK )
+            {
+                uint blockNum = std::min<uint>( instanceNum - first, NET_METRICS_BLOCK );
+                const double* blockPredictions = predictions + first;
+                const double* blockOutputs = outputs + first;
+                Loss::calculateBlock( blockPredictions, blockOutputs, losses, blockNum );
+                for( uint i = 0; i < blockNum; i++ )
+                {
+                    hits[i] = ( blockPredictions[i] >= classThreshold ) == ( blockOutputs[i] >= classThreshold ) ? 1.0 : 0.0;
+                    outputWeights[i] = blockOutputs[i] >= classThreshold ? outputWeight1 : outputWeight0;
+                    weights[i] = instanceWeights[ first + i ];
+                }
+                uint laneNum = ( blockNum + NET_METRICS_LANES - 1 ) / NET_METRICS_LANES * NET_METRICS_LANES; //the last group of the last block is padded with 0s, which do not change the sums
+                for( uint i = blockNum; i < laneNum; i++ )
+                    losses[i] = hits[i] = outputWeights[i] = weights[i] = 0.0;
+                addBlock( sums.values, losses, hits, outputWeights, weights, laneNum );
+            }
+            sums.instanceNum += instanceNum;
+        }
+
+    private:
+        //add a block to the lane sums: instance i to lane i % NET_METRICS_LANES. num is a multiple of NET_METRICS_LANES
+        static inline void addBlock( double (&sums)[SUM_NUM][NET_METRICS_LANES], const double* losses, const double* hits, const double* outputWeights, const double* weights, uint num )
+        {
+            for( uint i = 0; i < num; i += NET_METRICS_LANES )
+            {
+                for( uint l = 0; l < NET_METRICS_LANES; l++ )
+                {
+                    sums[SUM_LOSS][l] += losses[ i + l ];
+                    sums[SUM_LOSS_W][l] += weights[ i + l ] * losses[ i + l ];
+                    sums[SUM_LOSS_OUTW][l] += outputWeights[ i + l ] * losses[ i + l ];
+                    sums[SUM_ACC][l] += hits[ i + l ];
+                    sums[SUM_ACC_W][l] += weights[ i + l ] * hits[ i + l ];
+                    sums[SUM_ACC_OUTW][l] += outputWeights[ i + l ] * hits[ i + l ];
+                    sums[SUM_OUTPUT_WEIGHT][l] += outputWeights[ i + l ];
+                }
+            }
+        }
+};
+
+#endif //METRICS_KERNEL_HPP
@@ -45,7 +45,7 @@ class MultiGa
     //---API
         void train( const Dataset* dataset, uint generationsPerMix = DEFAULT_MGA_GENERATIONS_PER_MIX, uint mixNum = DEFAULT_MGA_MIXNUM ); //train a given number of mix rounds with the given dataset (with training and val splits). No historical track
         void trainAndTrack( const Dataset* dataset, uint generationsPerMix = DEFAULT_MGA_GENERATIONS_PER_MIX, uint mixNum = DEFAULT_MGA_MIXNUM ); //same as train() but saving historical info in historicalTrack. Slower but required for further selection of the historical best net in val set
-        inline void evaluateWholePopulation( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ) { for( uint g = 0; g < gas.size(); g++ ) gas[g]->evaluateWholePopulation( inputs, outputs, instanceWeights ); }
+        inline void evaluateWholePopulation( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ) { for( uint g = 0; g < gas.size(); g++ ) gas[g]->evaluateWholePopulation( inputs, outputs, instanceWeights ); }
 
 
         
@@ -0,0 +1,89 @@
+#ifndef NET_PLAN_HPP
+#define NET_PLAN_HPP
+
+#include "defines.hpp"
+#include "Function.hpp" //FunctionBaseSP functions
+#include "DataMatrix.hpp" //dense inputs
+#include "SparseRows.hpp" //sparse inputs
+
+#include <vector> //terms, weights, scales
+
+
+class NeuralWeb;
+
+///forward pass of nets with the same topology (the members of an ensemble) compiled into flat arrays: the nodes that lead to the output in the order they are calculated, the parent of each term and the weights and scales of all the members side by side.
+///Predicts a block of instances with all the members in a single pass over the nodes, without recursion or state in the nodes, and returns the weighted average of the member predictions. Const, so batches are predicted in parallel
+class NetPlan
+{
+    public:
+        ///a node forced to 0, or an arc removed, in every member. Only the knocked node and the nodes downstream of it (its cone) change
+        struct Knockout
+        {
+            uint node; //calculated node knocked out, or child of the arc
+            int term; //term of the arc removed. -1 = the whole node is knocked out
+            std::vector<uint> cone; //calculated nodes to recalculate, in order: the knocked node and those that depend on it
+            std::vector<bool> bInCone; //whether each calculated node is in the cone
+
+            Knockout() : node(0), term(-1) {}
+        };
+
+        NetPlan() : bValid(false), inputNum(0), nodeNum(0), memberNum(0), outputSlot(0), totalWeight(0.0) {}
+        NetPlan( const std::vector<const NeuralWeb*>& nets, const std::vector<double>& netWeights ); //the nets with weight > 0 are the members. Not valid (getBValid()) if their topologies differ or have terms with several parents
+
+    //---get
+        inline bool getBValid() const { return bValid; }
+        inline uint getMemberNum() const { return memberNum; }
+        inline uint getInputNum() const { return inputNum; }
+        inline uint getNodeNum() const { return nodeNum; }
+        inline uint getNodeId( uint node ) const { return nodeIds[node]; } //id in the nets of a calculated node
+        inline bool getBOutput( uint node ) const { return inputNum + node == outputSlot; }
+        inline uint getTermNum() const { return termParents.size(); }
+        inline uint getTermBegin( uint node ) const { return termBegins[node]; } //first term of a calculated node. The terms of node n are [ getTermBegin( n ), getTermBegin( n + 1 ) )
+        inline int getTermParent( uint term ) const { return termParents[term]; } //slot of the parent of a term: input index or inputNum + calculated node index. -1 for biases
+        inline uint getTermArcId( uint term ) const { return termArcIds[term]; } //id in the nets of the arc of a term
+        inline size_t getValueNum( uint rowNum ) const { return ( inputNum + static_cast<size_t>( nodeNum ) * memberNum ) * rowNum; } //values of a block of rows
+
+    //---API
+        double predict( const InputSpan& input ) const; //weighted average of the member predictions. -1 if there are no members (same convention as NeuralWebEnsemble)
+        double predict( const SparseRow& input ) const;
+        void predictBatch( const DataMatrix& inputs, uint first, uint rowNum, double* outputs ) const; //predictions of the rows [ first, first + rowNum ) in parallel by blocks of NET_PLAN_BLOCK_ROWS
+        void predictBatch( const SparseRows& inputs, uint first, uint rowNum, double* outputs ) const;
+        void predictMembersBatch( const DataMatrix& inputs, uint first, uint rowNum, double* memberOutputs, size_t memberStride ) const; //prediction of each member instead of the average: memberOutputs[ member * memberStride + row - first ]. Same values as NeuralWeb::predict() of the member
+        //knockouts from cached values: calculateBlock() keeps the value of every node of every member for a block of rows, and predictKnockoutBlock() recalculates only the cone of a knockout from them
+        void calculateBlock( const DataMatrix& inputs, uint first, uint rowNum, double* values, double* outputs ) const; //load the rows [ first, first + rowNum ) (rowNum <= NET_PLAN_BLOCK_ROWS) and predict them. values: getValueNum( rowNum ), [ slot ][ row ] as in calculateBlock( values, rowNum )
+        Knockout makeKnockout( uint node, int term = -1 ) const; //knockout of a calculated node, or of a term of it (arc)
+        void predictKnockoutBlock( const double* values, double* knockedValues, uint rowNum, const Knockout& knockout, double* outputs ) const; //predictions of a block with a knockout. values: the block calculated by calculateBlock(), not changed. knockedValues: getValueNum( rowNum ) values, only the cone slots are written
+        //contribution of every slot and term to the prediction in a forward and a reverse sweep: gradient x activation (stepNum = 0), or gradient x change of activation added over stepNum steps from the all-0 input (path-integrated). All the members together, as they add up to the prediction
+        void attributeBlock( const DataMatrix& inputs, uint first, uint rowNum, uint stepNum, double* slotAttributions, double* termAttributions, double* outputs ) const; //rows [ first, first + rowNum ) (rowNum <= NET_PLAN_BLOCK_ROWS). slotAttributions: [ slot ][ row ] (inputs, then calculated nodes). termAttributions: [ term ][ row ], 0 for the biases. outputs: the predictions
+
+
+    private:
+        bool bValid; //whether the nets could be compiled
+        uint inputNum; //number of input nodes. Their values are the first slots, shared by all the members
+        uint nodeNum; //number of calculated nodes (those that lead to the output), parents before children
+        uint memberNum; //number of nets with weight > 0
+        uint outputSlot; //slot of the output node
+        std::vector<uint> termBegins; //first term of each calculated node, plus the end of the last one
+        std::vector<int> termParents; //slot of the parent of each term: input index (< inputNum) or inputNum + calculated node index. -1 for biases
+        std::vector<FunctionBaseSP> functions; //activation function of each calculated node
+        std::vector<uint> nodeIds; //id in the nets of each calculated node
+        std::vector<uint> termArcIds; //id in the nets of the arc of each term
+        std::vector<double> termWeights; //[ term ][ member ] arc weights
+        std::vector<double> nodeScales; //[ node ][ member ] node scales
+        std::vector<double> memberWeights; //weight of each member in the average
+        double totalWeight; //sum of the member weights, added in member order
+
+        inline double* slotValues( double* values, uint slot, uint member, uint rowNum ) const { return values + static_cast<size_t>( slot < inputNum ? slot : inputNum + ( slot - inputNum ) * memberNum + member ) * rowNum; } //values of a slot for a member in a block
+        void loadRow( const InputSpan& input, uint row, uint rowNum, double* values ) const; //write the input values of a row of the block in the input slots
+        void loadRow( const SparseRow& input, uint row, uint rowNum, double* values ) const;
+        inline const double* slotValues( const double* values, uint slot, uint member, uint rowNum ) const { return slotValues( const_cast<double*>( values ), slot, member, rowNum ); }
+        void calculateNode( uint node, uint member, const double* values, double* nodeValues, uint rowNum, const double* knockedValues = nullptr, const std::vector<bool>* bKnocked = nullptr, int skippedTerm = -1 ) const; //values of a calculated node for a member from the values of its parents, in knockedValues for the parents in bKnocked (knockouts). Without a term if skippedTerm >= 0
+        void calculateBlock( double* values, uint rowNum ) const; //calculate the nodes of every member. values = [ slot ][ row ]: the input slots loaded and room for the calculated ones ( [ node ][ member ][ row ] )
+        void averageMembers( const double* values, uint rowNum, double* outputs ) const; //weighted average of the member outputs in values
+        void loadBlock( const DataMatrix& inputs, uint first, uint rowNum, double* values, double inputScale = 1.0 ) const; //write the input values of the rows in the input slots, scaled (path-integrated attributions)
+        void addAttributions( const double* values, const double* previousValues, double* gradients, uint rowNum, double* slotAttributions, double* termAttributions ) const; //reverse sweep: gradient of the prediction with respect to every slot (gradients: getValueNum( rowNum )), times the values (previousValues null) or times their change from previousValues, added to the attributions
+        void predictBlock( double* values, uint rowNum, double* outputs ) const; //calculateBlock() and the weighted average of the member outputs
+        template<typename Rows> void predictRows( const Rows& inputs, uint first, uint rowNum, double* outputs, size_t memberStride = 0 ) const; //load and predict the rows by blocks, in parallel. The average in outputs, or each member output if memberStride > 0
+};
+
+#endif //NET_PLAN_HPP
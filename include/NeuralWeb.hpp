@@ -38,6 +38,9 @@ class NeuralWeb : public NeuralWebBase
         inline const std::vector<NodeSP>& getInputLayer() const { return inputLayer; }
         inline NodeSP getOutputLayer() const { return outputLayer; }
         std::vector<std::string> getHeader() const; //returns the names of input layer nodes in order. First element = output node name. Used for sorting inputs in the same order in the datasets
+        uint64_t getTopologyHash() const; //hash of the node names and the arcs (parent, child, sign). Nets with the same hash have the same parameter layout
+        inline uint getParamNum() const { uint paramNum = arcs.size(); for( uint n = 0; n < nodes.size(); n++ ) paramNum += nodes[n]->getScales().size(); return paramNum; } //number of values in the parameter vector
+        std::vector<double> getParamValues() const; //parameter vector: the arc weights in arc order followed by the node scales in node order
         //state
         inline bool getBSaved() const {return bSaved; }
 
@@ -52,6 +55,7 @@ class NeuralWeb : public NeuralWebBase
     //---API
         //structure
         void transferParams( const NeuralWeb* originalNeuralWeb ); //transfer the values of weights and scales from a net with identical structure. Used for copying from trained to untrained
+        void setParamValues( const double* paramValues ); //set the weights and scales from a parameter vector (getParamValues() layout) of a net with the same topology hash
         void findLayers(); //finds the input and output layer. Must be always called after adding all the arcs and nodes to a new net
         inline void resetNodes() const { for( uint n = 0; n < nodes.size(); n++ ) nodes[n]->setDone( false ); } //return all the nodes to the "no value yet" state. Must be called before every forward pass
         //params randomization
@@ -60,7 +64,10 @@ class NeuralWeb : public NeuralWebBase
         void normalizeWeights(); //make all the weights of a node's parent arcs add up to 1 in abs. Must be called after any change in weights: randomization, crossover or mutation
         inline void randomizeScales( PopulationCreator& popCreator ) { for( uint n = 0; n < nodes.size(); n++ ) nodes[n]->setScale( popCreator.sampleIniDistributionScales( n ) ); } //set all the node scales to random values. Used for population initialization
         //ml
-        double predict( const std::vector<std::vector<double>>& inputs, uint index ) const override; //predict output given the inputs for case number index
+        using NeuralWebBase::predict; //predict( inputs, index )
+        double predict( const InputSpan& input ) const override; //predict output given the inputs of a case
+        double predict( const SparseRow& input ) const override; //predict output given the index list of a case: the input layer is set to the default value and then the listed inputs
+        void predictBounds( const std::vector<double>& lInputs, const std::vector<double>& uInputs, double& lOutput, double& uOutput ) const override; //bound the output by interval propagation when the inputs are in the given intervals
         //modify structure
         void convertToFF( const std::vector<uint>& nodeNumPerLayer ); //converts the hidden part of the net into a fully-connected feed-forward one with the given number of layers and neurons (nodes) per layer. Input and output layers are kept.
         void swapInputLayer( RandomEngine& randomEngine ); //randomly swaps the nodes in the input layer. For checking the suitability of the chosen structure
@@ -2,12 +2,14 @@
 #define NEURAL_WEB_BASE_HPP
 
 #include "defines.hpp"
-#include "LossFunction.hpp" //LossFunctionBase* lossFunction;
+#include "LossFunction.hpp" //LossFunctionBase* lossFunction, metricsKernel
 #include "Metrics.hpp"
 #include "Parser.hpp" //constructor and Params' constructor
+#include "DataMatrix.hpp" //prediction and evaluation inputs
+#include "SparseRows.hpp" //prediction and evaluation inputs as index lists
 
 #include <vector> //std::vector<Metrics*> metricsReflection, std::vector<double*> membersReflection in Metrics, args of many methods
-#include <memory> //LossFunctionBaseSP lossFunction
+#include <memory> //LossFunctionBaseSP lossFunction, MetricsKernelBaseSP metricsKernel
 
 
 ///abstract base class for both trainable NeuralWeb and ensemble of NeuralWeb. Provides common interface for prediction and evaluation
@@ -18,14 +20,15 @@ class NeuralWebBase
         struct Params
         {
             double classThreshold; //threshold for converting real output into 0 or 1 class. Typically 0.5
+            double outputWeight0; //weight of the cases with output 0 in the output-weighted metrics (instanceWeightByOutput). 1 - outputWeight0 for output 1
 
-            Params( const Parser& parser ) : classThreshold( parser.getRealParam( "classThreshold" ) ) {;}
+            Params( const Parser& parser ) : classThreshold( parser.getRealParam( "classThreshold" ) ), outputWeight0( parser.getRealParam( "instanceWeightByOutput" ) ) {;}
         };
 
 
     //================================
         NeuralWebBase( const Parser& parser )
-        : params(parser), lossFunction( std::make_shared<CrossEntropy>() )
+        : params(parser), lossFunction( std::make_shared<CrossEntropy>() ), metricsKernel( lossFunction->makeMetricsKernel( params.classThreshold, params.outputWeight0 ) )
         , trainMetrics( INI_NET_METRIC ), testMetrics( INI_NET_METRIC )
         { trainMetrics.setNet(this); testMetrics.setNet(this); initReflection(); }
 
@@ -34,6 +37,7 @@ class NeuralWebBase
     //---get
         //fixed
         inline const Params& getParams() const { return params; }
+        inline const MetricsKernelBase& getMetricsKernel() const { return *metricsKernel; } //for metrics added up by parts of the instances
         //state
         inline const Metrics& getTrainMetrics() const { return trainMetrics; }
         inline const Metrics& getTestMetrics() const { return testMetrics; }
@@ -52,8 +56,18 @@ class NeuralWebBase
         inline void saveTestMetrics() { savedMetrics = testMetrics; }
 
     //---API
-        virtual double predict( const std::vector<std::vector<double>>& inputs, uint index ) const = 0; //predict output given the inputs for case number index. Pure virtual
-        double evaluateWeighted( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ); //update testMetrics by evaluationg with the given weighted instances and return loss
+        virtual double predict( const InputSpan& input ) const = 0; //predict output given the inputs of a case. Pure virtual
+        inline double predict( const DataMatrix& inputs, uint index ) const { return predict( inputs[index] ); } //predict output given the inputs for case number index
+        virtual double predict( const SparseRow& input ) const = 0; //same as predict( InputSpan ) from the index list, without expanding it. Pure virtual
+        inline double predict( const SparseRows& inputs, uint index ) const { return predict( inputs[index] ); }
+        virtual void predictBatch( const DataMatrix& inputs, uint first, uint rowNum, double* outputs ) const; //predictions of the rows [ first, first + rowNum ). One by one, unless overriden
+        virtual void predictBatch( const SparseRows& inputs, uint first, uint rowNum, double* outputs ) const;
+        //bound the output when every input is in [ lInputs[i], uInputs[i] ]. For pruning searches over partially known inputs. Pure virtual
+        virtual void predictBounds( const std::vector<double>& lInputs, const std::vector<double>& uInputs, double& lOutput, double& uOutput ) const = 0;
+        inline double evaluateWeighted( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ) { return evaluateRows( inputs, outputs, instanceWeights, setIndex ); } //update testMetrics by evaluationg with the given weighted instances and return loss
+        inline double evaluateWeighted( const SparseRows& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ) { return evaluateRows( inputs, outputs, instanceWeights, setIndex ); } //same from the index lists
+        double evaluatePredictions( const double* predictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ); //same as evaluateWeighted() from predictions already made for the instances
+        Metrics calculateMetrics( const double* predictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ) const; //metrics of predictions already made, without updating the net metrics. Const, so many sets of predictions are measured in parallel
         inline double calculateFitness() { return trainMetrics.calculateFitness(); } //calculate training fitness by using the trainMetrics
         inline void initReflection() { metricsReflection = { &trainMetrics, &testMetrics }; } //start  std::vector<Metrics*> metricsReflection
 
@@ -61,11 +75,15 @@ class NeuralWebBase
     //fixed
         Params params; //params that are common to both NeuralWeb and ensemble
         LossFunctionBaseSP lossFunction; //pointer to use polymorphism. Shared to allow for shallow copy
+        MetricsKernelBaseSP metricsKernel; //metrics calculation with the loss function compiled in. Shared to allow for shallow copy
     //state
         Metrics trainMetrics; //metrics used during training. Where fitness is calculated
         Metrics testMetrics; //metrics used for evaluation (either validation or fair test sets ) that are not taken into account during training
         Metrics savedMetrics; //evaluation metrics used for selecting and weighting nets by quality. Having a separate var allows for further testing without overwritting
         std::vector<Metrics*> metricsReflection; //access to train and test metrics via index
+
+    //evaluation
+        template<typename Rows> double evaluateRows( const Rows& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex ); //evaluateWeighted() for dense (DataMatrix) and sparse (SparseRows) inputs
 };
 
 #endif //NEURAL_WEB_BASE_HPP
@@ -5,9 +5,13 @@
 #include "Parser.hpp" //constructor
 #include "NeuralWebBase.hpp" //parent class
 #include "NeuralWeb.hpp" //memberNets
+#include "NetPlan.hpp" //plan
+#include "MemberPredictions.hpp" //predictMembers()
 
 #include <vector> //memberNets
-#include <memory> //std::vector<NeuralWebSP> memberNets
+#include <memory> //std::vector<NeuralWebSP> memberNets, std::shared_ptr<const NetPlan> plan
+#include <mutex> //planMutex
+#include <atomic> //publishedPlan
 
 
 ///ensemble of NeuralWeb with prediction and evaluation functionality
@@ -22,27 +26,49 @@ class NeuralWebEnsemble : public NeuralWebBase
             double qualityThreshold; //
 
             EnsembleParams( const Parser& parser) : bWeighted( parser.getIntParam("ensembleWeighted") ), qualityCriterion(parser.getIntParam( "ensembleCriterion" ) ), qualityThreshold( parser.getRealParam( "ensembleThreshold" ) ) {;}
+            EnsembleParams( bool bWeighted, int qualityCriterion, double qualityThreshold ) : bWeighted(bWeighted), qualityCriterion(qualityCriterion), qualityThreshold(qualityThreshold) {;} //for trying other criteria on the same members
         };
 
 
     //================================
-        NeuralWebEnsemble( const Parser& parser ) : NeuralWebBase::NeuralWebBase(parser), ensembleParams(parser) {;}
+        NeuralWebEnsemble( const Parser& parser ) : NeuralWebBase::NeuralWebBase(parser), ensembleParams(parser), publishedPlan(nullptr) {;}
+        NeuralWebEnsemble( const NeuralWebEnsemble& ) = delete; //owns the plan mutex
         virtual ~NeuralWebEnsemble() {}
 
     //---get
         inline const std::vector<NeuralWebSP>& getMemberNets() const { return memberNets; } 
+        inline const EnsembleParams& getEnsembleParams() const { return ensembleParams; }
+        std::vector<double> getMemberWeights( const EnsembleParams& xEnsembleParams ) const; //weight of each member with a criterion, 0 for those that do not fulfil it
+        inline std::vector<double> getMemberWeights() const { return getMemberWeights( ensembleParams ); }
 
     //---set
-        inline void setMemberNets( const std::vector<NeuralWebSP>& xMemberNets ) { memberNets = xMemberNets; }
-        inline void addMemberNet( NeuralWebSP newMemberNet ) { newMemberNet->saveTestMetrics(); memberNets.push_back( newMemberNet ); }
+        inline void setMemberNets( const std::vector<NeuralWebSP>& xMemberNets ) { memberNets = xMemberNets; resetPlan(); }
+        inline void addMemberNet( NeuralWebSP newMemberNet ) { newMemberNet->saveTestMetrics(); memberNets.push_back( newMemberNet ); resetPlan(); }
  
     //---API
-        double predict( const std::vector<std::vector<double>>& inputs, uint index ) const override; //predict output given the inputs for case number index
-        Metrics averageMetrics( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ); //calculate average metrics
+        using NeuralWebBase::predict; //predict( inputs, index )
+        double predict( const InputSpan& input ) const override; //predict output given the inputs of a case. With the plan of the members if they could be compiled
+        double predict( const SparseRow& input ) const override; //same from the index list of a case
+        void predictBatch( const DataMatrix& inputs, uint first, uint rowNum, double* outputs ) const override; //all the members over blocks of instances in parallel with the plan
+        void predictBatch( const SparseRows& inputs, uint first, uint rowNum, double* outputs ) const override;
+        void predictBounds( const std::vector<double>& lInputs, const std::vector<double>& uInputs, double& lOutput, double& uOutput ) const override; //weighted average of the member bounds
+        MemberPredictions predictMembers( const DataMatrix& inputs ) const; //prediction of every member for every instance, all the members in a single pass by blocks in parallel
+        inline std::vector<double> predictFromMembers( const MemberPredictions& memberPredictions ) const { return memberPredictions.combine( getMemberWeights() ); } //same as predictBatch() without predicting again
+        inline std::vector<double> predictFromMembers( const MemberPredictions& memberPredictions, const EnsembleParams& xEnsembleParams ) const { return memberPredictions.combine( getMemberWeights( xEnsembleParams ) ); } //with another criterion
+        Metrics averageMetrics( const MemberPredictions& memberPredictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ); //evaluate each member from its predictions and average their metrics
+        inline Metrics averageMetrics( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex = INDEX_SET_TRAIN ) { return averageMetrics( predictMembers( inputs ), outputs, instanceWeights, setIndex ); } //calculate average metrics
         
     private:
         EnsembleParams ensembleParams; //params that are exclusive of ensembles
         std::vector<NeuralWebSP> memberNets;
+        mutable std::shared_ptr<const NetPlan> plan; //members compiled with their weights. Made by the first prediction after the members change
+        mutable std::mutex planMutex; //guards making the plan
+        mutable std::atomic<const NetPlan*> publishedPlan; //plan once made, read without the lock by every prediction. Null until then
+
+        double memberWeight( uint memberIndex, const EnsembleParams& xEnsembleParams ) const; //weight of a member in the prediction according to the quality criterion. 0 if it does not fulfil the threshold
+        template<typename Row> double predictRow( const Row& input ) const; //weighted average of the member predictions for dense (InputSpan) and sparse (SparseRow) inputs, member by member. When the members cannot be compiled
+        const NetPlan* getPlan() const; //the plan of the current members, made if missing
+        inline void resetPlan() { publishedPlan.store( nullptr ); plan.reset(); } //members changed. Not while predicting
 };
 
 #endif //NEURAL_WEB_ENSEMBLE_HPP
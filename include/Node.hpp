@@ -20,12 +20,12 @@ class Node
         Node( uint id, const std::string& name, FunctionBase::FunctionType activationFunctionType, const std::vector<double>& activationFunctionParams = {} ) //creation constructor
         : id(id), name(name)
 		, scales( std::vector<double>( 1, INI_NODE_SCALE ) ), activationFunction( FunctionBase::createSubobject( activationFunctionType, activationFunctionParams ) )
-		, bTrainableScale(true), value(INI_NODE_VALUE), done(false) {;} //no parent and child links are created at this point. They are added afterwards
+		, bTrainableScale(true), value(INI_NODE_VALUE), lValue(INI_NODE_VALUE), uValue(INI_NODE_VALUE), done(false) {;} //no parent and child links are created at this point. They are added afterwards
 
         Node( const Node* originalNode ) //fake deep copy constructor
 		: id( originalNode->id ), name( originalNode->name )
 		, scales(originalNode->scales), activationFunction( FunctionBase::createSubobject( originalNode->activationFunction->getFunctionType(), originalNode->activationFunction->getParams() ) ) //shallow copy would be ok too
-        , bTrainableScale(originalNode->bTrainableScale), value(INI_NODE_VALUE), done(false) {;} //no parent and child links are copied at this point because the new aarcs and have to be created at NeuralWeb level before
+        , bTrainableScale(originalNode->bTrainableScale), value(INI_NODE_VALUE), lValue(INI_NODE_VALUE), uValue(INI_NODE_VALUE), done(false) {;} //no parent and child links are copied at this point because the new aarcs and have to be created at NeuralWeb level before
 
         virtual ~Node() {}
 
@@ -61,11 +61,13 @@ class Node
 
         inline void setBTrainableScale( double xTrainableScale ) { bTrainableScale = xTrainableScale; }
         inline void setValue( double xValue ) { value = xValue; }
+        inline void setBounds( double xLValue, double xUValue ) { lValue = xLValue; uValue = xUValue; }
         inline void setDone( bool xDone ) { done = xDone; }
 
     //---API
         bool createBias( std::vector<ArcSP>& arcs ); //creates a ner arc representing the bias and adds it to the NeuralWeb total set of arcs passed by ref. For input layer, does not create the bias and returns false
         double forwardProp(); //forward propagation: the values at input layer are propagated towards the output layer and all the nodes are given a value
+        void forwardPropBounds( double& lOutput, double& uOutput ); //interval forward propagation: the value bounds at input layer are propagated and all the nodes are given bounds of their value
         //generates the same links to parent and child arcs but related to a new set of arcs. Used for updating nodes when copying a NauralWeb
         inline void updateArcPointers( const std::vector<ArcSP>& newArcs, std::vector<Arc*>& updatedChildren, std::vector<Arc*>& updatedParents ) const { for( uint c = 0; c < children.size(); c++ ) updatedChildren.push_back ( newArcs[ children[c]->getId() ].get() ); 
         																																			for( uint p = 0; p < parents.size(); p++ ) updatedParents.push_back( newArcs[ parents[p]->getId() ].get() ); } 
@@ -83,6 +85,8 @@ class Node
 
         bool bTrainableScale; //whether the node scales are trainable or not. Trainable = internal and output layer. Not trainable = input layer
         double value; //current value, obtained in the last forwardProp
+        double lValue; //current lower bound of the value, obtained in the last forwardPropBounds
+        double uValue; //current upper bound of the value, obtained in the last forwardPropBounds
         bool done; //whether the calue is already calculated in the current forward pass. Reset at NeuralWeb level before each forward pass
 };
 
@@ -108,4 +112,32 @@ inline double Node::forwardProp()
     return value;
 }
 
+inline void Node::forwardPropBounds( double& lOutput, double& uOutput )
+///same as forwardProp() with intervals. Every term is bounded by Arc::forwardPropBounds(), the scale sign decides the order of the bounds and the activation function is monotonic
+{
+    if( parents.size() == 0 || done ) //if input layer or already calculated, return the bounds
+    {
+        lOutput = lValue;
+        uOutput = uValue;
+        return;
+    }
+
+    double lSum = 0.0;
+    double uSum = 0.0;
+    for( uint p = 0; p < parents.size(); p++ ) //weighted sum of the bounds
+    {
+        double lTerm, uTerm;
+        parents[p]->forwardPropBounds( lTerm, uTerm );
+        lSum += lTerm;
+        uSum += uTerm;
+    }
+    double lScaled = scales[0] >= 0.0 ? lSum * scales[0] : uSum * scales[0]; //multiply by scale. Single weighted sum, as in forwardProp()
+    double uScaled = scales[0] >= 0.0 ? uSum * scales[0] : lSum * scales[0];
+
+    activationFunction->calculateBounds( lScaled, uScaled, lValue, uValue ); //apply non-linear activation function to both bounds
+    done = true; //this node is already calculated (do not calculate again during this forward pass)
+    lOutput = lValue;
+    uOutput = uValue;
+}
+
 #endif //NODE_HPP
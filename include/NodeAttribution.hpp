@@ -0,0 +1,74 @@
+#ifndef NODE_ATTRIBUTION_HPP
+#define NODE_ATTRIBUTION_HPP
+
+#include "defines.hpp"
+#include "Parser.hpp" //Params constructor
+#include "NeuralWeb.hpp" //const NeuralWeb* referenceNet, node and arc names
+#include "NetPlan.hpp" //const NetPlan* plan, attributeBlock()
+#include "DatasetBase.hpp" //attributed dataset
+
+#include <vector> //matrix, summaries
+#include <string> //names, makeSummary()
+
+
+///contribution of every node (inputs included) and arc of the trained net or ensemble to the prediction of every instance of a dataset: gradient x activation, or its path-integrated variant from the all-0 input (attributionSteps > 0).
+///Calculated with the compiled nets (NetPlan) in a forward and a reverse sweep per block of instances (one per step if path-integrated), the blocks in parallel. The result is an [ instance x node ] matrix and a summary of each node and arc over the instances
+class NodeAttribution
+{
+    public:
+        ///attribution params
+        struct Params
+        {
+            uint stepNum; //0 = gradient x activation. Otherwise steps of the path from the all-0 input
+
+            Params( const Parser& parser ) : stepNum( parser.getUintParam( "attributionSteps" ) ) {;}
+        };
+
+        ///contribution of a node or arc over the instances
+        struct Summary
+        {
+            enum Type { INPUT, NODE, ARC };
+
+            std::string name; //node name, or "parent -> child" for an arc
+            Type type;
+            double mean; //mean over the instances
+            double meanAbs; //mean of the absolute values
+            double minValue;
+            double maxValue;
+
+            Summary() : type(NODE), mean(0.0), meanAbs(0.0), minValue(0.0), maxValue(0.0) {;}
+        };
+
+        NodeAttribution( const Parser& parser, const NetPlan* plan, const NeuralWeb* referenceNet ) : params(parser), plan(plan), referenceNet(referenceNet), rowNum(0), inputSum(0.0), seconds(0.0) {;}
+        virtual ~NodeAttribution() {}
+
+    //---get
+        inline const Params& getParams() const { return params; }
+        inline uint getRowNum() const { return rowNum; }
+        inline const std::vector<std::string>& getNodeNames() const { return nodeNames; } //columns of the matrix: the inputs, then the calculated nodes in plan order
+        inline const std::vector<double>& getAttributions() const { return attributions; } //[ instance ][ node ]
+        inline const std::vector<double>& getPredictions() const { return predictions; }
+        inline const std::vector<Summary>& getSummaries() const { return summaries; } //nodes and arcs by mean absolute contribution, the largest first
+
+    //---API
+        bool attribute( const DatasetBase& dataset ); //attributions of every instance of the dataset. False if the nets are not compiled (plan not valid)
+        std::string makeSummary() const; //instances, time, sum check and the largest contributions. For the summary file
+
+
+    private:
+        Params params;
+        const NetPlan* plan; //compiled members
+        const NeuralWeb* referenceNet; //node and arc names
+        uint rowNum; //instances attributed
+        std::vector<std::string> nodeNames;
+        std::vector<double> attributions;
+        std::vector<double> predictions;
+        std::vector<Summary> summaries;
+        double inputSum; //mean over the instances of the sum of the input attributions
+        double seconds;
+
+        void makeNodeNames(); //input and calculated node names from the reference net
+        Summary summarize( const double* values, size_t stride, const std::string& name, Summary::Type type ) const; //mean, mean absolute and range of the values of a node or arc over the instances
+};
+
+#endif //NODE_ATTRIBUTION_HPP
@@ -4,16 +4,76 @@
 #include "defines.hpp"
 #include "Node.hpp" //nodes
 #include "Arc.hpp" //arcs
+#include "DataMatrix.hpp" //inputs
+#include "SparseRows.hpp" //sparseInputs
 
 #include <vector> //nodes, arcs, inputs, outputs, metrics
 #include <map> //params
 #include <string> //param names,std::vector<std::string> header, std::vector<std::string> originalDataHeader, std::map<std::string, std::string> strParams
 #include <memory> //std::vector<NodeSP> nodes, std::vector<ArcSP> arcs
+#include <cstdint> //DatasetFileHeader
 
 
+class MappedFile;
+
 class Parser
 {
     public:
+        ///fixed-size start of a binary dataset file. It is followed by the names (output + inputs, each one as uint32 length + chars), 0s up to dataOffset and then the data: inputs (rowNum * stride doubles, row-major, same layout as DataMatrix), outputs (rowNum doubles) and, if flagged, weights (rowNum doubles). Native byte order
+        struct DatasetFileHeader
+        {
+            char magic[4]; //PARSER_DATA_BINARY_MAGIC
+            uint32_t version; //PARSER_DATA_BINARY_VERSION
+            uint32_t flags; //PARSER_DATA_BINARY_FLAG_WEIGHTS
+            uint32_t inputNum; //number of inputs per row
+            uint64_t rowNum; //number of instances
+            uint32_t stride; //doubles between the starts of two consecutive rows (inputNum + 0s padding)
+            uint32_t namesBytes; //size of the names section
+            uint64_t dataOffset; //bytes from the start of the file to the inputs. Multiple of DATA_MATRIX_ALIGNMENT
+        };
+
+        ///start of a binary trained net file. It is followed by the parameter vector (paramNum doubles, NeuralWeb::getParamValues() layout) and the metrics (metricNum doubles, train and val). Native byte order
+        struct NetFileHeader
+        {
+            char magic[4]; //PARSER_NET_BINARY_MAGIC
+            uint32_t version; //PARSER_NET_BINARY_VERSION
+            uint64_t topologyHash; //NeuralWeb::getTopologyHash() of the saved net. Must match the reference net
+            uint32_t paramNum; //number of weights and scales
+            uint32_t metricNum; //number of metrics
+        };
+
+        ///start of an ensemble bundle file. It is followed by the [ member x parameter ] matrix (memberNum * paramNum doubles, one NeuralWeb::getParamValues() per row) and the [ member x metric ] matrix (memberNum * metricNum doubles). All the members share the reference topology. Native byte order
+        struct EnsembleFileHeader
+        {
+            char magic[4]; //PARSER_ENSEMBLE_BINARY_MAGIC
+            uint32_t version; //PARSER_ENSEMBLE_BINARY_VERSION
+            uint64_t topologyHash; //NeuralWeb::getTopologyHash() of the members. Must match the reference net
+            uint32_t paramNum; //number of weights and scales per member
+            uint32_t metricNum; //number of metrics per member
+            uint32_t memberNum; //number of member nets
+            uint32_t firstNetIndex; //index of the first member net (netIndex)
+        };
+
+        ///start of a binary prediction file. It is followed by fixed-size records (recordBytes each, no padding): correct output (double), predicted output (double) and the inputs as bits (bit i of byte i / 8 = whether input i >= 0.5), in the header order. Native byte order
+        struct PredictionFileHeader
+        {
+            char magic[4]; //PARSER_PRED_BINARY_MAGIC
+            uint32_t version; //PARSER_PRED_BINARY_VERSION
+            uint32_t inputNum; //number of inputs per record
+            uint32_t recordBytes; //2 * sizeof( double ) + ( inputNum + 7 ) / 8
+        };
+
+        ///columns of a text dataset file, read from its header line (parseDatasetTextHeader()). For parsing its rows by blocks of lines (parseDatasetTextRows())
+        struct DatasetTextLayout
+        {
+            bool bCompact; //single column with the indexes of the 0 inputs (FLAG_DATA_COMPACT file)
+            bool bWeights; //the column after the output is the instance weight
+            uint inputNum; //number of inputs of the net
+            std::vector<uint> inputOrder; //position in the net input layer of each input column. Empty if compact
+
+            DatasetTextLayout() : bCompact(false), bWeights(false), inputNum(0) {}
+        };
+
     //---static
         static std::map<std::string, FunctionBase::FunctionType> functionTypeNM; //name map for str param "activation function type" to FunctionBase::FunctionType
         static std::map<std::string, int> metricNM; //name map for str params metric and quality criterion to metric index
@@ -26,11 +86,14 @@ class Parser
         inline const std::vector<NodeSP>& getNodes() const { return nodes; }
         inline const std::vector<ArcSP>& getArcs() const { return arcs; }
         inline const std::vector<double>& getMetrics() const { return metrics; }
+        inline const std::vector<double>& getParamValues() const { return paramValues; }
         inline const std::vector<std::string>& getHeader() const { return header; }
         //data
-        inline const std::vector<std::vector<double>>& getInputs() const { return inputs; }
+        inline const DataMatrix& getInputs() const { return inputs; }
+        inline const SparseRows& getSparseInputs() const { return sparseInputs; }
         inline const std::vector<double>& getOutputs() const { return outputs; }
         inline const std::vector<double>& getInstanceWeights() const { return instanceWeights; }
+        inline const std::vector<double>& getPredictions() const { return predictions; }
         inline const std::vector<std::string>& getOriginalDataHeader() const { return originalDataHeader; }
         //options params
         inline const std::map<std::string, int>& getIntParams() const { return intParams; }
@@ -38,16 +101,24 @@ class Parser
         inline int getIntParam( const std::string& paramName ) const { return intParams.find( paramName )->second; }
         inline uint getUintParam( const std::string& paramName ) const { return static_cast<uint>( intParams.find( paramName )->second ); }
         inline double getRealParam( const std::string& paramName ) const { return realParams.find( paramName )->second; }
+        inline const std::string& getStrParam( const std::string& paramName ) const { return strParams.find( paramName )->second; }
 
     //---set
         inline void setHeader( const std::vector<std::string>& xHeader ) { header = xHeader; }
         inline void setIntParam( const std::string& paramName, int value ) { intParams[paramName] = value; }
         inline void setRealParam( const std::string& paramName, double value ) { realParams[paramName] = value; }
+        inline void setMessageStream( std::ostream& stream ) { messages = &stream; } //where the errors and warnings of the parsing go. std::cout unless set
 
     //---API
+        inline Parser makeNetParser() const { Parser netParser; netParser.intParams = intParams; netParser.realParams = realParams; netParser.strParams = strParams; netParser.header = header; netParser.messages = messages; return netParser; } //copy of the params and header without the parsed data, for parsing nets in another thread
         bool parseOptions( const std::string& fileName = DEFAULT_PARSER_INFILE_OPTIONS ); //parse the options and params file
         bool parseNetwork( uint64_t options = DEFAULT_PARSER_FLAG_NET, const std::string& fileName = DEFAULT_PARSER_INFILE_NET_W, const std::string& fileNameActi = DEFAULT_PARSER_INFILE_NET_ACTI, const std::string& fileNameMetrics = DEFAULT_PARSER_INFILE_NET_METRICS );
-        bool parseDataset( uint64_t options = DEFAULT_PARSER_FLAG_DATA, const std::string& fileName = DEFAULT_PARSER_INFILE_DATA );
+        bool parseNetworkBinary( const std::string& fileName, uint64_t topologyHash, uint paramNum ); //load the parameter vector and metrics of a trained net saved in binary. False if missing or if it does not match the reference topology
+        bool parseEnsembleBinary( const std::string& fileName, uint64_t topologyHash, uint paramNum, uint memberNum, uint firstNetIndex ); //load the parameter and metric matrices of an ensemble bundle into paramValues and metrics (member after member). False if missing or if it does not match
+        bool parseDataset( uint64_t options = DEFAULT_PARSER_FLAG_DATA, const std::string& fileName = DEFAULT_PARSER_INFILE_DATA ); //text (csv, with all the inputs or compact), or binary file, told apart by the first bytes. With FLAG_DATA_COMPACT the inputs are loaded into sparseInputs instead of inputs
+        bool parsePredictionsBinary( const std::string& fileName, uint64_t firstRow = 0, uint rowNum = UINT32_MAX ); //load rows [ firstRow, firstRow + rowNum ) of a binary prediction file into inputs, outputs and predictions. No rows past the end of the file. False if missing or if it does not match the header
+        bool parseDatasetTextHeader( uint64_t options, const std::string& headerLine, DatasetTextLayout& layout ); //columns of a text dataset file from its header line (sets originalDataHeader). False if an input is not in the net. Should be called after setting the header
+        static bool parseDatasetTextRows( const DatasetTextLayout& layout, const char* text, const char* textEnd, uint firstLineNumber, const std::string& fileName, DataMatrix& rowInputs, SparseRows& rowSparseInputs, std::vector<double>& rowOutputs, std::vector<double>& rowWeights ); //rows of a block of lines of a text dataset file: dense inputs or index lists (compact file), outputs and weights (if in the file). False if any row is malformed (reported with its line number)
 
 
     private:
@@ -55,20 +126,40 @@ class Parser
         std::vector<NodeSP> nodes; //nodes parsed from the main net file. Used for creating NeuralWeb object
         std::vector<ArcSP> arcs; //arcs parsed from the main net file. Used for creating NeuralWeb object
         std::vector<double> metrics; //train and val metrics concatenated. Parsed from the metrics file of a trained net. Used for seting a net's metrics via reflection
+        std::vector<double> paramValues; //weights and scales of a trained net parsed from a binary file. NeuralWeb::getParamValues() layout
         std::vector<std::string> header; //names of the input nodes in the same order that appear in the nets' input layer. Must be set from a net before parsing datasets in order to make the inputs order match
     //dataset
-        std::vector<std::vector<double>> inputs; //dataset inputs, n per case. Dim 0 = case, dim 1 = input 
+        DataMatrix inputs; //dataset inputs, n per case. Dim 0 = case, dim 1 = input. Maps the file when parsing a binary dataset in the net input order
+        SparseRows sparseInputs; //dataset inputs as the indexes of the 0 inputs of each case, in the net input order. Filled instead of inputs when parsing with FLAG_DATA_COMPACT
         std::vector<double> outputs; //dataset outputs, 1 per case. Dim 0 = case
         std::vector<double> instanceWeights; //weights of the cases. Dim 0 = case. Parsed from de dataset file if it includes weights
+        std::vector<double> predictions; //predicted outputs, 1 per case. Parsed from prediction files
         std::vector<std::string> originalDataHeader; //input node names in the order they appear in the dataset file. The first one is the output name
     //options params
         std::map<std::string, int> intParams; //int, uint and bool params
         std::map<std::string, double> realParams; //real params
         std::map<std::string, std::string> strParams; //str params that required conversion to specific types via name maps
+    //messages
+        std::ostream* messages; //errors and warnings of the member functions (the static row parsers report to std::cout)
+
+        bool parseDatasetBinary( uint64_t options, const std::shared_ptr<MappedFile>& dataFile, const std::string& fileName ); //use a mapped binary dataset file. The inputs are not copied if their order matches the header
+        bool parseDatasetText( uint64_t options, const MappedFile& dataFile, const std::string& fileName ); //parse a mapped csv dataset file by line-aligned chunks in parallel, writing each row in its place. False if any row is malformed
+        static bool parseDatasetRow( const char* line, const char* lineEnd, const std::vector<uint>& inputOrder, bool bWeight, double& output, double* weight, double* row ); //output, weight (if bWeight) and inputs of a csv row. False if not exactly those numbers
+        static bool parseCompactRow( const char* line, const char* lineEnd, uint inputNum, bool bWeight, double& output, double* weight, std::vector<uint32_t>& rowIndexes ); //output, weight (if bWeight) and indexes of the 0 inputs of a compact csv row. False if the indexes are not sorted integers lower than inputNum
+        static void printMalformedRow( const std::string& fileName, uint lineNumber, const DatasetTextLayout& layout ); //report a row that is not what the layout expects
+        static bool parseNumber( const char*& cursor, const char* end, double& value ); //number starting at cursor (after spaces), which is moved to the following separator. False if not a number followed by a separator or the end
+        bool checkNetwork( const std::string& fileName ) const; //report cycles (false: forward propagation cannot handle them) and nodes that do not lead to the output. Before adding the biases
+        static void splitLine( const std::string& line, char separator, std::vector<std::string>& fields ); //fields of a line, empty ones included. Reuses the strings in fields
+        bool makeInputOrder( std::vector<uint>& inputOrder ) const; //position in the header of each input in originalDataHeader. False if an input is not in the header
 };
 
+static_assert( sizeof( Parser::DatasetFileHeader ) == 40, "binary dataset header must have no padding" );
+static_assert( sizeof( Parser::NetFileHeader ) == 24, "binary net header must have no padding" );
+static_assert( sizeof( Parser::EnsembleFileHeader ) == 32, "ensemble bundle header must have no padding" );
+static_assert( sizeof( Parser::PredictionFileHeader ) == 16, "binary prediction header must have no padding" );
+
 
-inline Parser::Parser()
+inline Parser::Parser() : messages( &std::cout )
 {
 ///parameters default values
 //---randomness
@@ -89,6 +180,9 @@ inline Parser::Parser()
     //intParams["ensembleCriterion"] = INDEX_METRIC_LOSS_W;
     realParams["ensembleThreshold"] = 0.5; //quality threshold (ensembleCriterion) for including a net in the ensemble
     intParams["ensembleWeighted"] = 1; //whether to weight member predictions by quality (ensembleCriterion) (1) or not (0)
+    intParams["sweepGreedySteps"] = 20; //maximum number of members added (repetitions allowed) by the greedy selection of program 14. 0 = no greedy selection
+    intParams["knockoutArcs"] = 0; //whether the knockout screening of program 16 removes each arc too (1) or only knocks out the hidden nodes (0)
+    intParams["attributionSteps"] = 0; //attributions of program 17: 0 = gradient x activation, n = path-integrated from the all-0 input in n steps (the input attributions add up to the prediction minus that of the all-0 input)
     
     intParams["netIndex"] = 0; //index of the first net (trained and saved or loaded depending on the program)
     intParams["netNum"] = 1; //number of nets (trained and saved or loaded depending on the program)
@@ -121,6 +215,9 @@ inline Parser::Parser()
     realParams["instanceWeightByOutput"] = 0.5; //weight given to cases with output = 0. Cases with output = 1 are given 1 - instanceWeightByOutput. Must be in [0,1]. For cost-sensitive classification or class balancing
     realParams["instanceWeightByInput"] = 0.0; //exponent of exponential decay of instance weigth with number of 0 inputs (for cases where instances with less 0 inputs are more informative)
     intParams["simWeight"] = 0; //whether to weight the instances by similarity (train set: between them, val set: related to the train set). For offsetting very similar instances in the dataset
+    intParams["simMode"] = 0; //how to add up the similarities when weighting by similarity. 0 = pair-wise, O(N^2); 1 = from the per-class counts of each input, O(N * inputs), for big datasets
+    intParams["simCheckNum"] = 0; //number of instances (evenly spaced) whose sums in simMode 1 are compared with the pair-wise ones, printing the error and times. 0 = no check
+    intParams["simMatrix"] = 0; //whether to keep the pair-wise similarity matrices when weighting by similarity. Only the dissimilarity sums are needed, so 0 unless inspecting them (N x N memory)
 
 
 //---k-fold and evaluation
@@ -140,6 +237,17 @@ inline Parser::Parser()
     intParams["combisFilterMode"] = 0; //filter to apply when making all input combinations for prediction (related to the main loaded dataset). 0 = no filter, 1 = remove repeated, 2 = remove supersetsof instances with given output
     intParams["combisFilterInput"] = 0; //if filter mode = 2, instance value to use for determining that one instance is a superset of another one
     intParams["combisFilterClass"] = 0; //if filter mode = 2, output value to remove
+    intParams["combisChunkSize"] = 10000; //number of input combinations generated, filtered, predicted and printed at a time (bounded memory)
+    intParams["pipelineQueueChunks"] = 4; //chunks of combisChunkSize rows queued between the reader, the predictor and the writer of program 6 before the stage in front waits (bounded memory)
+    intParams["combisPartNum"] = 1; //number of parts the input combinations are split into for predicting them in separate runs
+    intParams["combisPartIndex"] = 0; //part of the input combinations predicted in this run
+    intParams["predictionTopK"] = 0; //number of combinations kept by the combination search (highest or lowest predicted outputs). 0 = keep those in the print thresholds instead
+    intParams["predictionTopKHighest"] = 1; //whether the combination search keeps the highest (1) or the lowest (0) predicted outputs
+    strParams["predictionInputFile"] = PARSER_NO_FILE; //dataset file in the data folder predicted by program 6 instead of the input combinations (csv with any input values, compact or binary). none = the input combinations file of zerosNum
+    intParams["servePort"] = 5555; //localhost TCP port of the prediction server (program 15)
+    intParams["serveUnixSocket"] = 0; //whether the prediction server listens on the Unix domain socket graphgann.sock in the run directory (1) instead of the TCP port (0)
+    intParams["serveMaxBatch"] = 256; //maximum number of requests the prediction server predicts together
+    intParams["serveBatchWaitUs"] = 200; //maximum time (microseconds) a request waits for others to be predicted together. 0 = no waiting
     
 //---crazy
     intParams["crazy"] = 0; //whether to perform a random swap of input nodes to test the impact of net structure 
@@ -154,7 +262,13 @@ inline Parser::Parser()
     intParams["saveHistorical"] = 0; //whether to save the historical change in train and val metrics during training
     intParams["saveBestNet"] = 0; //whether to save the structure, param value and metrics of the best nets
     intParams["savePredictions"] = 0; //whether to save (val and test) predictions of the best nets
+    intParams["saveThresholdCurves"] = 0; //whether to save the metrics of every class threshold (accuracies, ROC and precision-recall curves) of the (val and test) predictions of the best nets and ensembles
 
+    intParams["netFormat"] = 1; //format of the saved trained nets: 0 = text (net, scales and metrics files), 1 = binary (single file, loaded without parsing), 2 = both. Nets without binary file are loaded from the text files
+    intParams["predictionFormat"] = 0; //format of the combination prediction files: 0 = text (csv with all the inputs), 1 = compact (csv with the indexes of the 0 inputs), 2 = binary (fixed-size records, converted to text by program 13)
+    intParams["combisFormat"] = 0; //format of the input combinations file made by program 8 and read by program 6: 0 = text (csv with all the inputs), 1 = compact (csv with the indexes of the 0 inputs, predicted without expanding them)
+    intParams["datasetFormat"] = 0; //format of the dataset and split files: 0 = text (csv), 1 = binary (memory-mapped, no parsing). Missing binary files are converted from the text ones
+    intParams["threadNum"] = 0; //number of worker threads for the parallel parts. 0 = as many as hardware threads
     intParams["datasetIndex"] = -1; //in the case of having performed a dataset split before, index of the fold to use. -1 = use whole dataset
     intParams["program"] = 0; //program to run
 }
@@ -0,0 +1,92 @@
+#ifndef PREDICTION_PIPELINE_HPP
+#define PREDICTION_PIPELINE_HPP
+
+#include "defines.hpp"
+#include "Parser.hpp" //Params constructor, DatasetTextLayout
+#include "NeuralWebBase.hpp" //const NeuralWebBase* predictor
+#include "DataMatrix.hpp" //Chunk inputs
+#include "SparseRows.hpp" //Chunk sparseInputs
+#include "BoundedQueue.hpp" //queues between the stages
+#include "Emitter.hpp" //printDatasetChunk()
+
+#include <vector> //chunk outputs and predictions
+#include <string> //file names, makeSummary()
+#include <fstream> //input file
+#include <atomic> //bReadOk
+
+
+///predicts an input file of any size with bounded memory: a reader thread parses it by chunks of rows, the calling thread predicts each chunk with predictBatch() (parallel over the worker threads) and a writer thread prints the predictions in input order.
+///The stages are joined by queues of a few chunks, so a slow stage holds the others back (backpressure) instead of the chunks piling up: the memory does not depend on the file size. Text files are read line by line; binary files are mapped, and their rows are read when their chunk is predicted.
+///The input values go through the stages as they are in the file (any real values); only compact files (0/1 inputs as index lists) are carried as index lists
+class PredictionPipeline
+{
+    public:
+        ///pipeline params
+        struct Params
+        {
+            uint chunkSize; //rows parsed, predicted and printed at a time
+            uint queueChunks; //chunks waiting between two stages before the one in front waits
+            double classThreshold;
+            double printThresholdL; //predictions printed are those lower than this...
+            double printThresholdU; //...or higher than this
+
+            Params( const Parser& parser ) : chunkSize( std::max( 1u, parser.getUintParam( "combisChunkSize" ) ) ), queueChunks( std::max( 1u, parser.getUintParam( "pipelineQueueChunks" ) ) )
+            , classThreshold( parser.getRealParam( "classThreshold" ) ), printThresholdL( parser.getRealParam( "predictionPrintThresholdL" ) ), printThresholdU( parser.getRealParam( "predictionPrintThresholdU" ) ) {;}
+        };
+
+        PredictionPipeline( const Parser& parser, const NeuralWebBase* predictor, Emitter* emitter ) : params(parser), predictor(predictor), emitter(emitter), bReadOk(true)
+        , rowNum(0), chunkNum(0), printedNum(0), seconds(0.0), readSeconds(0.0), predictSeconds(0.0), writeSeconds(0.0)
+        , readBlockedSeconds(0.0), predictBlockedSeconds(0.0), predictStarvedSeconds(0.0), writeStarvedSeconds(0.0), readPeakChunks(0), predictedPeakChunks(0) {;}
+        virtual ~PredictionPipeline() {}
+        PredictionPipeline( const PredictionPipeline& ) = delete; //owns the threads while running
+        PredictionPipeline& operator=( const PredictionPipeline& ) = delete;
+
+    //---get
+        inline const Params& getParams() const { return params; }
+        inline uint64_t getRowNum() const { return rowNum; }
+        inline uint64_t getPrintedNum() const { return printedNum; }
+
+    //---API
+        bool run( Parser& parser, const std::string& inputFileName, const std::string& outputFileName, uint64_t options ); //predict the inputs of a dataset file (text, compact or binary, with the outputs of its first column as the correct ones) and print them to a new file by chunks. False if the file cannot be read or has malformed rows (the chunks before them are printed)
+        std::string makeSummary() const; //rows, throughput, time of each stage and time waiting on the queues. For the summary file
+
+
+    private:
+        ///rows of the file on their way through the stages
+        struct Chunk
+        {
+            bool bSparse; //whether the inputs are in sparseInputs (compact file) instead of inputs
+            DataMatrix inputs; //input values of the rows. A view of the mapped rows for binary files
+            SparseRows sparseInputs; //0/1 inputs as index lists, predicted without expanding them
+            std::vector<double> outputs; //correct outputs (first column of the file)
+            std::vector<double> predictions; //set by the predictor stage
+
+            Chunk() : bSparse(false) {}
+        };
+
+        Params params;
+        const NeuralWebBase* predictor; //net or ensemble that predicts the rows
+        Emitter* emitter; //prints the chunks
+        std::atomic<bool> bReadOk; //false if the reader found malformed rows
+    //stats
+        uint64_t rowNum; //rows read
+        uint chunkNum; //chunks read
+        uint64_t printedNum; //rows printed (the others are out of the print thresholds)
+        double seconds; //whole run
+        double readSeconds; //time of each stage working, without its waits
+        double predictSeconds;
+        double writeSeconds;
+        double readBlockedSeconds; //backpressure: time the reader waited for room in the queue of the predictor
+        double predictBlockedSeconds; //backpressure: time the predictor waited for room in the queue of the writer
+        double predictStarvedSeconds; //time the predictor waited for chunks of the reader
+        double writeStarvedSeconds; //time the writer waited for chunks of the predictor
+        uint readPeakChunks; //most chunks queued at once before and after the predictor
+        uint predictedPeakChunks;
+
+        void readText( std::ifstream& file, const Parser::DatasetTextLayout& layout, const std::string& fileName, BoundedQueue<Chunk>& readQueue ); //reader thread for text files: parse the lines after the header by chunks
+        void readMapped( const Parser& parser, BoundedQueue<Chunk>& readQueue ); //reader thread for binary files (mapped by the parser): views of the rows by chunks
+        void write( BoundedQueue<Chunk>& predictedQueue, const std::string& fileName, uint64_t options ); //writer thread: print the chunks in order
+        bool pushChunk( Chunk& chunk, BoundedQueue<Chunk>& readQueue ); //queue a chunk made by the reader. False if the pipeline is not taking more
+};
+
+#endif //PREDICTION_PIPELINE_HPP
@@ -0,0 +1,97 @@
+#ifndef PREDICTION_SERVER_HPP
+#define PREDICTION_SERVER_HPP
+
+#include "defines.hpp"
+#include "Parser.hpp" //Params constructor
+#include "NeuralWebBase.hpp" //const NeuralWebBase* predictor
+
+#include <vector> //queue, latencies
+#include <deque> //queue
+#include <list> //connections
+#include <thread> //Connection thread
+#include <string> //protocol lines, makeSummary()
+#include <chrono> //request arrival, latencies
+#include <mutex> //mutex
+#include <condition_variable> //batcher and connection waits
+#include <atomic> //bStop
+
+
+///long-running prediction service: a loaded net or ensemble answers prediction requests from other processes over a localhost TCP port or a Unix domain socket, so a query costs a round trip instead of a program run.
+///Line protocol: each line of a client is either the input values of an instance (separated by spaces, tabs, commas or semicolons) or a command ( stats, quit, shutdown ), and gets one line back in the same order: the prediction, the stats or an error.
+///Requests of all the connections are queued and predicted together (micro-batching) by a batcher thread with predictBatch(), which splits big batches over the worker threads. The latency of every request is tracked for the p50 and p99. POSIX only: serve() fails on Windows
+class PredictionServer
+{
+    public:
+        ///server params
+        struct Params
+        {
+            uint port; //localhost TCP port
+            bool bUnixSocket; //whether to listen on the Unix domain socket FILE_NAME_SERVER_SOCKET (in the run directory) instead of the TCP port
+            uint maxBatch; //maximum number of requests predicted together
+            uint batchWaitUs; //maximum time (microseconds) the oldest queued request waits for more requests before its batch is predicted
+
+            Params( const Parser& parser ) : port( parser.getUintParam( "servePort" ) ), bUnixSocket( parser.getIntParam( "serveUnixSocket" ) == 1 )
+            , maxBatch( std::max( 1u, parser.getUintParam( "serveMaxBatch" ) ) ), batchWaitUs( parser.getUintParam( "serveBatchWaitUs" ) ) {;}
+        };
+
+        PredictionServer( const Parser& parser, const NeuralWebBase* predictor, uint inputNum ) : params(parser), predictor(predictor), inputNum(inputNum), bStop(false), bBatcherStopped(false)
+        , requestNum(0), batchNum(0), errorNum(0), latencies( SERVER_LATENCY_WINDOW, 0.0 ), latencyNum(0) {;}
+        virtual ~PredictionServer() {}
+        PredictionServer( const PredictionServer& ) = delete; //owns the threads while serving
+        PredictionServer& operator=( const PredictionServer& ) = delete;
+
+    //---get
+        inline const Params& getParams() const { return params; }
+
+    //---API
+        bool serve(); //listen and answer the clients until one of them sends shutdown. False if the socket cannot be opened
+        std::string makeSummary() const; //requests, batches, throughput and latency percentiles. For the summary file
+
+
+    private:
+        ///a prediction waiting for its batch. Owned by the connection that made it
+        struct Request
+        {
+            const double* inputs; //inputNum values
+            double output;
+            bool bDone; //whether the output is set
+            std::chrono::steady_clock::time_point arrival;
+        };
+
+        ///thread of a client connection, joined by the accept loop once finished
+        struct Connection
+        {
+            std::thread thread;
+            std::atomic<bool> bFinished; //set by the thread when it returns
+
+            Connection() : bFinished(false) {}
+        };
+
+        Params params;
+        const NeuralWebBase* predictor; //net or ensemble that predicts the requests
+        uint inputNum; //number of input values of a request
+        std::atomic<bool> bStop; //tells every thread to finish (shutdown command)
+        bool bBatcherStopped; //the batcher has drained the queue and returned: no more requests are queued. Guarded by the mutex
+        std::chrono::steady_clock::time_point start; //when serving started, for the throughput
+
+        std::deque<Request*> queue; //requests waiting to be predicted, in order of arrival
+        mutable std::mutex mutex; //guards the queue, the requests and the stats
+        std::condition_variable queueCondition; //signals the batcher that there are requests or it must stop
+        std::condition_variable doneCondition; //signals the connections that requests are done
+    //stats
+        uint64_t requestNum; //predicted requests
+        uint64_t batchNum; //predicted batches
+        uint64_t errorNum; //lines that could not be parsed
+        std::vector<double> latencies; //microseconds from arrival to prediction of the last SERVER_LATENCY_WINDOW requests (ring)
+        uint64_t latencyNum; //latencies recorded
+
+        int openSocket(); //listening socket. -1 if it cannot be opened
+        void runBatcher(); //batcher thread loop: wait for requests, gather a batch and predict it
+        void runConnection( int socket, std::atomic<bool>* bFinished ); //connection thread loop: read lines, answer them, until the client closes, quits, sends a line longer than SERVER_MAX_LINE_BYTES or the server stops
+        static void joinFinished( std::list<Connection>& connections, bool bAll ); //join the connection threads that have returned (all of them if bAll)
+        std::string answer( const std::string& lines, bool& bClose ); //replies to complete lines, in order. The predictions of all the lines are queued together. Errors if the batcher has already stopped
+        std::string makeStatsLine() const; //one-line stats for the stats command
+        double getLatencyPercentile( double fraction ) const; //latency (microseconds) at a fraction of the recorded window. Called with the mutex locked
+};
+
+#endif //PREDICTION_SERVER_HPP
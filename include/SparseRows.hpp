@@ -0,0 +1,63 @@
+#ifndef SPARSE_ROWS_HPP
+#define SPARSE_ROWS_HPP
+
+#include "defines.hpp"
+#include "DataMatrix.hpp" //InputSpan in appendRow(), toDense()
+
+#include <vector> //indexes, offsets
+#include <cstdint> //uint32_t indexes
+
+
+///read-only view of the inputs of one instance as a sorted list of indexes: the inputs at the indexes are 0 (bInverted) or 1, all the others the opposite value. A row of a SparseRows. Does not own the indexes
+struct SparseRow
+{
+    const uint32_t* indexes;
+    uint length; //number of indexes
+    uint colNum; //number of inputs
+    bool bInverted; //whether the indexes are the 0 inputs
+
+    SparseRow( const uint32_t* indexes, uint length, uint colNum, bool bInverted ) : indexes(indexes), length(length), colNum(colNum), bInverted(bInverted) {}
+
+    inline uint size() const { return colNum; }
+    inline double getDefaultValue() const { return bInverted ? 1.0 : 0.0; } //value of the inputs not in the list
+    inline double getIndexedValue() const { return bInverted ? 0.0 : 1.0; } //value of the inputs in the list
+    inline void expand( double* row ) const { for( uint i = 0; i < colNum; i++ ) row[i] = getDefaultValue(); for( uint i = 0; i < length; i++ ) row[ indexes[i] ] = getIndexedValue(); } //write the colNum input values
+};
+
+
+///binary inputs of a set of instances stored as sorted lists of indexes (DatasetBase::sparseData() representation) in a single block: the indexes of all the rows one after another and the offset where each row starts.
+///For the input combinations, where most inputs are 1 and only a few are 0: a row takes 4 bytes per 0 input instead of 8 bytes per input. Reads like a DataMatrix ( size(), [row] ) for the code that predicts and evaluates
+class SparseRows
+{
+    public:
+    //---static
+        static SparseRows fromDense( const DataMatrix& inputs, bool bInverted = DEFAULT_DATASET_SPARSE_INVERTED ); //index lists of dense rows, binarized at 0.5
+
+        SparseRows( uint colNum = 0, bool bInverted = DEFAULT_DATASET_SPARSE_INVERTED ) : colNum(colNum), bInverted(bInverted), offsets( 1, 0 ) {}
+
+    //---get
+        inline uint size() const { return offsets.size() - 1; }
+        inline bool empty() const { return offsets.size() == 1; }
+        inline uint getColNum() const { return colNum; }
+        inline bool getBInverted() const { return bInverted; }
+        inline uint64_t getIndexNum() const { return indexes.size(); } //number of indexes of all the rows
+        inline uint64_t getBytes() const { return indexes.size() * sizeof( uint32_t ) + offsets.size() * sizeof( uint64_t ); } //memory taken by the rows
+        inline SparseRow operator[]( uint r ) const { return SparseRow( indexes.data() + offsets[r], static_cast<uint>( offsets[r + 1] - offsets[r] ), colNum, bInverted ); }
+
+    //---API
+        inline void appendRow( const uint32_t* rowIndexes, uint length ) { indexes.insert( indexes.end(), rowIndexes, rowIndexes + length ); offsets.push_back( indexes.size() ); } //add a row at the end. The indexes must be sorted and lower than the number of columns
+        void appendRow( const InputSpan& row ); //add a dense row at the end, binarized at 0.5
+        void append( const SparseRows& rows ); //add the rows of another set with the same columns at the end
+        inline void reserve( uint rowNum, uint64_t indexNum ) { offsets.reserve( rowNum + 1 ); indexes.reserve( indexNum ); }
+        inline void clear() { indexes.clear(); offsets.assign( 1, 0 ); }
+        DataMatrix toDense( uint first = 0, uint rowNum = UINT32_MAX ) const; //dense copy of the rows [ first, first + rowNum ). For the code that needs the input values (printing, filtering, training)
+
+
+    private:
+        uint colNum; //number of inputs
+        bool bInverted; //whether the indexes are the 0 inputs (the others are 1) or the 1 inputs (the others are 0)
+        std::vector<uint32_t> indexes; //sorted indexes of each row, row after row
+        std::vector<uint64_t> offsets; //position in indexes where each row starts, plus the end of the last row
+};
+
+#endif //SPARSE_ROWS_HPP
@@ -0,0 +1,50 @@
+#ifndef THREAD_HANDLER_HPP
+#define THREAD_HANDLER_HPP
+
+#include "defines.hpp"
+
+#include <vector> //std::vector<std::thread> threads in parallelFor()
+#include <thread> //std::thread, hardware_concurrency()
+#include <algorithm> //std::min, std::max
+
+
+///number of worker threads used by the parallel parts of the app (set once from the options) and a simple static-partition parallel for
+class ThreadHandler
+{
+    public:
+    //---static
+        static inline uint getThreadNum() { return threadNum > 0 ? threadNum : std::max( 1u, std::thread::hardware_concurrency() ); }
+        static inline void setThreadNum( uint xThreadNum ) { threadNum = xThreadNum; }
+
+        //split [ begin, end ) in one contiguous block per thread and call function( blockBegin, blockEnd, threadIndex ) for each block. Blocks smaller than minBlockSize are avoided by using fewer threads. Runs in the calling thread if a single block
+        template<typename Function>
+        static void parallelFor( uint begin, uint end, Function function, uint minBlockSize = DEFAULT_THREAD_MIN_BLOCK )
+        {
+            if( end <= begin )
+                return;
+            uint blockNum = std::min( getThreadNum(), std::max( 1u, ( end - begin ) / std::max( 1u, minBlockSize ) ) );
+            if( blockNum <= 1 )
+            {
+                function( begin, end, 0 );
+                return;
+            }
+            uint blockSize = ( end - begin ) / blockNum;
+            uint remainder = ( end - begin ) % blockNum; //the first blocks get one more element
+            std::vector<std::thread> threads;
+            uint blockBegin = begin;
+            for( uint t = 0; t < blockNum; t++ )
+            {
+                uint blockEnd = blockBegin + blockSize + ( t < remainder ? 1 : 0 );
+                threads.emplace_back( function, blockBegin, blockEnd, t );
+                blockBegin = blockEnd;
+            }
+            for( uint t = 0; t < threads.size(); t++ )
+                threads[t].join();
+        }
+
+
+    private:
+        static uint threadNum; //0 = as many as hardware threads
+};
+
+#endif //THREAD_HANDLER_HPP
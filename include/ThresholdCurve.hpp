@@ -0,0 +1,62 @@
+#ifndef THRESHOLD_CURVE_HPP
+#define THRESHOLD_CURVE_HPP
+
+#include "defines.hpp"
+
+#include <vector> //points
+#include <string> //makeSummary()
+
+
+///classification metrics of a set of predictions for every class threshold at once: the predictions are sorted once and a single sweep from the highest to the lowest counts the instances predicted as 1 at each distinct prediction value.
+///Gives the unweighted and weighted accuracy of every threshold, the ROC and precision-recall curves and their areas, so the class threshold is chosen without evaluating again. For single nets and ensembles (cached predictions) alike
+class ThresholdCurve
+{
+    public:
+        ///counts of the instances predicted as 1 ( prediction >= threshold ), unweighted and weighted by instance weight. Those predicted as 0 are the rest of the totals
+        struct Point
+        {
+            double threshold; //the first point (everything predicted as 0) has infinite threshold
+            double truePositives;
+            double falsePositives;
+            double weightedTruePositives;
+            double weightedFalsePositives;
+
+            Point( double threshold = 0.0 ) : threshold(threshold), truePositives(0.0), falsePositives(0.0), weightedTruePositives(0.0), weightedFalsePositives(0.0) {}
+        };
+
+        //curve of the predictions of the instances with given outputs and weights. Outputs >= classThreshold are the positive class, as in NeuralWebBase::evaluateWeighted()
+        ThresholdCurve( const double* predictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, double classThreshold );
+        virtual ~ThresholdCurve() {}
+
+    //---get
+        inline const std::vector<Point>& getPoints() const { return points; } //decreasing thresholds
+        inline double getAccuracy( uint p ) const { return ( points[p].truePositives + negativeNum - points[p].falsePositives ) / ( positiveNum + negativeNum ); }
+        inline double getWeightedAccuracy( uint p ) const { return points[p].weightedTruePositives + negativeWeight - points[p].weightedFalsePositives; } //instance weights add up to 1, as in NeuralWebBase::evaluateWeighted()
+        inline double getTruePositiveRate( uint p, bool bWeighted = false ) const { return bWeighted ? points[p].weightedTruePositives / positiveWeight : points[p].truePositives / positiveNum; } //recall. NaN without positives
+        inline double getFalsePositiveRate( uint p, bool bWeighted = false ) const { return bWeighted ? points[p].weightedFalsePositives / negativeWeight : points[p].falsePositives / negativeNum; } //NaN without negatives
+        inline double getPrecision( uint p, bool bWeighted = false ) const { double predictedPositives = bWeighted ? points[p].weightedTruePositives + points[p].weightedFalsePositives : points[p].truePositives + points[p].falsePositives; return predictedPositives > 0.0 ? ( bWeighted ? points[p].weightedTruePositives : points[p].truePositives ) / predictedPositives : 1.0; } //1 when nothing is predicted as 1 (first point)
+        inline double getRocAuc( bool bWeighted = false ) const { return bWeighted ? weightedRocAuc : rocAuc; } //area under the ROC curve. -1 if a class is missing
+        inline double getAveragePrecision( bool bWeighted = false ) const { return bWeighted ? weightedAveragePrecision : averagePrecision; } //area under the precision-recall curve (step-wise). -1 without positives
+        inline uint getBestIndex( bool bWeighted = false ) const { return bWeighted ? bestWeightedIndex : bestIndex; } //point with the highest (weighted) accuracy. The highest threshold on ties
+
+    //---API
+        std::string makeSummary() const; //areas and best thresholds. For the console and the summary file
+
+
+    private:
+        std::vector<Point> points; //a point per distinct prediction, from the highest to the lowest, after the point with everything predicted as 0
+        double positiveNum; //instances with output >= classThreshold
+        double negativeNum;
+        double positiveWeight; //instance weight of the positive instances
+        double negativeWeight;
+        double rocAuc;
+        double weightedRocAuc;
+        double averagePrecision;
+        double weightedAveragePrecision;
+        uint bestIndex;
+        uint bestWeightedIndex;
+
+        void calculateAreas(); //areas and best points from the points
+};
+
+#endif //THRESHOLD_CURVE_HPP
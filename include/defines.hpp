@@ -29,6 +29,8 @@ class DistributionInterface;
 typedef std::shared_ptr<DistributionInterface> DistributionInterfaceSP;
 class Metrics;
 typedef std::shared_ptr<Metrics> MetricsSP;
+class MetricsKernelBase;
+typedef std::shared_ptr<const MetricsKernelBase> MetricsKernelBaseSP;
 
 class Node;
 typedef std::shared_ptr<Node> NodeSP;
@@ -69,6 +71,12 @@ typedef std::shared_ptr<MultiGa> MultiGaSP;
 #define MAKE_FILENAME3( prefix, index0, index1, index2 ) \
 ( std::string( prefix ) + "_" + std::to_string( index0 ) + "_" + std::to_string( index1 ) + "_" + std::to_string( index2 ) + ".txt" )
 
+#define MAKE_FILENAME4( prefix, index0, index1, index2, index3 ) \
+( std::string( prefix ) + "_" + std::to_string( index0 ) + "_" + std::to_string( index1 ) + "_" + std::to_string( index2 ) + "_" + std::to_string( index3 ) + ".txt" )
+
+#define MAKE_BINARY_FILENAME( fileName ) \
+( std::string( fileName ).substr( 0, std::string( fileName ).rfind( DEFAULT_FILE_EXT ) ) + BINARY_FILE_EXT )
+
 
 //================================================================ FLAGS
 #define FLAG( index ) \
@@ -147,9 +155,18 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 //prediction and evaluation without training
 #define PROGRAM_EVALUATE_ENSEMBLE 5 //load previously trained net and evaluate avg individual vs ensemble performance in fair test set
 #define PROGRAM_PREDICTION_ENSEMBLE 6 //uses nets saved in progTrainAndSaveNets in a weighted ensemble and the dataset generated with progMakeInputCombinations to predict the dataset outputs
+#define PROGRAM_SEARCH_COMBINATIONS 9 //uses nets saved in progTrainAndSaveNets in a weighted ensemble to search the input combinations with predicted output in the thresholds (or the top K) by branch and bound, without generating all of them
+#define PROGRAM_PREDICTION_STREAM 10 //same as progPredictOutputsEnsemble but generating the input combinations in chunks instead of parsing them. Can be restricted to one part of the combinations
+#define PROGRAM_MERGE_PREDICTION_PARTS 11 //merge the predictions of all the parts made by progPredictCombinationsStream into a single file
+#define PROGRAM_CONVERT_PREDICTIONS 13 //convert the binary prediction files of the combination programs into the text files with all the columns
+#define PROGRAM_SWEEP_ENSEMBLE 14 //evaluate the saved nets once and the ensemble metrics for every criterion, threshold and weighting plus a greedy selection of members
+#define PROGRAM_SERVE_ENSEMBLE 15 //load the saved nets once and answer prediction requests over a local socket until a client sends shutdown
+#define PROGRAM_KNOCKOUT_SCREEN 16 //knock out each hidden node (and arc) of the saved nets in turn and measure the shift of the predictions and metrics over the dataset
+#define PROGRAM_ATTRIBUTION 17 //contribution of every node and arc of the saved nets to the prediction of every instance of the dataset (gradient x activation)
 //dataset
 #define PROGRAM_SPLIT_DATASET 7 //save train and test dataset splits following a k-fold
 #define PROGRAM_INPUT_COMBINATIONS 8 //save a dataset with all the posible input combinations and same output. For prediction in a future run
+#define PROGRAM_CONVERT_DATASET 12 //save the dataset and its k splits as binary files, mapped instead of parsed when datasetFormat = 1
 
 
 
@@ -177,6 +194,11 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define INDEX_RANDOMNESS_MAINRE_RUN 2 //index of the main randomness generator for training
 
 
+//======================================================== THREAD HANDLER =============================================================
+#define DEFAULT_THREAD_NUM 0 //default number of worker threads. 0 = as many as hardware threads
+#define DEFAULT_THREAD_MIN_BLOCK 1 //default minimum number of elements per thread in ThreadHandler::parallelFor()
+
+
 
 
 
@@ -212,12 +234,18 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 
 //---loss function
 #define NET_LOSS_CLAMP_E 0.0000001 //small number added in the cross-entropy loss function to avoid invalid logs
+#define NET_METRICS_LANES 4 //partial sums per metric in MetricsKernel: instance d is added to lane d % NET_METRICS_LANES and the lanes are added pairwise, so the sums vectorize and do not depend on anything but the order of the instances. Power of 2
+#define NET_METRICS_BLOCK 256 //instances whose losses, hits and class weights MetricsKernel calculates together before adding them. Multiple of NET_METRICS_LANES
 
 
 //=========================================================== NEURAL WEB ENSEMBLE =============================================================
 #define DEFAULT_ENSEMBLE_BWEIGHTED true //whether the predictions in the ensemble are wighted by the quality of the nets
 #define DEFAULT_ENSEMBLE_QUALITY_CRITERION INDEX_METRIC_LOSS_W
 #define DEFAULT_ENSEMBLE_QUALITY_THRESHOLD 0.5 //threshold in the quality metric used for including a net in the ensemble or not
+#define NET_PLAN_BLOCK_ROWS 64 //instances predicted together by a NetPlan: each node is computed for every member and instance of the block before the next node
+#define NET_PLAN_MIN_BLOCK_ROWS 512 //minimum number of instances per thread when predicting a batch with a NetPlan
+#define KNOCKOUT_SUMMARY_RESULTS 10 //knockouts with the largest shifts reported in the summary of the knockout screening
+#define ATTRIBUTION_SUMMARY_RESULTS 10 //nodes and arcs with the largest mean absolute contributions reported in the summary of the attributions
 
 
 
@@ -226,7 +254,9 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 ///////////////////////////////////////////////////////////////////////////////////* TRAINING *///////////////////////////////////////////////////////////////////////////////////
 
 //=========================================================== DATASET ===========================================================
+#define DATA_MATRIX_ALIGNMENT 64 //bytes. Alignment of the dataset input rows (cache line, widest SIMD registers). Power of 2
 #define DEFAULT_DATASET_SPARSE_INVERTED true //if true, a compact list of indexes mean the inputs that are 0; if false, those that are 1. When converting a compact representation to a sparse one 
+#define DEFAULT_DATASET_COMBI_CHUNK_SIZE 10000 //number of input combinations generated at a time when streaming them
 #define DEFAULT_DATASET_COMBI_INVERTED true //if true, the "k" param of a combination means the number of 0s; if false, the number of 1s. When making all the posible inputs combinations with a given number of 0s (1s)
 #define DEFAULT_DATASET_CLASS_THRESHOLD 0.5 //threshold using for binarizing real output. Tipically 0.5
 #define DEFAULT_DATASET_TRAIN_VALSPLIT true //whether to make a validation split before start training a net for early stopping
@@ -235,6 +265,14 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define DEFAULT_DATASET_FILTER_INPUT 0 //default instance value to use for determining that one instance is a superset of another one when filterning by supersets
 #define DEFAULT_DATASET_FILTER_CLASS 0 //defualt output value to remove when filterning by supersets
 
+#define DEFAULT_DATASET_SIM_MATRIX false //whether to keep the pair-wise similarity matrices when weighting by similarity (only the dissimilarity sums are needed)
+#define DATASET_SIM_TILE 256 //number of reference instances compared at a time with each instance when adding up similarities. Keeps the packed reference tile in cache
+#define DATASET_SIM_MIN_BLOCK 16 //minimum number of instances per thread when adding up similarities
+#define DATASET_SIM_MODE_PAIRWISE 0 //add up the similarities pair by pair. O(N^2)
+#define DATASET_SIM_MODE_COUNTS 1 //add up the similarities from the per-class counts of each input. O(N * inputs)
+#define DEFAULT_DATASET_SIM_MODE DATASET_SIM_MODE_PAIRWISE //how to add up the similarities when weighting by similarity
+#define DEFAULT_DATASET_SIM_CHECK_NUM 0 //number of instances whose counts-mode sums are checked against the pair-wise ones. 0 = no check
+
 
 //=========================================================== POPULATION CREATOR =================================================
 #define DEFAULT_POPCREATOR_SCALE_MIN 0.0 //default minimum value for node scale
@@ -285,12 +323,48 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define PARSER_DATA_SEPARATOR ',' //separator char for dataset header and values
 #define PARSER_EQUAL '=' //char used for assigning params to values in the options file
 #define PARSER_COMMENT '/' //char used for started a comment (must be ignored by the parser)
+#define PARSER_NO_FILE "none" //value of a file name param that is not set
 #define PARSER_NET_ARCS_SEPARATOR '	' //separator used in the arc sentences in the net file, between node names and sign/weight value
 #define PARSER_NET_SCALES_SEPARATOR '	' //separator used in the scales file between the node name and the scale value
 #define PARSER_NET_ARCS_SIGN_NEG "NOT" //keyword used to indicate a negative sign in the arc sentences of untrained net file
 #define PARSER_NET_ARCS_SIGN_ANY "?" //keyword used to indicate an unknown sign in the arc sentences of untrained net file
 #define DEFAULT_PARSER_DATA_INPUTVALUE 0.0 //TODO ?
 
+#define PARSER_NET_MAX_ISSUES_PRINTED 10 //number of duplicate arcs, nodes in cycles and nodes not leading to the output reported by name when parsing a net file
+
+//---text dataset files
+#define PARSER_DATA_MIN_CHUNK_BYTES ( 1 << 20 ) //minimum size of the chunks a csv dataset file is split into for parsing them in parallel
+#define PARSER_DATA_CHUNKS_PER_THREAD 4 //chunks per thread when parsing a csv dataset file. More than 1 balances rows of different lengths
+#define PARSER_DATA_FAST_DIGITS 15 //integers with up to this number of digits are converted without strtod (exact in a double)
+#define PARSER_DATA_MAX_ERRORS_PRINTED 10 //number of malformed rows reported by line number when rejecting a csv dataset file
+#define PARSER_DATA_COMPACT_COLUMN "zero_inputs" //name of the last column of a compact csv file (FLAG_DATA_COMPACT): the space-separated indexes of the 0 inputs in the net input order
+#define COMBIS_FORMAT_TEXT 0 //input combinations are saved as csv rows with all the input values
+#define COMBIS_FORMAT_COMPACT 1 //input combinations are saved as compact csv rows and predicted from the index lists (SparseRows)
+
+//---binary dataset files
+#define PARSER_DATA_BINARY_MAGIC "GGDS" //first 4 bytes of a binary dataset file. Used for telling binary files from text files
+#define PARSER_DATA_BINARY_VERSION 1 //version of the binary dataset format. Files with other versions are rejected
+#define PARSER_DATA_BINARY_FLAG_WEIGHTS 1 //bit of the binary header flags set when the file includes instance weights
+#define DATASET_FORMAT_TEXT 0 //datasets and splits are read and saved as csv text files
+#define DATASET_FORMAT_BINARY 1 //datasets and splits are read and saved as memory-mapped binary files
+
+//---binary net files
+#define PARSER_NET_BINARY_MAGIC "GGNT" //first 4 bytes of a binary trained net file
+#define PARSER_NET_BINARY_VERSION 1 //version of the binary trained net format. Files with other versions are rejected
+#define NET_FORMAT_TEXT 0 //trained nets are saved as the three text files (structure and weights, scales, metrics)
+#define NET_FORMAT_BINARY 1 //trained nets are saved as a single binary file, loaded into a copy of the reference net
+#define NET_FORMAT_BOTH 2 //trained nets are saved in both formats (text as an export) and loaded from the binary file
+#define PARSER_ENSEMBLE_BINARY_MAGIC "GGEN" //first 4 bytes of an ensemble bundle file
+#define PARSER_ENSEMBLE_BINARY_VERSION 1 //version of the ensemble bundle format. Files with other versions are rejected
+
+//---prediction files
+#define PARSER_PRED_BINARY_MAGIC "GGPR" //first 4 bytes of a binary prediction file
+#define PARSER_PRED_BINARY_VERSION 1 //version of the binary prediction format. Files with other versions are rejected
+#define PARSER_PRED_MIN_BLOCK_ROWS 4096 //minimum number of records per thread when decoding a binary prediction file
+#define PREDICTION_FORMAT_TEXT 0 //combination predictions are saved as csv rows with all the input values
+#define PREDICTION_FORMAT_COMPACT 1 //combination predictions are saved as csv rows with the indexes of the 0 inputs instead of the input values
+#define PREDICTION_FORMAT_BINARY 2 //combination predictions are saved as fixed-size binary records with the inputs as bits
+
 //--flags
 #define FLAG_NULL static_cast<uint64_t>( 0 )
 //flags-data
@@ -299,6 +373,8 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define FLAG_DATA_ROUND FLAG(2) //whether the dataset file includes the output rounded = binarized
 #define FLAG_DATA_WEIGHT FLAG(3) //whether the dataset file includes instance weights
 #define FLAG_DATA_FILTER FLAG(4) //whether the dataset instances are filtered by output (only those in a range are kept)
+#define FLAG_DATA_COMPACT FLAG(5) //whether the inputs are printed as the space-separated indexes of the 0 inputs (DatasetBase::sparseData() representation, inputs binarized at 0.5) instead of their values. When parsing, whether they are loaded as index lists (SparseRows)
+#define FLAG_DATA_BINARY FLAG(6) //whether the predictions are printed as binary records (Parser::PredictionFileHeader) instead of text. The other flags but the filter do not apply
 #define FLAG_DATA_ALL FLAG_DATA_PRED | FLAG_DATA_COUNT | FLAG_DATA_ROUND //all the flags expected when parsing the dataset file (weighting is performed every run after parsing the dataset)
 #define FLAG_DATA_ALL_FILTER FLAG_DATA_ALL | FLAG_DATA_FILTER //all the flags expected when parsing the dataset file + filter
 #define DEFAULT_PARSER_FLAG_DATA FLAG_NULL //flags applied by default when parsing a dataset
@@ -320,6 +396,27 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 //---flags
 #define DEFAULT_EMITTER_FLAG_NET FLAG_NULL //flags applied by default when saving a net file
 #define DEFAULT_EMITTER_FLAG_DATA FLAG_NULL	//flags applied by default when saving a dataset file
+//flags-writer
+#define FLAG_WRITE_NEW FLAG(0) //the buffer starts the file (truncated) instead of being appended
+#define FLAG_WRITE_CLOSE FLAG(1) //the file is closed after writing the buffer. Otherwise it is kept open for the next buffers
+#define FLAG_WRITE_BINARY FLAG(2) //the file is opened in binary mode (no line break translation)
+
+//---async writer
+#define EMITTER_WRITER_MAX_QUEUED_BYTES ( 64 << 20 ) //bytes queued in the writer before the threads that queue more wait for the disk
+#define EMITTER_BUFFER_BYTES ( 1 << 20 ) //size of the pieces dataset files are queued in
+#define EMITTER_FORMAT_BATCH_ROWS ( 1 << 16 ) //dataset rows formatted in parallel at a time. Bounds the memory of the formatted text
+#define EMITTER_FORMAT_MIN_BLOCK_ROWS 2048 //minimum number of dataset rows per thread when formatting them
+
+
+//===========================================================  PREDICTION SERVER =================================================
+#define SERVER_BACKLOG 64 //connections waiting to be accepted
+#define SERVER_POLL_MS 100 //max time (ms) the server threads wait for a connection or data before checking whether they must stop
+#define SERVER_READ_BYTES ( 1 << 16 ) //bytes read from a connection at a time
+#define SERVER_MAX_LINE_BYTES ( 1 << 20 ) //longest line a client can send: the connection is closed instead of buffering more
+#define SERVER_LATENCY_WINDOW 100000 //number of last requests whose latencies make the percentiles
+#define SERVER_COMMAND_STATS "stats" //protocol line that asks for the stats
+#define SERVER_COMMAND_QUIT "quit" //protocol line that closes the connection
+#define SERVER_COMMAND_SHUTDOWN "shutdown" //protocol line that stops the server
 
 
 
@@ -341,11 +438,13 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 
 //---out file names
 #define DEFAULT_FILE_EXT ".txt"
+#define BINARY_FILE_EXT ".bin" //extension of the binary dataset and net files (replaces DEFAULT_FILE_EXT)
 //net
 #define FILE_NAME_NET "net" //reference untrained net
 #define FILE_NAME_NET_W "net_trained" //main trained net file with weight values
 #define FILE_NAME_NET_ACTI "net_trained_acti" //trained net file with node scales
 #define FILE_NAME_NET_METRICS "net_trained_metrics" //trained net file with validation metrics
+#define FILE_NAME_NET_ENSEMBLE "net_trained_ensemble" //ensemble bundle: parameters and metrics of netNum trained nets starting at netIndex
 #define FILE_NAME_NET_FF "netFF" //fully-connected feed-forward net untrained
 #define FILE_NAME_NET_CRAZY "netCrazy" //untrained net with input layer randomly swaped
 //dataset
@@ -356,10 +455,18 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define FILE_NAME_DATASET_W "dataset_w" //dataset with predictions. Predictions made in validation or test datasets while training or evaluating
 #define FILE_NAME_DATAPRED "dataset_pred" //dataset with predictions. Predictions made in validation or test datasets while training or evaluating
 #define FILE_NAME_DATAPRED_FINAL "dataset_pred_final" //dataset with predictions. Final predictions for input combinations
+#define FILE_NAME_DATAPRED_PART "dataset_pred_part" //dataset with predictions. Final predictions for one part of the input combinations
+#define FILE_NAME_DATAPRED_SEARCH "dataset_pred_search" //dataset with predictions. Input combinations found by branch-and-bound search
+#define FILE_NAME_THRESHOLD_CURVE "threshold_curve" //metrics of every class threshold of the predictions made in validation or test datasets
 //misc
 #define FILE_NAME_OPTIONS "options" //file with metrics summary depending on the program
 #define FILE_NAME_RESULT "summary" //file with metrics summary depending on the program
 #define FILE_NAME_HISTORICAL "historical" //file with the historical evolution of quality metrics //TODO
+#define FILE_NAME_ENSEMBLE_SWEEP "ensemble_sweep" //table with the ensemble metrics of each criterion, threshold and weighting
+#define FILE_NAME_KNOCKOUTS "knockouts" //table with the shift of the predictions and metrics of each node and arc knocked out
+#define FILE_NAME_ATTRIBUTIONS "attributions" //matrix with the contribution of each node to the prediction of each instance
+#define FILE_NAME_ATTRIBUTION_SUMMARY "attribution_summary" //table with the contribution of each node and arc over the instances
+#define FILE_NAME_SERVER_SOCKET "graphgann.sock" //Unix domain socket of the prediction server (serveUnixSocket = 1), in the run directory
 
 
 //---complete input files-parser
@@ -376,6 +483,7 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define OUTFILE_NET_W ( FOLDER_RESULTS_NETS + FILE_NAME_NET_W  ) //main trained net file with weight values
 #define OUTFILE_NET_ACTI ( FOLDER_RESULTS_NETS + FILE_NAME_NET_ACTI ) //trained net file with node scales
 #define OUTFILE_NET_METRICS ( FOLDER_RESULTS_NETS + FILE_NAME_NET_METRICS ) //trained net file with validation metrics
+#define OUTFILE_NET_ENSEMBLE ( FOLDER_RESULTS_NETS + FILE_NAME_NET_ENSEMBLE ) //ensemble bundle
 
 //dataset
 #define OUTFILE_DATASPLIT_TRAIN ( FOLDER_DATA_SPLITS + FILE_NAME_DATASPLIT_TRAIN ) //dataset training + validation split
@@ -383,10 +491,17 @@ for( uint v = 0; v < (vector).size(); v++ ) \
 #define OUTFILE_INPUTCOMBIS ( FOLDER_DATA_COMBIS + FILE_NAME_INPUTCOMBIS )  //dataset all input combinations for prediction
 #define OUTFILE_DATAPRED ( FOLDER_RESULTS_PREDICTIONS + FILE_NAME_DATAPRED  ) //dataset with predictions. Predictions made in validation or test datasets while training or evaluating
 #define OUTFILE_DATAPRED_FINAL ( FOLDER_RESULTS_PREDICTIONS + FILE_NAME_DATAPRED_FINAL  ) //dataset with predictions. Final predictions for input combinations
+#define OUTFILE_DATAPRED_PART ( FOLDER_RESULTS_PREDICTIONS + FILE_NAME_DATAPRED_PART  ) //dataset with predictions. Final predictions for one part of the input combinations
+#define OUTFILE_DATAPRED_SEARCH ( FOLDER_RESULTS_PREDICTIONS + FILE_NAME_DATAPRED_SEARCH  ) //dataset with predictions. Input combinations found by branch-and-bound search
+#define OUTFILE_THRESHOLD_CURVE ( FOLDER_RESULTS_PREDICTIONS + FILE_NAME_THRESHOLD_CURVE ) //metrics of every class threshold: accuracies, ROC and precision-recall curves
 
 //misc
 #define OUTFILE_RESULT ( FOLDER_RESULTS + FILE_NAME_RESULT + DEFAULT_FILE_EXT  ) //file with metrics summary depending on the program
 #define OUTFILE_HISTORICAL ( FOLDER_RESULTS_HISTORICAL + FILE_NAME_HISTORICAL  ) //file with the historical evolution of quality metrics //TODO
+#define OUTFILE_ENSEMBLE_SWEEP ( FOLDER_RESULTS + FILE_NAME_ENSEMBLE_SWEEP + DEFAULT_FILE_EXT ) //table made by progSweepEnsemble()
+#define OUTFILE_KNOCKOUTS ( FOLDER_RESULTS + FILE_NAME_KNOCKOUTS + DEFAULT_FILE_EXT ) //table made by progKnockoutScreen()
+#define OUTFILE_ATTRIBUTIONS ( FOLDER_RESULTS + FILE_NAME_ATTRIBUTIONS + DEFAULT_FILE_EXT ) //matrix made by progAttribution()
+#define OUTFILE_ATTRIBUTION_SUMMARY ( FOLDER_RESULTS + FILE_NAME_ATTRIBUTION_SUMMARY + DEFAULT_FILE_EXT ) //table made by progAttribution()
 #define FILE_NET_FF ( FOLDER_DATA + FILE_NAME_NET_FF + DEFAULT_FILE_EXT )  //fully-connected feed-forward net untrained
 #define FILE_NET_CRAZY ( FOLDER_DATA + FILE_NAME_NET_CRAZY + DEFAULT_FILE_EXT ) //untrained net with input layer randomly swaped
 
@@ -13,4 +13,23 @@ double Arc::forwardProp() //cannot be inlined due to consequent circular include
 			result *= std::pow( parents[p]->forwardProp(), exponents[p] );
 	}
 	return result;
+}
+
+void Arc::forwardPropBounds( double& lOutput, double& uOutput ) //cannot be inlined due to consequent circular include with Node
+///node values are never negative (binary inputs and non-negative activation functions), so the product of powers is monotonic in every parent and the weight sign decides the order of the bounds
+{
+	double lProduct = 1.0;
+	double uProduct = 1.0;
+	for( uint p = 0; p < parents.size(); p++ )
+	{
+		if( parents[p] != nullptr )
+		{
+			double lParent, uParent;
+			parents[p]->forwardPropBounds( lParent, uParent );
+			lProduct *= std::pow( lParent, exponents[p] );
+			uProduct *= std::pow( uParent, exponents[p] );
+		}
+	}
+	lOutput = weight >= 0.0 ? weight * lProduct : weight * uProduct;
+	uOutput = weight >= 0.0 ? weight * uProduct : weight * lProduct;
 }
\ No newline at end of file
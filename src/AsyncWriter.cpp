@@ -0,0 +1,159 @@
+#include "AsyncWriter.hpp"
+
+#include <cstdio> //snprintf in appendNumber()
+#include <cmath> //std::signbit in appendNumber()
+#include <iostream> //failed files in flush()
+
+
+//////////////////////////////////////////////////////////////////////////* STATIC *///////////////////////////////////////////////////////////////////////////////////////////////
+void AsyncWriter::appendNumber( std::string& buffer, double value )
+{
+//---integer values (0/1 inputs and outputs are most of a dataset file) are written directly. Under 1e6 %g writes them with no exponent
+    if( value > -1e6 && value < 1e6 && value == static_cast<double>( static_cast<int64_t>( value ) ) && ! ( value == 0.0 && std::signbit( value ) ) )
+    {
+        if( value < 0.0 )
+            buffer.push_back( '-' );
+        appendNumber( buffer, static_cast<uint64_t>( value < 0.0 ? -value : value ) );
+        return;
+    }
+    char digits[32];
+    int length = std::snprintf( digits, sizeof( digits ), "%g", value ); //what std::ostream uses with the default flags and precision
+    buffer.append( digits, length );
+}
+
+void AsyncWriter::appendNumber( std::string& buffer, uint64_t value )
+{
+    char digits[20];
+    uint length = 0;
+    do
+    {
+        digits[ length++ ] = '0' + value % 10;
+        value /= 10;
+    } while( value > 0 );
+    while( length > 0 )
+        buffer.push_back( digits[ --length ] );
+}
+
+bool AsyncWriter::writeFile( const std::string& fileName, const std::string& buffer, uint64_t options )
+{
+    std::ofstream file ( fileName, ( GET_FLAG( options, FLAG_WRITE_NEW ) ? std::ios_base::trunc : std::ios_base::app ) | ( GET_FLAG( options, FLAG_WRITE_BINARY ) ? std::ios_base::binary : std::ios_base::out ) | std::ios_base::out );
+    if( ! file.is_open() )
+        return false;
+    file.write( buffer.data(), buffer.size() );
+    file.close();
+    return file.good();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* INSTANCE *///////////////////////////////////////////////////////////////////////////////////////////////
+AsyncWriter::AsyncWriter( size_t maxQueuedBytes )
+: maxQueuedBytes(maxQueuedBytes), queuedBytes(0), bWriting(false), bStop(false)
+{
+    writerThread = std::thread( &AsyncWriter::run, this );
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    flush(); //reports the failed files
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        bStop = true;
+    }
+    queueCondition.notify_one();
+    writerThread.join();
+}
+
+void AsyncWriter::write( const std::string& fileName, std::string&& buffer, uint64_t options )
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    doneCondition.wait( lock, [this]() { return queuedBytes < maxQueuedBytes; } ); //a single buffer bigger than the bound is still accepted
+    queuedBytes += buffer.size();
+    requests.push_back( Request{ fileName, std::move( buffer ), options } );
+    lock.unlock();
+    queueCondition.notify_one();
+}
+
+bool AsyncWriter::flush()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    requests.push_back( Request{ std::string(), std::string(), FLAG_NULL } ); //empty name: flush the open files
+    queueCondition.notify_one();
+    doneCondition.wait( lock, [this]() { return requests.empty() && ! bWriting; } );
+
+    for( uint f = 0; f < failedFileNames.size(); f++ )
+        std::cout << "Error: cannot write " << failedFileNames[f] << "\n";
+    bool bGood = failedFileNames.empty();
+    failedFileNames.clear();
+    return bGood;
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+void AsyncWriter::run()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    while( true )
+    {
+        queueCondition.wait( lock, [this]() { return ! requests.empty() || bStop; } );
+        if( requests.empty() ) //stopped
+            break;
+
+    //---write out of the lock, so that producers can keep queueing
+        Request request = std::move( requests.front() );
+        requests.pop_front();
+        queuedBytes -= request.buffer.size();
+        bWriting = true;
+        lock.unlock();
+        doneCondition.notify_all();
+        std::vector<std::string> requestFailedFileNames;
+        writeRequest( request, requestFailedFileNames );
+        lock.lock();
+        bWriting = false;
+        failedFileNames.insert( failedFileNames.end(), requestFailedFileNames.begin(), requestFailedFileNames.end() );
+        doneCondition.notify_all();
+    }
+
+//---close the files left open
+    for( std::map<std::string, std::shared_ptr<std::ofstream>>::iterator f = files.begin(); f != files.end(); f++ )
+    {
+        f->second->close();
+        if( ! f->second->good() )
+            std::cout << "Error: cannot write " << f->first << "\n";
+    }
+    files.clear();
+}
+
+void AsyncWriter::writeRequest( const Request& request, std::vector<std::string>& requestFailedFileNames )
+{
+    if( request.fileName.empty() ) //flush request
+    {
+        for( std::map<std::string, std::shared_ptr<std::ofstream>>::iterator f = files.begin(); f != files.end(); f++ )
+        {
+            if( ! f->second->flush().good() )
+                requestFailedFileNames.push_back( f->first );
+        }
+        return;
+    }
+
+//---open (or start again) the file
+    std::shared_ptr<std::ofstream>& file = files[ request.fileName ];
+    if( file == nullptr || GET_FLAG( request.options, FLAG_WRITE_NEW ) )
+    {
+        if( file != nullptr )
+            file->close();
+        file = std::make_shared<std::ofstream>( request.fileName, ( GET_FLAG( request.options, FLAG_WRITE_NEW ) ? std::ios_base::trunc : std::ios_base::app ) | ( GET_FLAG( request.options, FLAG_WRITE_BINARY ) ? std::ios_base::binary : std::ios_base::out ) | std::ios_base::out );
+    }
+
+    bool bGood = file->is_open();
+    if( bGood )
+    {
+        file->write( request.buffer.data(), request.buffer.size() );
+        if( GET_FLAG( request.options, FLAG_WRITE_CLOSE ) )
+            file->close();
+        bGood = file->good();
+    }
+    if( ! bGood )
+        requestFailedFileNames.push_back( request.fileName );
+    if( ! bGood || GET_FLAG( request.options, FLAG_WRITE_CLOSE ) )
+        files.erase( request.fileName );
+}
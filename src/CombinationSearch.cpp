@@ -0,0 +1,147 @@
+#include "CombinationSearch.hpp"
+
+#include <algorithm> //std::push_heap, std::pop_heap, std::sort in results
+#include <sstream> //makeSummary()
+
+
+void CombinationSearch::search( uint inputNum )
+{
+//---init: all the inputs undecided
+    lInputs.assign( inputNum, 0.0 );
+    uInputs.assign( inputNum, 1.0 );
+    results.clear();
+    inputs.clear();
+    outputs.clear();
+    visitedNum = 0;
+    prunedNum = 0;
+    leafNum = 0;
+
+//---filter index: same criteria as DatasetBase::filterInstancesEqual() and filterInstancesSuperset()
+    filterIndex = InstanceFilterIndex();
+    switch( filterDataset != nullptr ? params.filterMode : 0 ) //as MainClass::makeCombinationsFilter(): mode 1 removes the equal ones and the supersets
+    {
+        case 1: //remove equal
+            filterIndex.indexEqual( filterDataset ); //fall through - also remove the supersets
+        case 2: //remove supersets
+            filterIndex.indexSupersets( filterDataset, params.filterInput, params.filterClass );
+            break;
+        default: //no filter
+            break;
+    }
+
+//---search
+    if( params.zerosNum <= inputNum )
+        searchRec( 0, params.zerosNum );
+
+//---results. Threshold mode: already in lexicographic order. Top K mode: sort from best to worst
+    if( params.topK > 0 )
+        std::sort( results.begin(), results.end(), [this]( const std::pair<double, std::vector<double>>& a, const std::pair<double, std::vector<double>>& b ) { return key( a.first ) > key( b.first ); } );
+    for( uint r = 0; r < results.size(); r++ )
+    {
+        outputs.push_back( results[r].first );
+        inputs.push_back( results[r].second );
+    }
+    results.clear();
+}
+
+std::string CombinationSearch::makeSummary() const
+{
+//---total number of combinations C(n, k). As double to avoid overflow
+    double combinationNum = 1.0;
+    for( uint i = 0; i < params.zerosNum && i < lInputs.size(); i++ )
+        combinationNum = combinationNum * ( lInputs.size() - i ) / ( i + 1 );
+
+    std::stringstream summary;
+    summary << "combination search: " << leafNum << " of " << combinationNum << " combinations predicted, " << visitedNum << " partial assignments bounded, " << prunedNum << " pruned, " << outputs.size() << " kept";
+    return summary.str();
+}
+
+
+//========================================================== PRIVATE ==========================================================
+void CombinationSearch::searchRec( uint inputIndex, uint zerosLeft )
+{
+    uint remainingNum = lInputs.size() - inputIndex;
+    if( zerosLeft == 0 || zerosLeft == remainingNum ) //the rest of the inputs are forced: complete combination
+    {
+        for( uint i = inputIndex; i < lInputs.size(); i++ )
+            lInputs[i] = uInputs[i] = ( zerosLeft == 0 ? 1.0 : 0.0 );
+        evaluateLeaf();
+        for( uint i = inputIndex; i < lInputs.size(); i++ ) //undo
+        {
+            lInputs[i] = 0.0;
+            uInputs[i] = 1.0;
+        }
+        return;
+    }
+
+//---bound both children. Value 0 first keeps the lexicographic order of DatasetBase::makeAllCombinations()
+    double childValues[2] = { 0.0, 1.0 };
+    uint childZerosLeft[2] = { zerosLeft - 1, zerosLeft };
+    bool bChildLeaf[2]; //complete combinations are predicted directly: bounding them costs the same as predicting them
+    double lOutputs[2], uOutputs[2];
+    for( uint v = 0; v < 2; v++ )
+    {
+        bChildLeaf[v] = childZerosLeft[v] == 0 || childZerosLeft[v] == remainingNum - 1;
+        if( bChildLeaf[v] )
+            continue;
+        lInputs[inputIndex] = uInputs[inputIndex] = childValues[v];
+        net->predictBounds( lInputs, uInputs, lOutputs[v], uOutputs[v] );
+        visitedNum++;
+    }
+    uint order[2] = { 0, 1 };
+    if( params.topK > 0 && ! bChildLeaf[0] && ! bChildLeaf[1] && key( params.bTopKHighest ? uOutputs[1] : lOutputs[1] ) > key( params.bTopKHighest ? uOutputs[0] : lOutputs[0] ) ) //top K mode: most promising child first so the heap fills with good values and prunes more
+        std::swap( order[0], order[1] );
+
+//---go deeper into the children that cannot be pruned
+    for( uint o = 0; o < 2; o++ )
+    {
+        uint v = order[o];
+        lInputs[inputIndex] = uInputs[inputIndex] = childValues[v];
+        if( bChildLeaf[v] )
+            searchRec( inputIndex + 1, childZerosLeft[v] );
+        else if( bPrune( lOutputs[v], uOutputs[v] ) || bSupersetFiltered() ) //bPrune() is checked here and not before because the heap may have changed
+            prunedNum++;
+        else
+            searchRec( inputIndex + 1, childZerosLeft[v] );
+    }
+    lInputs[inputIndex] = 0.0; //undo
+    uInputs[inputIndex] = 1.0;
+}
+
+void CombinationSearch::evaluateLeaf()
+{
+//---filters
+    if( filterIndex.find( lInputs ) )
+        return;
+
+//---predict: with equal bounds the interval pass is the ordinary forward pass
+    double output, uOutput;
+    net->predictBounds( lInputs, uInputs, output, uOutput );
+    leafNum++;
+
+    if( params.topK == 0 ) //threshold mode
+    {
+        if( output >= params.thresholdL && output <= params.thresholdU )
+            results.push_back( std::make_pair( output, lInputs ) );
+        return;
+    }
+//---top K mode: min-heap by key with the worst kept combination at front
+    auto compare = [this]( const std::pair<double, std::vector<double>>& a, const std::pair<double, std::vector<double>>& b ) { return key( a.first ) > key( b.first ); };
+    if( results.size() == params.topK )
+    {
+        if( key( output ) <= key( results.front().first ) )
+            return;
+        std::pop_heap( results.begin(), results.end(), compare );
+        results.pop_back();
+    }
+    results.push_back( std::make_pair( output, lInputs ) );
+    std::push_heap( results.begin(), results.end(), compare );
+}
+
+bool CombinationSearch::bPrune( double lOutput, double uOutput ) const
+{
+    if( params.topK == 0 ) //threshold mode: the interval does not intersect the thresholds
+        return uOutput < params.thresholdL || lOutput > params.thresholdU;
+    //top K mode: the heap is full and the best possible output is not better than the worst kept
+    return results.size() == params.topK && key( params.bTopKHighest ? uOutput : lOutput ) <= key( results.front().first );
+}
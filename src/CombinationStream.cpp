@@ -0,0 +1,111 @@
+#include "CombinationStream.hpp"
+
+#include <algorithm> //std::next_permutation in nextChunk()
+
+
+//////////////////////////////////////////////////////////////////////////* STATIC *///////////////////////////////////////////////////////////////////////////////////////////////
+uint64_t CombinationStream::binomial( uint n, uint k )
+{
+    if( k > n )
+        return 0;
+    if( k > n - k ) //symmetry: fewer iterations and less overflow risk
+        k = n - k;
+
+    uint64_t result = 1;
+    for( uint i = 0; i < k; i++ ) //C(n, i + 1) = C(n, i) * (n - i) / (i + 1) is always an integer
+    {
+    //---divide before multiplying to overflow only if the result does not fit
+        uint64_t a = result, b = i + 1;
+        while( b != 0 ) //gcd( result, i + 1 )
+        {
+            uint64_t r = a % b;
+            a = b;
+            b = r;
+        }
+        uint64_t factor = ( n - i ) / ( ( i + 1 ) / a ); //exact: ( i + 1 ) / gcd divides ( n - i )
+        result /= a;
+        if( result > UINT64_MAX / factor ) //overflow
+            return 0;
+        result *= factor;
+    }
+    return result;
+}
+
+void CombinationStream::partRange( uint64_t combinationNum, uint partIndex, uint partNum, uint64_t& first, uint64_t& last )
+{
+    uint64_t partSize = combinationNum / partNum;
+    uint64_t remainder = combinationNum % partNum; //the first parts get one more combination
+    first = partIndex * partSize + std::min<uint64_t>( partIndex, remainder );
+    last = first + partSize + ( partIndex < remainder ? 1 : 0 );
+}
+
+
+//////////////////////////////////////////////////////////////////////////* INSTANCE *///////////////////////////////////////////////////////////////////////////////////////////////
+CombinationStream::CombinationStream( uint n, uint k, bool bInverted, uint64_t first, uint64_t last )
+: n(n), zerosNum( bInverted ? k : n - k ), combinationNum( binomial( n, k ) ), first(first), last(last), current(first)
+{
+    if( combinationNum == 0 && k <= n )
+        std::cout << "Error: too many combinations of " << n << " elements taken " << k << " at a time\n";
+    if( CombinationStream::last > combinationNum )
+        CombinationStream::last = combinationNum;
+    if( CombinationStream::first > CombinationStream::last )
+        CombinationStream::first = CombinationStream::last;
+    current = CombinationStream::first;
+}
+
+std::vector<double> CombinationStream::unrank( uint64_t rank ) const
+///lexicographic order: at each position, the combinations with a 0 there come before those with a 1. There are C(remaining positions, remaining 0s - 1) of the former
+{
+    std::vector<double> combination( n, 1.0 );
+    uint zerosLeft = zerosNum;
+    for( uint i = 0; i < n && zerosLeft > 0; i++ )
+    {
+        if( zerosLeft == n - i ) //the rest are forced to 0
+        {
+            for( uint j = i; j < n; j++ )
+                combination[j] = 0.0;
+            break;
+        }
+        uint64_t withZero = binomial( n - i - 1, zerosLeft - 1 );
+        if( rank < withZero )
+        {
+            combination[i] = 0.0;
+            zerosLeft--;
+        }
+        else
+            rank -= withZero;
+    }
+    return combination;
+}
+
+uint64_t CombinationStream::rank( const std::vector<double>& combination ) const
+{
+    uint64_t result = 0;
+    uint zerosLeft = zerosNum;
+    for( uint i = 0; i < n && zerosLeft > 0; i++ )
+    {
+        if( combination[i] < 0.5 )
+            zerosLeft--;
+        else
+            result += binomial( n - i - 1, zerosLeft - 1 ); //skip all the combinations with a 0 here
+    }
+    return result;
+}
+
+bool CombinationStream::nextChunk( std::vector<std::vector<double>>& chunk, uint chunkSize )
+{
+    chunk.clear();
+    if( current >= last )
+        return false;
+
+    if( currentCombination.empty() ) //jump to the start of the range once, then iterate
+        currentCombination = unrank( current );
+
+    while( current < last && chunk.size() < chunkSize )
+    {
+        chunk.push_back( currentCombination );
+        current++;
+        std::next_permutation( currentCombination.begin(), currentCombination.end() );
+    }
+    return true;
+}
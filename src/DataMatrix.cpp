@@ -0,0 +1,86 @@
+#include "DataMatrix.hpp"
+
+
+DataMatrix::DataMatrix( uint rowNum, uint colNum, double value )
+: rowNum(rowNum), colNum(colNum), stride( makeStride( colNum ) ), block( std::make_shared<Block>() )
+{
+    block->values.resize( static_cast<size_t>( rowNum ) * stride, 0.0 );
+    for( uint r = 0; r < rowNum; r++ )
+        std::fill( row( r ), row( r ) + colNum, value ); //padding stays 0
+}
+
+DataMatrix::DataMatrix( const std::vector<std::vector<double>>& rows )
+: rowNum( rows.size() ), colNum( rows.empty() ? 0 : rows[0].size() ), stride( makeStride( colNum ) ), block( std::make_shared<Block>() )
+{
+    block->values.resize( static_cast<size_t>( rowNum ) * stride, 0.0 );
+    for( uint r = 0; r < rowNum; r++ )
+        std::copy( rows[r].begin(), rows[r].end(), row( r ) );
+}
+
+DataMatrix::DataMatrix( const double* values, uint rowNum, uint colNum, uint stride, const std::shared_ptr<const void>& owner )
+: rowNum(rowNum), colNum(colNum), stride(stride), block( std::make_shared<Block>() )
+{
+    block->external = values;
+    block->owner = owner;
+}
+
+void DataMatrix::appendRow( const InputSpan& newRow )
+{
+    std::vector<double> temp = newRow.toVector(); //the span may point into this matrix, which may be reallocated
+    makeOwn();
+    if( rowNum == 0 )
+    {
+        colNum = newRow.size();
+        stride = makeStride( colNum );
+    }
+    block->values.resize( static_cast<size_t>( rowNum + 1 ) * stride, 0.0 );
+    std::copy( temp.begin(), temp.end(), row( rowNum ) );
+    rowNum++;
+}
+
+DataMatrix DataMatrix::gather( const std::vector<uint>& rowIndexes ) const
+{
+    std::shared_ptr<std::vector<uint>> newOrder = std::make_shared<std::vector<uint>>( rowIndexes.size() );
+    for( uint r = 0; r < rowIndexes.size(); r++ )
+        (*newOrder)[r] = order ? (*order)[ rowIndexes[r] ] : rowIndexes[r]; //compose with the order of this view
+
+    DataMatrix result( *this );
+    result.rowNum = rowIndexes.size();
+    result.order = newOrder;
+    return result;
+}
+
+DataMatrix DataMatrix::compact() const
+{
+    DataMatrix result;
+    result.rowNum = rowNum;
+    result.colNum = colNum;
+    result.stride = stride;
+    result.block->values.resize( static_cast<size_t>( rowNum ) * stride );
+    for( uint r = 0; r < rowNum; r++ )
+        std::copy( row( r ), row( r ) + stride, result.block->values.data() + static_cast<size_t>( r ) * stride );
+    return result;
+}
+
+bool DataMatrix::isBinary() const
+{
+    for( uint r = 0; r < rowNum; r++ )
+    {
+        const double* values = row( r );
+        for( uint i = 0; i < colNum; i++ )
+        {
+            if( values[i] != 0.0 && values[i] != 1.0 )
+                return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<double>> DataMatrix::toRows() const
+{
+    std::vector<std::vector<double>> rows;
+    rows.reserve( rowNum );
+    for( uint r = 0; r < rowNum; r++ )
+        rows.push_back( ( *this )[r].toVector() );
+    return rows;
+}
@@ -4,61 +4,19 @@
 
 ////////////////////////////////////////////////////////////////////////////* DATASET */////////////////////////////////////////////////////////////////////////////
 
-//======================================================================= INSTANCE WEIGHTING =============================================================================
-void Dataset::dissimilaritySubsets()
-{
-	for( uint s = 0; s < foldsTraining.size(); s++ )
-	{
-		foldsTraining[s]->makeSimilarityMatrix(); //for training folds, similarity relative to self
-		foldsTraining[s]->dissimilarityAsInstanceWeights();
-
-		foldsTest[s]->makeSimilarityMatrix( foldsTraining[s].get() ); //for test folds, similarity relative to corresponding train fold
-		foldsTest[s]->relativeDissimilarityAsInstanceWeights();
-	}
-}
-//======================================================================= end of INSTANCE WEIGHTING =============================================================================
-
-
-
-
 //======================================================================= DATA SPLITS =============================================================================
 void Dataset::leaveOneOut()
 {	
-	foldsTraining.clear();
-	foldsTest.clear();
-
+//---test split is a single instance, train split is all the instances but the test instance
+	std::vector<std::pair<uint, uint>> testRanges;
 	for( uint c = 0; c < inputs.size(); c++ )
-	{
-	//---test split is a single instance
-		std::vector<std::vector<double>> testInputs = { inputs[c] };
-		std::vector<double> testOutputs = { outputs[c] };
-		std::vector<double> testInstanceWeights = { instanceWeights[c] };
-
-	//---train split is all the instances but the test instance
-		std::vector<std::vector<double>> trainInputs = inputs;
-		std::vector<double> trainOutputs = outputs;
-		std::vector<double> trainInstanceWeights = instanceWeights;
-
-		trainInputs.erase( trainInputs.begin() + c );
-		trainOutputs.erase( trainOutputs.begin() + c );
-		trainInstanceWeights.erase( trainInstanceWeights.begin() + c );
-
-	//---create the child Datasets
-		foldsTraining.push_back( std::make_shared<Dataset>( trainInputs, trainOutputs, trainInstanceWeights, classThreshold ) );
-		foldsTest.push_back( std::make_shared<Dataset>( testInputs, testOutputs, testInstanceWeights, classThreshold ) );
-		foldsTraining.back()->makeBoolOutputs();
-		foldsTraining.back()->normalizeInstanceWeights();
-		foldsTest.back()->makeBoolOutputs();
-		foldsTest.back()->normalizeInstanceWeights();
-	}
-	initKFold( foldsTraining.size() );
+		testRanges.push_back( std::make_pair( c, c + 1 ) );
+
+	setFolds( {}, testRanges );
 }
 
 void Dataset::makeSingleFold( RandomEngine& randomEngine, uint instanceNum )
 {
-	foldsTraining.clear();
-	foldsTest.clear();
-
 //---split all the cases in 2 vectors based on their output
 	std::vector<uint> indexVector0;
 	std::vector<uint> indexVector1;
@@ -108,41 +66,29 @@ void Dataset::makeSingleFold( RandomEngine& randomEngine, uint instanceNum )
 		std::cout << indexVectorTest[c] << ",";
 	std::cout << "\n ";*/
 
-//---split inputs, outptus and instance weights into train and test according to the two index vectors
-	std::vector<std::vector<double>> inputsTraining;
-	std::vector<double> outputsTraining;
-	std::vector<double> instanceWeightsTraining;
-
-	std::vector<std::vector<double>> inputsTest;
-	std::vector<double> outputsTest;
-	std::vector<double> instanceWeightsTest;
+//---order the cases as train then test according to the test index vector, keeping the dataset order within each. O(N) with a mask
+	std::vector<bool> bTest( inputs.size(), false );
+	for( uint i = 0; i < indexVectorTest.size(); i++ )
+		bTest[ indexVectorTest[i] ] = true;
 
+	std::vector<uint> order;
 	for( uint d = 0; d < inputs.size(); d++ )
 	{
-		if( std::find( indexVectorTest.begin(), indexVectorTest.end(), d ) != indexVectorTest.end() )
-		{
-			inputsTest.push_back( inputs[d] );
-			outputsTest.push_back( outputs[d] );
-			instanceWeightsTest.push_back( instanceWeights[d] );
-		}
-		else
-		{
-			inputsTraining.push_back( inputs[d] );
-			outputsTraining.push_back( outputs[d] );
-			instanceWeightsTraining.push_back( instanceWeights[d] );
-		}
+		if( ! bTest[d] )
+			order.push_back( d );
+	}
+	uint trainingNum = order.size();
+	for( uint d = 0; d < inputs.size(); d++ )
+	{
+		if( bTest[d] )
+			order.push_back( d );
 	}
 
-//---create child train and test Dataset
-	foldsTraining.push_back( std::make_shared<Dataset>( inputsTraining, outputsTraining, instanceWeightsTraining, classThreshold ) );
-	foldsTraining[0]->makeBoolOutputs();
-	foldsTraining[0]->normalizeInstanceWeights();
-	foldsTest.push_back( std::make_shared<Dataset>( inputsTest, outputsTest, instanceWeightsTest, classThreshold ) );
-	foldsTest[0]->makeBoolOutputs();
-	foldsTest[0]->normalizeInstanceWeights();
+//---the single fold tests with the last cases
+	setFolds( order, { std::make_pair( trainingNum, order.size() ) } );
 
 //---if previously weighted by similarity, weight the subsets by similarity
-	if( similarityMatrix.size() > 0 )
+	if( bSimilarityWeighted )
 		dissimilaritySubsets();
 }
 
@@ -150,10 +96,6 @@ void Dataset::makeStratifiedKFold( RandomEngine& randomEngine, uint k )
 {
 	//may be unified with makeSingleFold() because they have some code in common
 
-	foldsTraining.clear();
-	foldsTest.clear();
-	initKFold( k );
-
 //---split all the cases in 2 vectors based on their output
 	std::vector<uint> indexVector0;
 	std::vector<uint> indexVector1;
@@ -205,67 +147,90 @@ void Dataset::makeStratifiedKFold( RandomEngine& randomEngine, uint k )
 	indexVectorFolds.back().insert( indexVectorFolds.back().end(), indexVector0.begin(), indexVector0.end() ); //add the remaining instances to the end
 
 //---sort the whole dataset inputs, outputs and instance weights by the index vectors
-	std::vector<std::vector<double>> newInputs;
-	std::vector<double> newOutputs;
-	std::vector<double> newInstanceWeights;
-
+	std::vector<uint> indexVectorSorted;
 	for( uint f = 0; f < indexVectorFolds.size(); f++ )
 	{
 		//std::cout << "fold " << f << ": ";
 		for( uint i = 0; i < indexVectorFolds[f].size(); i++ )
 		{
 			//std::cout << indexVectorFolds[f][i] << ",";
-			newInputs.push_back( inputs[ indexVectorFolds[f][i] ] );
-			newOutputs.push_back( outputs[ indexVectorFolds[f][i] ] );
-			newInstanceWeights.push_back( instanceWeights[ indexVectorFolds[f][i] ] );
+			indexVectorSorted.push_back( indexVectorFolds[f][i] );
 		}
 		//std::cout << "\n";
 	}
-	inputs = newInputs;
-	outputs = newOutputs;
-	instanceWeights = newInstanceWeights;
-	makeBoolOutputs();
+	sortByIndexVector( indexVectorSorted );
 
 
-	for( uint f = 0; f < k; f++ ) //for each fold
-	{
-	//---split inputs, outptus and instance weights into train and test according to each fold's index range
-		std::vector<std::vector<double>> inputsTest;
-		std::vector<double> outputsTest;
-		std::vector<double> instanceWeightsTest;
+//---each fold tests with its index range of the sorted dataset and trains with the rest
+	uint testNum = inputs.size() / k;
+	std::vector<std::pair<uint, uint>> testRanges;
+	for( uint f = 0; f < k; f++ )
+		testRanges.push_back( std::make_pair( f * testNum, f * testNum + testNum ) );
+	setFolds( {}, testRanges );
 
-		std::vector<std::vector<double>> inputsTraining;
-		std::vector<double> outputsTraining;
-		std::vector<double> instanceWeightsTraining;
+//---if previously weighted by similarity, weight the subsets by similarity
+	if( bSimilarityWeighted )
+		dissimilaritySubsets();
+}
 
-		uint startIntex = f * foldSize;
+void Dataset::setFolds( const std::vector<uint>& xFoldOrder, const std::vector<std::pair<uint, uint>>& xFoldTestRanges )
+{
+	foldOrder = xFoldOrder;
+	foldTestRanges = xFoldTestRanges;
+	bFoldsBySimilarity = false;
+	initKFold( foldTestRanges.size() );
+}
 
-		for( uint d = 0; d < inputs.size(); d++ )
-		{
-			if( d < startIntex || d >= ( startIntex + foldSize ) )
-			{
-				inputsTraining.push_back( inputs[d] );
-				outputsTraining.push_back( outputs[d] );
-				instanceWeightsTraining.push_back( instanceWeights[d] );
-			}
-			else
-			{
-				inputsTest.push_back( inputs[d] );
-				outputsTest.push_back( outputs[d] );
-				instanceWeightsTest.push_back( instanceWeights[d] );
-			}
-		}
-	//---create child train and test Dataset
-		foldsTraining.push_back( std::make_shared<Dataset>( inputsTraining, outputsTraining, instanceWeightsTraining, classThreshold ) );
-		foldsTraining.back()->makeBoolOutputs();
-		foldsTraining.back()->normalizeInstanceWeights();
-		foldsTest.push_back( std::make_shared<Dataset>( inputsTest, outputsTest, instanceWeightsTest, classThreshold ) );
-		foldsTest.back()->makeBoolOutputs();
-		foldsTest.back()->normalizeInstanceWeights();
+void Dataset::makeCurrentFold()
+{
+	foldTraining = nullptr; //the previous fold is released before making the new one
+	foldTest = nullptr;
+	if( currentTestFold >= foldTestRanges.size() ) //no folds
+		return;
+
+//---split the cases of the fold order by the test range
+	uint first = foldTestRanges[currentTestFold].first;
+	uint second = foldTestRanges[currentTestFold].second;
+	uint orderSize = foldOrder.empty() ? inputs.size() : foldOrder.size();
+	std::vector<uint> indexesTraining;
+	std::vector<uint> indexesTest;
+	for( uint p = 0; p < orderSize; p++ )
+	{
+		uint d = foldOrder.empty() ? p : foldOrder[p];
+		if( p >= first && p < second )
+			indexesTest.push_back( d );
+		else
+			indexesTraining.push_back( d );
 	}
 
+//---create child train and test Dataset
+	foldTraining = makeSubset( indexesTraining );
+	foldTest = makeSubset( indexesTest );
+
 //---if previously weighted by similarity, weight the subsets by similarity
-	if( similarityMatrix.size() > 0 )
-		dissimilaritySubsets();
+	if( bFoldsBySimilarity )
+	{
+		foldTraining->makeSimilarityMatrix(); //for training folds, similarity relative to self
+		foldTraining->dissimilarityAsInstanceWeights();
+
+		foldTest->makeSimilarityMatrix( foldTraining.get() ); //for test folds, similarity relative to corresponding train fold
+		foldTest->relativeDissimilarityAsInstanceWeights();
+	}
+}
+
+DatasetSP Dataset::makeSubset( const std::vector<uint>& indexes ) const
+{
+	std::vector<uint> subsetRowIds;
+	std::vector<double> subsetOutputs;
+	std::vector<double> subsetInstanceWeights;
+	for( uint i = 0; i < indexes.size(); i++ )
+	{
+		subsetRowIds.push_back( rowIds[ indexes[i] ] );
+		subsetOutputs.push_back( outputs[ indexes[i] ] );
+		subsetInstanceWeights.push_back( instanceWeights[ indexes[i] ] );
+	}
+	DatasetSP subset = std::make_shared<Dataset>( inputs.gather( indexes ), subsetOutputs, subsetInstanceWeights, classThreshold, subsetRowIds );
+	subset->normalizeInstanceWeights();
+	return subset;
 }
 //======================================================================= end of DATA SPLITS =============================================================================
\ No newline at end of file
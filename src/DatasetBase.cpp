@@ -1,6 +1,15 @@
 #include "DatasetBase.hpp"
-#include <math.h> //pow in generateBoolInputs()
-#include <algorithm> //shuffle in shuffle()
+#include <math.h> //pow in generateBoolInputs(), fabs in checkDissimilarities()
+#include <algorithm> //shuffle in shuffle(), std::copy and std::min in sumDissimilarities()
+#include <map> //classes and input values in sumDissimilaritiesByCounts()
+#include <utility> //std::move in sortByIndexVector()
+#include <chrono> //times in makeSimilarityMatrix() and checkDissimilarities()
+#include "ThreadHandler.hpp" //sumDissimilarities(), sumDissimilaritiesByCounts()
+
+//static
+bool DatasetBase::bKeepSimilarityMatrix = DEFAULT_DATASET_SIM_MATRIX;
+uint DatasetBase::similarityMode = DEFAULT_DATASET_SIM_MODE;
+uint DatasetBase::similarityCheckNum = DEFAULT_DATASET_SIM_CHECK_NUM;
 
 
 ////////////////////////////////////////////////////////////////////////////* STATIC */////////////////////////////////////////////////////////////////////////////
@@ -66,6 +75,168 @@ std::vector<std::vector<double>> DatasetBase::makeSimilarityMatrix( const std::v
     return similarityMatrix;
 }
 
+std::vector<double> DatasetBase::sumDissimilarities( const DataMatrix& inputs1, const DataMatrix& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2, std::vector<std::vector<double>>* similarityMatrix )
+///same scores as sumSimilarityMatrix( makeSimilarityMatrix() ). Binary inputs: the number of different inputs is the popcount of the XOR of the packed inputs. Other inputs are compared value by value, as calculatePairSimilarity(). The additions of every row are made in the same order
+{
+    uint inputNum = inputs1.size() > 0 ? inputs1[0].size() : 0;
+    bool bBinary = inputs1.isBinary() && inputs2.isBinary(); //packing binarizes at 0.5
+    uint wordNum = bBinary ? ( inputNum + 63 ) / 64 : 0;
+
+//---pack both series of cases in contiguous words
+    std::vector<uint64_t> bits1( inputs1.size() * wordNum );
+    std::vector<uint64_t> bits2( inputs2.size() * wordNum );
+    for( uint c = 0; bBinary && c < inputs1.size(); c++ )
+    {
+        InstanceFilterIndex::Bits packed = InstanceFilterIndex::pack( inputs1[c] );
+        std::copy( packed.begin(), packed.end(), bits1.begin() + c * wordNum );
+    }
+    for( uint c = 0; bBinary && c < inputs2.size(); c++ )
+    {
+        InstanceFilterIndex::Bits packed = InstanceFilterIndex::pack( inputs2[c] );
+        std::copy( packed.begin(), packed.end(), bits2.begin() + c * wordNum );
+    }
+
+//---add up the similarities of each case (1) by tiles of reference cases (2). Each thread takes a block of cases (1), so no row is shared
+    std::vector<double> totalSimilarities( inputs1.size(), 0.0 );
+    if( similarityMatrix != nullptr )
+        similarityMatrix->assign( inputs1.size(), std::vector<double>( inputs2.size() ) );
+
+    ThreadHandler::parallelFor( 0, inputs1.size(), [&]( uint begin, uint end, uint )
+    {
+        for( uint tile = 0; tile < inputs2.size(); tile += DATASET_SIM_TILE )
+        {
+            uint tileEnd = std::min<uint>( tile + DATASET_SIM_TILE, inputs2.size() );
+            for( uint c1 = begin; c1 < end; c1++ )
+            {
+                for( uint c2 = tile; c2 < tileEnd; c2++ )
+                {
+                    uint differentNum = 0;
+                    if( bBinary )
+                    {
+                        const uint64_t* row1 = &bits1[ c1 * wordNum ];
+                        const uint64_t* row2 = &bits2[ c2 * wordNum ];
+                        for( uint w = 0; w < wordNum; w++ )
+                            differentNum += InstanceFilterIndex::popcount( row1[w] ^ row2[w] );
+                    }
+                    else
+                    {
+                        const double* row1 = inputs1.row( c1 );
+                        const double* row2 = inputs2.row( c2 );
+                        for( uint i = 0; i < inputNum; i++ )
+                            differentNum += row1[i] != row2[i];
+                    }
+                //---same definition as calculatePairSimilarity()
+                    double similarity = outputs1[c1] == outputs2[c2] ? static_cast<double>( inputNum - differentNum ) / inputNum : static_cast<double>( differentNum ) / inputNum;
+                    totalSimilarities[c1] += similarity;
+                    if( similarityMatrix != nullptr )
+                        (*similarityMatrix)[c1][c2] = similarity;
+                }
+            }
+        }
+    }, DATASET_SIM_MIN_BLOCK );
+
+//---normalize to [0,1] and reverse it, as sumSimilarityMatrix()
+    for( uint c1 = 0; c1 < totalSimilarities.size(); c1++ )
+        totalSimilarities[c1] = 1.0 - totalSimilarities[c1] / inputs2.size();
+    return totalSimilarities;
+}
+
+std::vector<double> DatasetBase::sumDissimilaritiesByCounts( const DataMatrix& inputs1, const DataMatrix& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2 )
+///the different inputs between a case (1) and all the cases (2) of a class add up, input by input, to the number of those cases with another value. The similarities are added up as integers (in units of 1 / inputNum), so no pair is visited
+{
+    uint inputNum = inputs1.size() > 0 ? inputs1[0].size() : 0;
+    bool bBinary = inputs1.isBinary() && inputs2.isBinary(); //otherwise each value of each input is counted, as calculatePairSimilarity() compares exact values
+
+//---group the cases (2) by output and count how many of each group have each input to 1 (binary) or each value of each input
+    std::map<double, uint> classIndexes;
+    std::vector<uint64_t> classSizes;
+    std::vector<std::vector<uint64_t>> classOnes;
+    std::vector<std::vector<std::map<double, uint64_t>>> classValues;
+    for( uint c2 = 0; c2 < inputs2.size(); c2++ )
+    {
+        std::map<double, uint>::iterator it = classIndexes.find( outputs2[c2] );
+        if( it == classIndexes.end() )
+        {
+            it = classIndexes.insert( std::make_pair( outputs2[c2], classSizes.size() ) ).first;
+            classSizes.push_back( 0 );
+            classOnes.push_back( std::vector<uint64_t>( bBinary ? inputNum : 0, 0 ) );
+            classValues.push_back( std::vector<std::map<double, uint64_t>>( bBinary ? 0 : inputNum ) );
+        }
+        classSizes[ it->second ]++;
+        for( uint i = 0; i < inputNum; i++ )
+        {
+            if( ! bBinary )
+                classValues[ it->second ][i][ inputs2[c2][i] ]++;
+            else if( inputs2[c2][i] == 1.0 )
+                classOnes[ it->second ][i]++;
+        }
+    }
+
+//---sum of each case (1)
+    std::vector<double> totalDissimilarities( inputs1.size() );
+    ThreadHandler::parallelFor( 0, inputs1.size(), [&]( uint begin, uint end, uint )
+    {
+        std::vector<uint64_t> differentNums( classSizes.size() ); //number of different inputs with all the cases of each class
+        for( uint c1 = begin; c1 < end; c1++ )
+        {
+            std::fill( differentNums.begin(), differentNums.end(), 0 );
+            for( uint i = 0; i < inputNum; i++ )
+            {
+                double value = inputs1[c1][i];
+                for( uint g = 0; g < classSizes.size(); g++ )
+                {
+                    if( bBinary )
+                        differentNums[g] += value == 1.0 ? classSizes[g] - classOnes[g][i] : classOnes[g][i];
+                    else
+                    {
+                        std::map<double, uint64_t>::const_iterator equal = classValues[g][i].find( value );
+                        differentNums[g] += classSizes[g] - ( equal != classValues[g][i].end() ? equal->second : 0 );
+                    }
+                }
+            }
+        //---same definition as calculatePairSimilarity(): equal inputs with the cases of the same output, different inputs with the rest
+            std::map<double, uint>::const_iterator ownClass = classIndexes.find( outputs1[c1] );
+            uint64_t similarityNum = 0;
+            for( uint g = 0; g < classSizes.size(); g++ )
+                similarityNum += ownClass != classIndexes.end() && ownClass->second == g ? classSizes[g] * inputNum - differentNums[g] : differentNums[g];
+            totalDissimilarities[c1] = 1.0 - static_cast<double>( similarityNum ) / inputNum / inputs2.size();
+        }
+    }, DATASET_SIM_MIN_BLOCK );
+    return totalDissimilarities;
+}
+
+void DatasetBase::checkDissimilarities( const std::vector<double>& dissimilaritySums, const DataMatrix& inputs1, const DataMatrix& inputs2, const std::vector<double>& outputs1, const std::vector<double>& outputs2, uint checkNum, double countsSeconds )
+{
+    checkNum = std::min<uint>( checkNum, inputs1.size() );
+    if( checkNum == 0 )
+        return;
+
+//---evenly spaced sample of cases (1)
+    std::vector<uint> sampleIndexes;
+    std::vector<double> sampleOutputs;
+    for( uint s = 0; s < checkNum; s++ )
+    {
+        sampleIndexes.push_back( static_cast<uint64_t>( s ) * inputs1.size() / checkNum );
+        sampleOutputs.push_back( outputs1[ sampleIndexes.back() ] );
+    }
+    DataMatrix sampleInputs = inputs1.gather( sampleIndexes );
+
+//---pair-wise sums of the sample
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<double> pairwiseSums = sumDissimilarities( sampleInputs, inputs2, sampleOutputs, outputs2 );
+    double pairwiseSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    double maxError = 0.0, meanError = 0.0;
+    for( uint s = 0; s < checkNum; s++ )
+    {
+        double error = fabs( dissimilaritySums[ sampleIndexes[s] ] - pairwiseSums[s] );
+        maxError = std::max( maxError, error );
+        meanError += error / checkNum;
+    }
+    std::cout << "similarity check on " << checkNum << " of " << inputs1.size() << " instances: max error " << maxError << ", mean error " << meanError
+    << ". Time by counts " << countsSeconds << " s, pair-wise " << pairwiseSeconds * inputs1.size() / checkNum << " s (estimated from the sample)\n";
+}
+
 std::vector<double> DatasetBase::sumSimilarityMatrix( const std::vector<std::vector<double>>& similarityMatrix )
 {
     std::vector<double> totalSimilarities( similarityMatrix.size(), 0.0 );
@@ -87,81 +258,55 @@ std::vector<double> DatasetBase::sumSimilarityMatrix( const std::vector<std::vec
 //======================================================================= GENERATE =============================================================================
 void DatasetBase::generateOutputs( const NeuralWebBase* net )
 {
-	outputs.clear();
-	for( uint c = 0; c < inputs.size(); c++ )
-		outputs.push_back( net->predict( inputs, c ) ); //predict outputs for every set of inputs
+	outputs.resize( inputs.size() );
+	net->predictBatch( inputs, 0, inputs.size(), outputs.data() ); //predict outputs for every set of inputs. Ensembles predict by blocks in parallel
 	makeBoolOutputs();
 }
 
-void DatasetBase::filterInstancesEqual(const  DatasetBase* filter )
+void DatasetBase::filterInstancesEqual( const DatasetBase* filter )
 {
-    const std::vector<std::vector<double>> filterInputs = filter->getInputs();
-
-    uint c1 = 0;
-    while( c1 < inputs.size() ) //no for loop because erasing is performed inside
-    {
-        bool found = false; //whether current instance found in the filter dataset
-        for( uint c2 = 0; c2 < filterInputs.size(); c2++ ) //iterate filter dataset
-        {
-            if( DatasetBase::calculatePairSimilarity( inputs, filterInputs, 0, 0, c1, c2 ) >= DEFAULT_DATASET_FILTER_EQUAL_THRESHOLD ) //if similarity (inputs only) greater than threshold, they are the same
-            {
-                //remove the repeated instance
-                inputs.erase( inputs.begin() + c1 );
-                if( outputs.size() > c1 )
-                    outputs.erase( outputs.begin() + c1 );
-                if( instanceWeights.size() > c1 )
-                    instanceWeights.erase( instanceWeights.begin() + c1 );
-                found = true; //update control var
-                break;
-            }
-        }
-        if( ! found ) //only advance in the iteration if no erase() 
-            c1++;
-    }
+    InstanceFilterIndex filterIndex;
+    filterIndex.indexEqual( filter );
+    filterInstances( filterIndex );
 }
 
 void DatasetBase::filterInstancesSuperset( const DatasetBase* filter, uint inputValue, uint classValue )
 {
-    const std::vector<std::vector<double>> filterInputs = filter->getInputs();
-    const std::vector<double> filterOutputs = filter->getOutputs();
+    InstanceFilterIndex filterIndex;
+    filterIndex.indexSupersets( filter, inputValue, classValue );
+    filterInstances( filterIndex );
+}
 
-    uint c1 = 0;
-    while( c1 < inputs.size() ) //no for loop because erasing is performed inside
+void DatasetBase::filterInstances( const InstanceFilterIndex& filterIndex )
+///compact in place: kept instances are moved forward in a single pass instead of erasing from the middle of the vectors
+{
+    inputs.makeOwn(); //copy on write, once before the rows are moved
+    uint kept = 0;
+    for( uint c = 0; c < inputs.size(); c++ )
     {
-        bool found = false; //whether current instance found in the filter dataset
-        for( uint c2 = 0; c2 < filterInputs.size(); c2++ ) //iterate filter dataset
+        if( filterIndex.find( inputs[c] ) ) //remove the instance
+            continue;
+        if( kept != c )
         {
-            if( ( filterOutputs[c2] >= classThreshold && classValue == 0 ) || ( filterOutputs[c2] < classThreshold && classValue == 1 ) ) //if the class does not match the one of interest, skip instance
-                continue;
-
-            bool bDifferent = false; //whether a difference between c1 instance and c2 filter instance found
-            uint filterCounter = 0; //counter of inputs different form the one of interest in the filter c2 instance
-            for( uint i = 0; i < inputs[c1].size(); i++ ) //iterate inputs
-            {
-                if( ( filterInputs[c2][i] >= 0.5 && inputValue == 0 ) || ( filterInputs[c2][i] < 0.5 && inputValue == 1 ) ) //count inputs not of interest in the filter instance
-                    filterCounter ++;
-
-                if( ( inputs[c1][i] >= 0.5 && filterInputs[c2][i] < 0.5 && inputValue == 0 ) || ( inputs[c1][i] < 0.5 && filterInputs[c2][i] >= 0.5 && inputValue == 1 ) ) //if the input makes c1 instance no superset of of c2 filter instance
-                {
-                    bDifferent = true;
-                    break;
-                }
-            }
-            if( ! bDifferent && filterCounter < inputs[c1].size() ) //if c1 is superset of c2 with output = classValue and c2 is not a trivial instance that any one would be a superset of
-            {
-                //remove the repeated instance
-                inputs.erase( inputs.begin() + c1 );
-                if( outputs.size() > c1 )
-                    outputs.erase( outputs.begin() + c1 );
-                if( instanceWeights.size() > c1 )
-                    instanceWeights.erase( instanceWeights.begin() + c1 );
-                found = true;
-                break;
-            }
+            inputs.copyRow( kept, c );
+            rowIds[kept] = rowIds[c];
+            if( outputs.size() > c )
+                outputs[kept] = outputs[c];
+            if( boolOutputs.size() > c )
+                boolOutputs[kept] = boolOutputs[c];
+            if( instanceWeights.size() > c )
+                instanceWeights[kept] = instanceWeights[c];
         }
-        if( ! found ) //only advance in the iteration if no erase() 
-            c1++;
+        kept++;
     }
+    inputs.resizeRows( kept );
+    rowIds.resize( kept );
+    if( outputs.size() > kept )
+        outputs.resize( kept );
+    if( boolOutputs.size() > kept )
+        boolOutputs.resize( kept );
+    if( instanceWeights.size() > kept )
+        instanceWeights.resize( kept );
 }
 //======================================================================= end of GENERATE =============================================================================
 
@@ -173,6 +318,7 @@ void DatasetBase::filterInstancesSuperset( const DatasetBase* filter, uint input
 void DatasetBase::weightInstances( double instanceWeightByOutput, double instanceWeightByInput, bool bSimilarityAsWeights )
 {
 	instanceWeights.clear();
+    bSimilarityWeighted = bSimilarityAsWeights;
 
     if( ! bSimilarityAsWeights )
     {
@@ -216,16 +362,22 @@ void DatasetBase::normalizeInstanceWeights()
 
 void DatasetBase::makeSimilarityMatrix( const DatasetBase* referenceDataset )
 {
-    if( referenceDataset == nullptr ) //use self as reference dataset. Typically for training dataset
-    {
-        similarityMatrix = makeSimilarityMatrix( inputs, inputs, outputs, outputs );
-        dissimilaritySum = sumSimilarityMatrix( similarityMatrix );
-    }
-    else //use the provided reference dataset. Typically for val and test datasets
+//---use self as reference dataset (typically for training dataset) or the provided one (typically for val and test datasets)
+    const DataMatrix& referenceInputs = referenceDataset == nullptr ? inputs : referenceDataset->getInputs();
+    const std::vector<double>& referenceOutputs = referenceDataset == nullptr ? outputs : referenceDataset->getBoolOutputs();
+    std::vector<std::vector<double>>& matrix = referenceDataset == nullptr ? similarityMatrix : similarityMatrixRelative;
+    std::vector<double>& sums = referenceDataset == nullptr ? dissimilaritySum : dissimilaritySumRelative;
+
+    matrix.clear();
+    if( similarityMode == DATASET_SIM_MODE_COUNTS )
     {
-        similarityMatrixRelative = makeSimilarityMatrix( inputs, referenceDataset->getInputs(), outputs, referenceDataset->getBoolOutputs() );
-        dissimilaritySumRelative = sumSimilarityMatrix( similarityMatrixRelative );
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sums = sumDissimilaritiesByCounts( inputs, referenceInputs, outputs, referenceOutputs );
+        if( similarityCheckNum > 0 )
+            checkDissimilarities( sums, inputs, referenceInputs, outputs, referenceOutputs, similarityCheckNum, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
     }
+    else
+        sums = sumDissimilarities( inputs, referenceInputs, outputs, referenceOutputs, bKeepSimilarityMatrix ? &matrix : nullptr );
 }
 //======================================================================= end of INSTANCE WEIGHTING =============================================================================
 
@@ -245,18 +397,20 @@ void DatasetBase::shuffle( RandomEngine& randomEngine )
 
 void DatasetBase::sortByIndexVector( const std::vector<uint>& indexVector )
 {
-	std::vector<std::vector<double>> newInputs;
+	std::vector<uint> newRowIds;
 	std::vector<double> newOutputs;
 	std::vector<double> newInstanceWeights;
-//---create new inputs, outputs and instance weights vectors following the order in index vector
+//---create new inputs (a single block), row ids, outputs and instance weights vectors following the order in index vector
+	DataMatrix newInputs = inputs.gather( indexVector );
 	for( uint i = 0; i < indexVector.size(); i++ )
 	{
-		newInputs.push_back( inputs[ indexVector[i] ] );
+		newRowIds.push_back( rowIds[ indexVector[i] ] );
 		newOutputs.push_back( outputs[ indexVector[i] ] );
 		newInstanceWeights.push_back( instanceWeights[ indexVector[i] ] );
 	}
 //---replace the old vectors
-	inputs.swap( newInputs );
+	inputs = std::move( newInputs );
+	rowIds.swap( newRowIds );
 	outputs.swap( newOutputs );
 	instanceWeights.swap( newInstanceWeights );
 
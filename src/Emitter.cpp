@@ -1,5 +1,8 @@
 #include "Emitter.hpp"
 #include <memory>
+#include <cstring> //std::memcpy in printDatasetBinary() and makeNetworkBinary()
+#include "ThreadHandler.hpp" //writeDatasetRows()
+#include "MappedFile.hpp" //mergePredictionFilesBinary()
 
 //////////////////////////////////////////////////////////////////////////* STATIC *///////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -16,83 +19,53 @@ std::string Emitter::resizeStr( const std::string& originalStr, uint targetSize
 
 bool Emitter::printNetwork( const NeuralWeb* net, uint64_t options, const std::string& netFileName, const std::string& activationFileName, const std::string& metricsFileName )
 {
-	const std::vector<NodeSP>& netNodes = net->getNodes();
-	const std::vector<ArcSP>& netArcs = net->getArcs();
-
-//---main structure and weights file
-	std::ofstream netFile ( netFileName );
-	if( ! netFile.is_open() )
+	if( ! AsyncWriter::writeFile( netFileName, makeNetworkText( net, options ) ) )
 		return false;
+	if( GET_FLAG( options, FLAG_NET_TRAINED ) ) //only trained nets have scales and metrics files
+		return AsyncWriter::writeFile( activationFileName, makeActivationText( net ) ) && AsyncWriter::writeFile( metricsFileName, makeMetricsText( net ) );
+	return true;
+}
 
-	if( GET_FLAG( options, FLAG_NET_TRAINED ) ) //trained net: biases included
-	{
-		for( uint a = 0; a < netArcs.size(); a++ )
-		{
-			if( netArcs[a]->getParent() != nullptr ) //is actual arc (not bias)
-				netFile << netArcs[a]->getParent()->getName() << EMITTER_NET_SEPARATOR << netArcs[a]->getWeight() << EMITTER_NET_SEPARATOR << netArcs[a]->getChild()->getName();
-			else //bias
-				netFile << "bias" << EMITTER_NET_SEPARATOR << netArcs[a]->getWeight() << EMITTER_NET_SEPARATOR << netArcs[a]->getChild()->getName();
+bool Emitter::printNetworkBinary( const NeuralWeb* net, const std::string& fileName )
+{
+	return AsyncWriter::writeFile( fileName, makeNetworkBinary( net ), FLAG_WRITE_NEW | FLAG_WRITE_BINARY );
+}
 
-			if( a < netArcs.size() - 1 )
-				netFile << "\n";
-		}
-	}
-	else //untrained net: biased not saved
-	{
-		for( uint a = 0; a < netArcs.size(); a++ )
-		{
-			std::string signStr = "";
-			if( netArcs[a]->getSign() == Arc::Sign::NEG )
-				signStr = PARSER_NET_ARCS_SIGN_NEG;
-			else if( netArcs[a]->getSign() == Arc::Sign::ANY )
-				signStr = PARSER_NET_ARCS_SIGN_ANY;
+bool Emitter::printEnsembleBinary( const std::vector<NeuralWebSP>& memberNets, uint firstNetIndex, const std::string& fileName )
+{
+	if( memberNets.empty() )
+		return false;
+	std::ofstream ensembleFile ( fileName, std::ios_base::binary );
+	if( ! ensembleFile.is_open() )
+		return false;
 
-			if( netArcs[a]->getParent() != nullptr )
-			{
-				if( a >= 1 )
-					netFile << "\n";
-				netFile << netArcs[a]->getParent()->getName() << EMITTER_NET_SEPARATOR << signStr << EMITTER_NET_SEPARATOR << netArcs[a]->getChild()->getName();
-			}
-		}
+	Parser::EnsembleFileHeader fileHeader;
+	std::memcpy( fileHeader.magic, PARSER_ENSEMBLE_BINARY_MAGIC, sizeof( fileHeader.magic ) );
+	fileHeader.version = PARSER_ENSEMBLE_BINARY_VERSION;
+	fileHeader.topologyHash = memberNets[0]->getTopologyHash();
+	fileHeader.paramNum = memberNets[0]->getParamNum();
+	fileHeader.metricNum = metricNames.size() * 2;
+	fileHeader.memberNum = memberNets.size();
+	fileHeader.firstNetIndex = firstNetIndex;
+	ensembleFile.write( reinterpret_cast<const char*>( &fileHeader ), sizeof( fileHeader ) );
+
+//---[ member x parameter ] matrix, then [ member x metric ] matrix (train and val, same as the net files)
+	for( uint n = 0; n < memberNets.size(); n++ )
+	{
+		std::vector<double> paramValues = memberNets[n]->getParamValues();
+		ensembleFile.write( reinterpret_cast<const char*>( paramValues.data() ), paramValues.size() * sizeof( double ) );
 	}
-	netFile.close();
-
-	if( GET_FLAG( options, FLAG_NET_TRAINED ) ) //only trained nets have scales and metrics files
+	for( uint n = 0; n < memberNets.size(); n++ )
 	{
-	//---scales or activation file
-		std::ofstream netFile ( activationFileName );
-		if( ! netFile.is_open() )
-			return false;
-
-		for( uint n = 0; n < netNodes.size(); n++ )
-		{
-			if( netNodes[n]->getBTrainableScale() ) //scale of untrainable nodes = input layer is always 1 -> don't print
-				netFile << netNodes[n]->getName() << EMITTER_NET_SEPARATOR << netNodes[n]->getScales()[0];
-
-			if( n < netNodes.size() - 1 )
-				netFile << "\n";
-		}
-		netFile.close();
-	
-	//---metrics file
-		std::ofstream metricsFile ( metricsFileName );
-		if( ! metricsFile.is_open() )
-			return false;
-		//train
-		const Metrics& netTrainMetrics = net->getTrainMetrics();
+		std::vector<double> memberMetrics;
 		for( uint m = 0; m < metricNames.size(); m++ )
-			metricsFile << setNames[INDEX_SET_TRAIN] + "_" + metricNames[m] << PARSER_EQUAL << netTrainMetrics.getMember( m ) << "\n";
-		//val
-		const Metrics& netValMetrics = net->getTestMetrics();
+			memberMetrics.push_back( memberNets[n]->getTrainMetrics().getMember( m ) );
 		for( uint m = 0; m < metricNames.size(); m++ )
-		{
-			metricsFile << setNames[INDEX_SET_VAL] + "_"  + metricNames[m] << PARSER_EQUAL << netValMetrics.getMember( m );
-			if( m < metricNames.size() - 1 )
-				metricsFile << "\n";
-		}
-		metricsFile.close();
+			memberMetrics.push_back( memberNets[n]->getTestMetrics().getMember( m ) );
+		ensembleFile.write( reinterpret_cast<const char*>( memberMetrics.data() ), memberMetrics.size() * sizeof( double ) );
 	}
-    return true;
+	ensembleFile.close();
+	return ensembleFile.good();
 }
 
 bool Emitter::printHistorical( const HistoricalTrack& historicalTrack, const std::string& fileName )
@@ -132,67 +105,142 @@ bool Emitter::printHistorical( const HistoricalTrack& historicalTrack, const std
 //===================================================================== OUT FILES ===========================================================================================
 bool Emitter::printDataset( const Dataset& correctDataset, const Dataset& predictedDataset, uint64_t options, const std::string& fileName, double outputLBound, double outputUBound, double classThreshold )
 {
-	std::ofstream dataFile ( fileName );
-	if( ! dataFile.is_open() )
-		return false;
+	writer->write( fileName, makeDatasetHeader( options ), FLAG_WRITE_NEW | ( GET_FLAG( options, FLAG_DATA_BINARY ) ? FLAG_WRITE_BINARY : FLAG_NULL ) );
+	writeDatasetRows( fileName, correctDataset, predictedDataset, options, outputLBound, outputUBound, classThreshold, true );
+	writer->close( fileName );
+	return true;
+}
 
-//---header
-	dataFile << header[0]; //"output"
+bool Emitter::printDatasetHeader( uint64_t options, const std::string& fileName )
+{
+	writer->write( fileName, makeDatasetHeader( options ), FLAG_WRITE_NEW | ( GET_FLAG( options, FLAG_DATA_BINARY ) ? FLAG_WRITE_BINARY : FLAG_NULL ) ); //kept open for the chunks
+	return true;
+}
 
-	if( GET_FLAG( options, FLAG_DATA_PRED ) ) //output predictions
+bool Emitter::printDatasetChunk( const Dataset& correctDataset, const Dataset& predictedDataset, uint64_t& printedNum, uint64_t options, const std::string& fileName, double outputLBound, double outputUBound, double classThreshold )
+{
+	printedNum += writeDatasetRows( fileName, correctDataset, predictedDataset, options, outputLBound, outputUBound, classThreshold, printedNum == 0 );
+	return true;
+}
+
+bool Emitter::printDatasetBinary( const Dataset& dataset, uint64_t options, const std::string& fileName )
+{
+	const DataMatrix& inputs = dataset.getInputs();
+	bool bWeights = GET_FLAG( options, FLAG_DATA_WEIGHT );
+
+//---names section: output + inputs, each as length + chars
+	std::string names;
+	for( uint h = 0; h < header.size(); h++ )
 	{
-		dataFile << "," << header[0] << "_predictedBool";
-		dataFile << "," << header[0] << "_predictedReal";
+		uint32_t length = header[h].size();
+		names.append( reinterpret_cast<const char*>( &length ), sizeof( length ) );
+		names.append( header[h] );
 	}
-	if( GET_FLAG( options, FLAG_DATA_WEIGHT ) ) //instance weights
-		dataFile << ",weights";
 
-	if( GET_FLAG( options, FLAG_DATA_COUNT ) ) //number of 0 inputs
-		dataFile << ",zeros_num";
+//---fixed header. The data starts aligned so that the mapped inputs can be used as they are
+	Parser::DatasetFileHeader fileHeader;
+	std::memcpy( fileHeader.magic, PARSER_DATA_BINARY_MAGIC, sizeof( fileHeader.magic ) );
+	fileHeader.version = PARSER_DATA_BINARY_VERSION;
+	fileHeader.flags = bWeights ? PARSER_DATA_BINARY_FLAG_WEIGHTS : 0;
+	fileHeader.inputNum = header.size() - 1;
+	fileHeader.rowNum = inputs.size();
+	fileHeader.stride = inputs.empty() ? fileHeader.inputNum : inputs.getStride();
+	fileHeader.namesBytes = names.size();
+	fileHeader.dataOffset = ( sizeof( fileHeader ) + names.size() + DATA_MATRIX_ALIGNMENT - 1 ) / DATA_MATRIX_ALIGNMENT * DATA_MATRIX_ALIGNMENT;
+	if( ! inputs.empty() && inputs.getColNum() != fileHeader.inputNum )
+	{
+		std::cout << "Error: the dataset has " << inputs.getColNum() << " inputs and the header " << fileHeader.inputNum << "\n";
+		return false;
+	}
 
-	for( uint h = 1; h < header.size(); h++ ) //inputs
-		dataFile << "," << header[h];
-	dataFile << "\n";
+	std::string buffer( reinterpret_cast<const char*>( &fileHeader ), sizeof( fileHeader ) );
+	buffer.append( names );
+	buffer.resize( fileHeader.dataOffset, '\0' );
+	uint64_t writeOptions = FLAG_WRITE_NEW | FLAG_WRITE_BINARY; //the first piece starts the file
 
-//---data
-	for( uint d = 0; d < correctDataset.getInputs().size(); d++ )
+//---data: input rows with their padding, outputs and weights. Queued by pieces of about EMITTER_BUFFER_BYTES
+	for( uint d = 0; d < inputs.size(); d++ )
 	{
-	//---filter by predicted real ouput
-		if( GET_FLAG( options, FLAG_DATA_FILTER ) && ( predictedDataset.getOutputs()[d] < outputLBound || predictedDataset.getOutputs()[d] > outputUBound ) )
-			continue;
+		buffer.append( reinterpret_cast<const char*>( inputs.row( d ) ), fileHeader.stride * sizeof( double ) );
+		if( buffer.size() >= EMITTER_BUFFER_BYTES )
+		{
+			writer->write( fileName, std::move( buffer ), writeOptions );
+			buffer.clear();
+			writeOptions = FLAG_WRITE_BINARY;
+		}
+	}
+	buffer.append( reinterpret_cast<const char*>( dataset.getOutputs().data() ), inputs.size() * sizeof( double ) );
+	if( bWeights )
+		buffer.append( reinterpret_cast<const char*>( dataset.getInstanceWeights().data() ), inputs.size() * sizeof( double ) );
+	writer->write( fileName, std::move( buffer ), writeOptions | FLAG_WRITE_CLOSE );
+	return true;
+}
 
-	//---output
-		dataFile << correctDataset.getOutputs()[d];
+bool Emitter::mergeDatasetFiles( const std::vector<std::string>& partFileNames, const std::string& fileName )
+{
+	std::ofstream dataFile ( fileName );
+	if( ! dataFile.is_open() )
+		return false;
 
-		if( GET_FLAG( options, FLAG_DATA_PRED ) ) //predictions
+	bool bFirstRow = true;
+	for( uint p = 0; p < partFileNames.size(); p++ )
+	{
+		std::ifstream partFile ( partFileNames[p] );
+		if( ! partFile.is_open() )
 		{
-			dataFile << PARSER_DATA_SEPARATOR << ( predictedDataset.getOutputs()[d] >= classThreshold ? 1 : 0 ); //binarized prediction
-			dataFile << PARSER_DATA_SEPARATOR << predictedDataset.getOutputs()[d]; //real prediction
+			std::cout << "Error: missing part file " << partFileNames[p] << "\n";
+			return false;
 		}
-		if( GET_FLAG( options, FLAG_DATA_WEIGHT ) ) //weights
-			dataFile << PARSER_DATA_SEPARATOR << correctDataset.getInstanceWeights()[d];
-
-	//---inputs
-		if( GET_FLAG( options, FLAG_DATA_COUNT ) ) //number of 0 in the inputs
+		std::string line;
+		if( std::getline( partFile, line ) && p == 0 ) //header only from the first part
+			dataFile << line << "\n";
+		while( std::getline( partFile, line ) )
 		{
-			uint counter0 = 0;
-			for( uint i = 0; i < correctDataset.getInputs()[d].size(); i++ )
-			{
-				if( correctDataset.getInputs()[d][i] < 0.5 )
-					counter0++;
-			}
-			dataFile << PARSER_DATA_SEPARATOR << counter0;
+			if( line.empty() )
+				continue;
+			if( ! bFirstRow )
+				dataFile << "\n";
+			dataFile << line;
+			bFirstRow = false;
 		}
-		for( uint i = 0; i < correctDataset.getInputs()[d].size(); i++ ) //input values
-			dataFile << PARSER_DATA_SEPARATOR << correctDataset.getInputs()[d][i];
-
-		if( d < correctDataset.getInputs().size() - 1 )
-			dataFile << "\n";
 	}
 	dataFile.close();
 	return true;
 }
 
+bool Emitter::mergePredictionFilesBinary( const std::vector<std::string>& partFileNames, const std::string& fileName )
+{
+	std::ofstream dataFile ( fileName, std::ios_base::binary );
+	if( ! dataFile.is_open() )
+		return false;
+
+	std::string firstHeader;
+	for( uint p = 0; p < partFileNames.size(); p++ )
+	{
+		MappedFile partFile;
+		if( ! partFile.open( partFileNames[p] ) || partFile.getSize() < sizeof( Parser::PredictionFileHeader ) )
+		{
+			std::cout << "Error: missing part file " << partFileNames[p] << "\n";
+			return false;
+		}
+	//---header only from the first part. The others must have the same one
+		std::string partHeader( partFile.getData(), sizeof( Parser::PredictionFileHeader ) );
+		if( p == 0 )
+		{
+			firstHeader = partHeader;
+			dataFile.write( partFile.getData(), sizeof( Parser::PredictionFileHeader ) );
+		}
+		else if( partHeader != firstHeader )
+		{
+			std::cout << "Error: part file " << partFileNames[p] << " has a different header\n";
+			return false;
+		}
+		dataFile.write( partFile.getData() + sizeof( Parser::PredictionFileHeader ), partFile.getSize() - sizeof( Parser::PredictionFileHeader ) );
+	}
+	dataFile.close();
+	return dataFile.good();
+}
+
 bool Emitter::printExternalMetrics( const Metrics* metrics, const std::string& prefix )
 {
 //---construct the message
@@ -206,14 +254,175 @@ bool Emitter::printExternalMetrics( const Metrics* metrics, const std::string& p
 //---cout
     std::cout << message;
 //---result file
-    resultFile->open( OUTFILE_RESULT, std::ios_base::out | std::ios_base::app );
-    if( ! resultFile->is_open() )
-        return false;
-    (*resultFile) << message; 
-    resultFile->close();
+    writer->write( OUTFILE_RESULT, std::move( message ) );
     return true;
 }
 
+bool Emitter::printEnsembleSweep( const EnsembleSweep& ensembleSweep, const std::string& fileName )
+{
+//---header
+	std::string buffer = "setting,criterion,threshold,weighted,members";
+	for( int s : { INDEX_SET_TRAIN, INDEX_SET_TEST } ) //selection (train) and test (fair) sets
+	{
+		for( uint m = 0; m < metricNames.size(); m++ )
+			buffer += "," + setNames[s] + "_" + metricNames[m];
+	}
+	buffer += ",member_weights";
+
+//---a row per setting. Criteria by their option names
+	const std::vector<EnsembleSweep::Result>& results = ensembleSweep.getResults();
+	for( uint r = 0; r < results.size(); r++ )
+	{
+		int criterion = results[r].bGreedy ? ensembleSweep.getParams().greedyCriterion : results[r].ensembleParams.qualityCriterion;
+		std::string criterionName;
+		for( std::map<std::string, int>::const_iterator it = Parser::metricNM.begin(); it != Parser::metricNM.end(); ++it )
+		{
+			if( it->second == criterion )
+				criterionName = it->first;
+		}
+		buffer += "\n";
+		buffer += results[r].bGreedy ? "greedy" : "grid";
+		buffer += "," + criterionName + ",";
+		AsyncWriter::appendNumber( buffer, results[r].bGreedy ? 0.0 : results[r].ensembleParams.qualityThreshold );
+		buffer += results[r].ensembleParams.bWeighted || results[r].bGreedy ? ",1," : ",0,";
+		AsyncWriter::appendNumber( buffer, static_cast<uint64_t>( results[r].memberNum ) );
+		for( uint m = 0; m < metricNames.size(); m++ )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, results[r].selectionMetrics.getMember( m ) );
+		}
+		for( uint m = 0; m < metricNames.size(); m++ )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, results[r].testMetrics.getMember( m ) );
+		}
+		buffer += ',';
+		for( uint n = 0; n < results[r].memberWeights.size(); n++ )
+		{
+			if( n > 0 )
+				buffer += ' ';
+			AsyncWriter::appendNumber( buffer, results[r].memberWeights[n] );
+		}
+	}
+	buffer += "\n";
+	writer->write( fileName, std::move( buffer ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+	return true;
+}
+
+bool Emitter::printKnockoutScreen( const KnockoutScreen& knockoutScreen, const std::string& fileName )
+{
+//---header
+	std::string buffer = "knockout,type,cone_nodes,mean_shift,mean_abs_shift,max_abs_shift,class_flips";
+	for( uint m = 0; m < metricNames.size(); m++ )
+		buffer += "," + metricNames[m];
+
+//---the intact net, then a row per knockout. Names are quoted: they may have separators
+	buffer += "\nnone,intact,0,0,0,0,0";
+	for( uint m = 0; m < metricNames.size(); m++ )
+	{
+		buffer += ',';
+		AsyncWriter::appendNumber( buffer, knockoutScreen.getBaselineMetrics().getMember( m ) );
+	}
+	const std::vector<KnockoutScreen::Result>& results = knockoutScreen.getResults();
+	for( uint r = 0; r < results.size(); r++ )
+	{
+		buffer += "\n\"" + results[r].name + "\"";
+		buffer += results[r].bArc ? ",arc," : ",node,";
+		AsyncWriter::appendNumber( buffer, static_cast<uint64_t>( results[r].coneSize ) );
+		for( double value : { results[r].meanShift, results[r].meanAbsShift, results[r].maxAbsShift } )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, value );
+		}
+		buffer += ',';
+		AsyncWriter::appendNumber( buffer, static_cast<uint64_t>( results[r].flipNum ) );
+		for( uint m = 0; m < metricNames.size(); m++ )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, results[r].metrics.getMember( m ) );
+		}
+	}
+	buffer += "\n";
+	writer->write( fileName, std::move( buffer ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+	return true;
+}
+
+bool Emitter::printAttributions( const NodeAttribution& nodeAttribution, const std::string& fileName, const std::string& summaryFileName )
+{
+//---matrix: a row per instance, queued by pieces of about EMITTER_BUFFER_BYTES
+	const std::vector<std::string>& nodeNames = nodeAttribution.getNodeNames();
+	const std::vector<double>& attributions = nodeAttribution.getAttributions();
+	std::string buffer = "instance,prediction";
+	for( uint n = 0; n < nodeNames.size(); n++ )
+		buffer += "," + nodeNames[n];
+	uint64_t writeOptions = FLAG_WRITE_NEW; //the first piece starts the file
+	for( uint r = 0; r < nodeAttribution.getRowNum(); r++ )
+	{
+		buffer += '\n';
+		AsyncWriter::appendNumber( buffer, static_cast<uint64_t>( r ) );
+		buffer += ',';
+		AsyncWriter::appendNumber( buffer, nodeAttribution.getPredictions()[r] );
+		for( uint n = 0; n < nodeNames.size(); n++ )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, attributions[ static_cast<size_t>( r ) * nodeNames.size() + n ] );
+		}
+		if( buffer.size() >= EMITTER_BUFFER_BYTES )
+		{
+			writer->write( fileName, std::move( buffer ), writeOptions );
+			buffer.clear();
+			writeOptions = FLAG_NULL;
+		}
+	}
+	buffer += '\n';
+	writer->write( fileName, std::move( buffer ), writeOptions | FLAG_WRITE_CLOSE );
+
+//---summary: a row per node and arc, the largest contributions first. Names are quoted: they may have separators
+	buffer = "name,type,mean,mean_abs,min,max";
+	const std::vector<NodeAttribution::Summary>& summaries = nodeAttribution.getSummaries();
+	for( uint s = 0; s < summaries.size(); s++ )
+	{
+		buffer += "\n\"" + summaries[s].name + "\"";
+		buffer += summaries[s].type == NodeAttribution::Summary::INPUT ? ",input" : ( summaries[s].type == NodeAttribution::Summary::NODE ? ",node" : ",arc" );
+		for( double value : { summaries[s].mean, summaries[s].meanAbs, summaries[s].minValue, summaries[s].maxValue } )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, value );
+		}
+	}
+	buffer += "\n";
+	writer->write( summaryFileName, std::move( buffer ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+	return true;
+}
+
+bool Emitter::printThresholdCurve( const ThresholdCurve& thresholdCurve, const std::string& prefix, const std::string& fileName )
+{
+//---summary to the console and the result file
+	std::string message = prefix + thresholdCurve.makeSummary() + "\n";
+	std::cout << message;
+	writer->write( OUTFILE_RESULT, std::move( message ) );
+
+//---curve file: a row per threshold
+	std::string buffer = "threshold,truePositives,falsePositives,trueNegatives,falseNegatives,accuracy,accuracyW,truePositiveRate,falsePositiveRate,precision,truePositiveRateW,falsePositiveRateW,precisionW";
+	const std::vector<ThresholdCurve::Point>& points = thresholdCurve.getPoints();
+	const ThresholdCurve::Point& lastPoint = points.back(); //everything predicted as 1: the class totals
+	for( uint p = 0; p < points.size(); p++ )
+	{
+		buffer += "\n";
+		AsyncWriter::appendNumber( buffer, points[p].threshold );
+		for( double value : { points[p].truePositives, points[p].falsePositives, lastPoint.falsePositives - points[p].falsePositives, lastPoint.truePositives - points[p].truePositives
+			, thresholdCurve.getAccuracy( p ), thresholdCurve.getWeightedAccuracy( p ), thresholdCurve.getTruePositiveRate( p ), thresholdCurve.getFalsePositiveRate( p ), thresholdCurve.getPrecision( p )
+			, thresholdCurve.getTruePositiveRate( p, true ), thresholdCurve.getFalsePositiveRate( p, true ), thresholdCurve.getPrecision( p, true ) } )
+		{
+			buffer += ',';
+			AsyncWriter::appendNumber( buffer, value );
+		}
+	}
+	buffer += "\n";
+	writer->write( fileName, std::move( buffer ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+	return true;
+}
+
 bool Emitter::printMeanKfoldValues( uint k )
 {
 //---construct the message
@@ -230,15 +439,11 @@ bool Emitter::printMeanKfoldValues( uint k )
     std::cout << "\n *FINAL AVERAGED RESULT*\n" << messageTrain << messageVal << messageFair;
    
 //---result file
-    resultFile->open( OUTFILE_RESULT, std::ios_base::app );
-    if( ! resultFile->is_open() )
-        return false;
-    (*resultFile) << "\n\n *FINAL AVERAGED RESULT*\n" << messageTrain << messageVal << messageFair;
-    resultFile->close();
+    writer->write( OUTFILE_RESULT, "\n\n *FINAL AVERAGED RESULT*\n" + messageTrain + messageVal + messageFair );
     return true;
 }
 
-void Emitter::printAll( NeuralWebBase* currentNet, const Dataset* dataset, int setIndex, uint currentFold, bool bSaveNet, bool bSavePredictions, bool bEnsemble, const std::string& sufix )
+void Emitter::printAll( NeuralWebBase* currentNet, const Dataset* dataset, int setIndex, uint currentFold, bool bSaveNet, bool bSavePredictions, bool bEnsemble, const std::string& sufix, const std::vector<double>* predictions )
 {
 	if( bEnsemble )
 		bSaveNet = false;
@@ -250,13 +455,276 @@ void Emitter::printAll( NeuralWebBase* currentNet, const Dataset* dataset, int s
     printExternalMetrics( &currentNet->getReflectedMetrics( correctedSetIndex ), ( bEnsemble ? "ensemble " : "" ) + resizeStr( setNames[setIndex], EMITTER_SET_NAME_FIXED_SIZE ) + " " );
     addMetrics( &currentNet->getReflectedMetrics( correctedSetIndex ), setIndex );
 
-    if( bSaveNet )
-        Emitter::printNetwork( static_cast<NeuralWeb*>(currentNet), FLAG_NET_TRAINED, MAKE_FILENAME( OUTFILE_NET_W + sufix, currentFold ), MAKE_FILENAME( OUTFILE_NET_ACTI + sufix, currentFold ), MAKE_FILENAME( OUTFILE_NET_METRICS + sufix, currentFold ) );
+    if( bSaveNet && netFormat != NET_FORMAT_BINARY ) //formatted here, written by the writer thread
+    {
+        writer->write( MAKE_FILENAME( OUTFILE_NET_W + sufix, currentFold ), makeNetworkText( static_cast<NeuralWeb*>(currentNet), FLAG_NET_TRAINED ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+        writer->write( MAKE_FILENAME( OUTFILE_NET_ACTI + sufix, currentFold ), makeActivationText( static_cast<NeuralWeb*>(currentNet) ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+        writer->write( MAKE_FILENAME( OUTFILE_NET_METRICS + sufix, currentFold ), makeMetricsText( static_cast<NeuralWeb*>(currentNet) ), FLAG_WRITE_NEW | FLAG_WRITE_CLOSE );
+    }
+    if( bSaveNet && netFormat != NET_FORMAT_TEXT )
+        writer->write( MAKE_BINARY_FILENAME( MAKE_FILENAME( OUTFILE_NET_W + sufix, currentFold ) ), makeNetworkBinary( static_cast<NeuralWeb*>(currentNet) ), FLAG_WRITE_NEW | FLAG_WRITE_BINARY | FLAG_WRITE_CLOSE );
 
-    if( bSavePredictions )
+    if( bSavePredictions || bSaveThresholdCurves )
     {
-        Dataset datasetPred = Dataset( dataset->getReflectedFold( correctedSetIndex )->getInputs(), {}, {} );
-        datasetPred.generateOutputs( currentNet );
-        printDataset( dataset->getReflectedFold( correctedSetIndex ).get(), datasetPred, FLAG_DATA_ALL, MAKE_FILENAME( OUTFILE_DATAPRED +  ( bEnsemble ? std::string( "_ensemble " ) : std::string( "" ) ) + ( "_" + setNames[setIndex] ) + sufix, currentFold ) );  
+        DatasetSP fold = dataset->getReflectedFold( correctedSetIndex );
+        Dataset datasetPred = Dataset( fold->getInputs(), {}, {} );
+        if( predictions != nullptr )
+            datasetPred.setOutputs( *predictions );
+        else
+            datasetPred.generateOutputs( currentNet );
+        if( bSavePredictions )
+            printDataset( *fold, datasetPred, FLAG_DATA_ALL, MAKE_FILENAME( OUTFILE_DATAPRED +  ( bEnsemble ? std::string( "_ensemble " ) : std::string( "" ) ) + ( "_" + setNames[setIndex] ) + sufix, currentFold ) );  
+        if( bSaveThresholdCurves && ! fold->getOutputs().empty() ) //the predictions made once serve every threshold
+            printThresholdCurve( ThresholdCurve( datasetPred.getOutputs().data(), fold->getOutputs(), fold->getInstanceWeights(), currentNet->getParams().classThreshold ), ( bEnsemble ? "ensemble " : "" ) + resizeStr( setNames[setIndex], EMITTER_SET_NAME_FIXED_SIZE ) + " "
+                , MAKE_FILENAME( OUTFILE_THRESHOLD_CURVE + ( bEnsemble ? std::string( "_ensemble" ) : std::string( "" ) ) + ( "_" + setNames[setIndex] ) + sufix, currentFold ) );
     }
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+std::string Emitter::makeNetworkText( const NeuralWeb* net, uint64_t options )
+{
+	const std::vector<ArcSP>& netArcs = net->getArcs();
+	std::string buffer;
+
+	if( GET_FLAG( options, FLAG_NET_TRAINED ) ) //trained net: biases included
+	{
+		for( uint a = 0; a < netArcs.size(); a++ )
+		{
+			buffer += netArcs[a]->getParent() != nullptr ? netArcs[a]->getParent()->getName() : "bias"; //actual arc or bias
+			buffer += EMITTER_NET_SEPARATOR;
+			AsyncWriter::appendNumber( buffer, netArcs[a]->getWeight() );
+			buffer += EMITTER_NET_SEPARATOR;
+			buffer += netArcs[a]->getChild()->getName();
+
+			if( a < netArcs.size() - 1 )
+				buffer += "\n";
+		}
+	}
+	else //untrained net: biased not saved
+	{
+		for( uint a = 0; a < netArcs.size(); a++ )
+		{
+			std::string signStr = "";
+			if( netArcs[a]->getSign() == Arc::Sign::NEG )
+				signStr = PARSER_NET_ARCS_SIGN_NEG;
+			else if( netArcs[a]->getSign() == Arc::Sign::ANY )
+				signStr = PARSER_NET_ARCS_SIGN_ANY;
+
+			if( netArcs[a]->getParent() != nullptr )
+			{
+				if( a >= 1 )
+					buffer += "\n";
+				buffer += netArcs[a]->getParent()->getName() + EMITTER_NET_SEPARATOR + signStr + EMITTER_NET_SEPARATOR + netArcs[a]->getChild()->getName();
+			}
+		}
+	}
+	return buffer;
+}
+
+std::string Emitter::makeActivationText( const NeuralWeb* net )
+{
+	const std::vector<NodeSP>& netNodes = net->getNodes();
+	std::string buffer;
+	for( uint n = 0; n < netNodes.size(); n++ )
+	{
+		if( netNodes[n]->getBTrainableScale() ) //scale of untrainable nodes = input layer is always 1 -> don't print
+		{
+			buffer += netNodes[n]->getName() + EMITTER_NET_SEPARATOR;
+			AsyncWriter::appendNumber( buffer, netNodes[n]->getScales()[0] );
+		}
+
+		if( n < netNodes.size() - 1 )
+			buffer += "\n";
+	}
+	return buffer;
+}
+
+std::string Emitter::makeMetricsText( const NeuralWeb* net )
+{
+	std::string buffer;
+	//train
+	const Metrics& netTrainMetrics = net->getTrainMetrics();
+	for( uint m = 0; m < metricNames.size(); m++ )
+	{
+		buffer += setNames[INDEX_SET_TRAIN] + "_" + metricNames[m] + PARSER_EQUAL;
+		AsyncWriter::appendNumber( buffer, netTrainMetrics.getMember( m ) );
+		buffer += "\n";
+	}
+	//val
+	const Metrics& netValMetrics = net->getTestMetrics();
+	for( uint m = 0; m < metricNames.size(); m++ )
+	{
+		buffer += setNames[INDEX_SET_VAL] + "_"  + metricNames[m] + PARSER_EQUAL;
+		AsyncWriter::appendNumber( buffer, netValMetrics.getMember( m ) );
+		if( m < metricNames.size() - 1 )
+			buffer += "\n";
+	}
+	return buffer;
+}
+
+std::string Emitter::makeNetworkBinary( const NeuralWeb* net )
+{
+//---values: parameter vector + train and val metrics (same as the text metrics file)
+	std::vector<double> values = net->getParamValues();
+	for( uint m = 0; m < metricNames.size(); m++ )
+		values.push_back( net->getTrainMetrics().getMember( m ) );
+	for( uint m = 0; m < metricNames.size(); m++ )
+		values.push_back( net->getTestMetrics().getMember( m ) );
+
+	Parser::NetFileHeader fileHeader;
+	std::memcpy( fileHeader.magic, PARSER_NET_BINARY_MAGIC, sizeof( fileHeader.magic ) );
+	fileHeader.version = PARSER_NET_BINARY_VERSION;
+	fileHeader.topologyHash = net->getTopologyHash();
+	fileHeader.paramNum = net->getParamNum();
+	fileHeader.metricNum = metricNames.size() * 2;
+
+	std::string buffer( reinterpret_cast<const char*>( &fileHeader ), sizeof( fileHeader ) );
+	buffer.append( reinterpret_cast<const char*>( values.data() ), values.size() * sizeof( double ) );
+	return buffer;
+}
+
+std::string Emitter::makeDatasetHeader( uint64_t options ) const
+{
+	if( GET_FLAG( options, FLAG_DATA_BINARY ) )
+	{
+		Parser::PredictionFileHeader fileHeader;
+		std::memcpy( fileHeader.magic, PARSER_PRED_BINARY_MAGIC, sizeof( fileHeader.magic ) );
+		fileHeader.version = PARSER_PRED_BINARY_VERSION;
+		fileHeader.inputNum = header.size() - 1;
+		fileHeader.recordBytes = 2 * sizeof( double ) + ( fileHeader.inputNum + 7 ) / 8;
+		return std::string( reinterpret_cast<const char*>( &fileHeader ), sizeof( fileHeader ) );
+	}
+
+	std::string buffer = header[0]; //"output"
+
+	if( GET_FLAG( options, FLAG_DATA_PRED ) ) //output predictions
+	{
+		buffer += "," + header[0] + "_predictedBool";
+		buffer += "," + header[0] + "_predictedReal";
+	}
+	if( GET_FLAG( options, FLAG_DATA_WEIGHT ) ) //instance weights
+		buffer += ",weights";
+
+	if( GET_FLAG( options, FLAG_DATA_COUNT ) ) //number of 0 inputs
+		buffer += ",zeros_num";
+
+	if( GET_FLAG( options, FLAG_DATA_COMPACT ) ) //indexes of the 0 inputs
+		buffer += "," PARSER_DATA_COMPACT_COLUMN;
+	else
+	{
+		for( uint h = 1; h < header.size(); h++ ) //inputs
+			buffer += "," + header[h];
+	}
+	buffer += "\n";
+	return buffer;
+}
+
+uint64_t Emitter::writeDatasetRows( const std::string& fileName, const Dataset& correctDataset, const Dataset& predictedDataset, uint64_t options, double outputLBound, double outputUBound, double classThreshold, bool bFirstRow ) const
+{
+	uint rowNum = correctDataset.getInputs().size();
+	uint64_t printedNum = 0;
+	std::vector<std::string> buffers( ThreadHandler::getThreadNum() );
+	std::vector<uint64_t> blockPrintedNums( ThreadHandler::getThreadNum() );
+
+//---format batches of rows in parallel, each thread a contiguous block in its own buffer. The buffers are queued in block order, so the rows keep their order
+	for( uint batchBegin = 0; batchBegin < rowNum; batchBegin += std::min<uint>( rowNum - batchBegin, EMITTER_FORMAT_BATCH_ROWS ) )
+	{
+		uint batchEnd = batchBegin + std::min<uint>( rowNum - batchBegin, EMITTER_FORMAT_BATCH_ROWS );
+		ThreadHandler::parallelFor( batchBegin, batchEnd, [&]( uint blockBegin, uint blockEnd, uint threadIndex )
+		{
+			std::string& buffer = buffers[threadIndex];
+			blockPrintedNums[threadIndex] = 0;
+			for( uint d = blockBegin; d < blockEnd; d++ )
+			{
+			//---filter by predicted real ouput
+				if( GET_FLAG( options, FLAG_DATA_FILTER ) && ( predictedDataset.getOutputs()[d] < outputLBound || predictedDataset.getOutputs()[d] > outputUBound ) )
+					continue;
+				appendDatasetRow( buffer, correctDataset, predictedDataset, d, options, classThreshold );
+				blockPrintedNums[threadIndex]++;
+			}
+		}, EMITTER_FORMAT_MIN_BLOCK_ROWS );
+
+		for( uint t = 0; t < buffers.size(); t++ )
+		{
+			if( buffers[t].empty() )
+				continue;
+			if( bFirstRow && printedNum == 0 && ! GET_FLAG( options, FLAG_DATA_BINARY ) ) //rows are separated by line breaks, with no line break before the first one
+				buffers[t].erase( 0, 1 );
+			printedNum += blockPrintedNums[t];
+			writer->write( fileName, std::move( buffers[t] ) );
+			buffers[t].clear();
+		}
+	}
+	return printedNum;
+}
+
+void Emitter::appendDatasetRow( std::string& buffer, const Dataset& correctDataset, const Dataset& predictedDataset, uint d, uint64_t options, double classThreshold ) const
+{
+	InputSpan inputs = correctDataset.getInputs()[d];
+
+//---binary record: outputs and input bits
+	if( GET_FLAG( options, FLAG_DATA_BINARY ) )
+	{
+		buffer.append( reinterpret_cast<const char*>( &correctDataset.getOutputs()[d] ), sizeof( double ) );
+		buffer.append( reinterpret_cast<const char*>( &predictedDataset.getOutputs()[d] ), sizeof( double ) );
+		size_t bitsBegin = buffer.size();
+		buffer.resize( bitsBegin + ( inputs.size() + 7 ) / 8, '\0' );
+		for( uint i = 0; i < inputs.size(); i++ )
+		{
+			if( inputs[i] >= 0.5 )
+				buffer[ bitsBegin + i / 8 ] |= static_cast<char>( 1 << ( i % 8 ) );
+		}
+		return;
+	}
+
+//---output
+	buffer += '\n'; //removed before the first row of the file
+	AsyncWriter::appendNumber( buffer, correctDataset.getOutputs()[d] );
+
+	if( GET_FLAG( options, FLAG_DATA_PRED ) ) //predictions
+	{
+		buffer += PARSER_DATA_SEPARATOR;
+		buffer += predictedDataset.getOutputs()[d] >= classThreshold ? '1' : '0'; //binarized prediction
+		buffer += PARSER_DATA_SEPARATOR;
+		AsyncWriter::appendNumber( buffer, predictedDataset.getOutputs()[d] ); //real prediction
+	}
+	if( GET_FLAG( options, FLAG_DATA_WEIGHT ) ) //weights
+	{
+		buffer += PARSER_DATA_SEPARATOR;
+		AsyncWriter::appendNumber( buffer, correctDataset.getInstanceWeights()[d] );
+	}
+
+//---inputs
+	if( GET_FLAG( options, FLAG_DATA_COUNT ) ) //number of 0 in the inputs
+	{
+		uint64_t counter0 = 0;
+		for( uint i = 0; i < inputs.size(); i++ )
+		{
+			if( inputs[i] < 0.5 )
+				counter0++;
+		}
+		buffer += PARSER_DATA_SEPARATOR;
+		AsyncWriter::appendNumber( buffer, counter0 );
+	}
+	if( GET_FLAG( options, FLAG_DATA_COMPACT ) ) //indexes of the 0 inputs
+	{
+		buffer += PARSER_DATA_SEPARATOR;
+		bool bFirstIndex = true;
+		for( uint i = 0; i < inputs.size(); i++ )
+		{
+			if( inputs[i] >= 0.5 )
+				continue;
+			if( ! bFirstIndex )
+				buffer += ' ';
+			AsyncWriter::appendNumber( buffer, static_cast<uint64_t>( i ) );
+			bFirstIndex = false;
+		}
+		return;
+	}
+	for( uint i = 0; i < inputs.size(); i++ ) //input values
+	{
+		buffer += PARSER_DATA_SEPARATOR;
+		AsyncWriter::appendNumber( buffer, inputs[i] );
+	}
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "EnsembleSweep.hpp"
+#include "ThreadHandler.hpp" //sweep(), greedySelection()
+
+#include "Emitter.hpp" //metric and set names in makeResultText()
+
+#include <algorithm> //std::sort, std::unique in makeGrid(), std::count_if in makeGrid() and evaluate()
+#include <sstream> //makeSummary()
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+void EnsembleSweep::sweep( const MemberPredictions& selectionPredictions, const DatasetBase& selectionSet, const MemberPredictions& testPredictions, const DatasetBase& testSet )
+{
+    makeGrid();
+    if( results.empty() ) //no members
+        return;
+    ThreadHandler::parallelFor( 0, results.size(), [&]( uint blockBegin, uint blockEnd, uint )
+    {
+        for( uint r = blockBegin; r < blockEnd; r++ )
+            evaluate( results[r], selectionPredictions, selectionSet, testPredictions, testSet );
+    }, 1 );
+
+//---best grid setting in the selection set. The first one on ties
+    bestIndex = 0;
+    for( uint r = 1; r < results.size(); r++ )
+    {
+        if( bBetter( results[r].selectionMetrics.getMember( params.greedyCriterion ), results[bestIndex].selectionMetrics.getMember( params.greedyCriterion ), params.greedyCriterion ) )
+            bestIndex = r;
+    }
+
+    if( params.greedySteps > 0 )
+        greedySelection( selectionPredictions, selectionSet, testPredictions, testSet );
+}
+
+std::string EnsembleSweep::makeSummary() const
+{
+    std::stringstream summary;
+    if( results.empty() )
+        return "ensemble sweep: no members\n";
+    summary << "ensemble sweep: " << results.size() - ( params.greedySteps > 0 ? 1 : 0 ) << " settings of " << ensemble->getMemberNets().size() << " members\n";
+    summary << "best setting:   " << makeResultText( results[bestIndex], params.greedyCriterion ) << "\n";
+    if( params.greedySteps > 0 )
+        summary << "greedy members: " << makeResultText( results.back(), params.greedyCriterion ) << "\n";
+    return summary.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+void EnsembleSweep::makeGrid()
+///a threshold between two member values includes the same members as the lower one (loss criteria) or the higher one (accuracy criteria), so the member values are all the thresholds that matter.
+///With weighting, loss criteria weight each member by threshold - value: the member at the threshold gets weight 0
+{
+    const std::vector<NeuralWebSP>& memberNets = ensemble->getMemberNets();
+    results.clear();
+    results.push_back( Result( NeuralWebEnsemble::EnsembleParams( false, NO_METRIC, 0.0 ) ) );
+    for( int criterion = 0; criterion < METRIC_NUM; criterion++ )
+    {
+        std::vector<double> thresholds( memberNets.size() );
+        for( uint n = 0; n < memberNets.size(); n++ )
+            thresholds[n] = memberNets[n]->getSavedMetrics().getMember( criterion );
+        std::sort( thresholds.begin(), thresholds.end() );
+        thresholds.erase( std::unique( thresholds.begin(), thresholds.end() ), thresholds.end() );
+        for( uint t = 0; t < thresholds.size(); t++ )
+        {
+            results.push_back( Result( NeuralWebEnsemble::EnsembleParams( false, criterion, thresholds[t] ) ) );
+            results.push_back( Result( NeuralWebEnsemble::EnsembleParams( true, criterion, thresholds[t] ) ) );
+        }
+    }
+
+//---member weights of each setting. Settings without members (predictions of -1) are dropped
+    std::vector<Result> settings;
+    for( uint r = 0; r < results.size(); r++ )
+    {
+        results[r].memberWeights = ensemble->getMemberWeights( results[r].ensembleParams );
+        if( std::count_if( results[r].memberWeights.begin(), results[r].memberWeights.end(), []( double weight ) { return weight > 0.0; } ) > 0 )
+            settings.push_back( results[r] );
+    }
+    results.swap( settings );
+}
+
+void EnsembleSweep::evaluate( Result& result, const MemberPredictions& selectionPredictions, const DatasetBase& selectionSet, const MemberPredictions& testPredictions, const DatasetBase& testSet ) const
+{
+    result.memberNum = std::count_if( result.memberWeights.begin(), result.memberWeights.end(), []( double weight ) { return weight > 0.0; } );
+    result.selectionMetrics = ensemble->calculateMetrics( selectionPredictions.combine( result.memberWeights ).data(), selectionSet.getOutputs(), selectionSet.getInstanceWeights() );
+    result.testMetrics = ensemble->calculateMetrics( testPredictions.combine( result.memberWeights ).data(), testSet.getOutputs(), testSet.getInstanceWeights() );
+}
+
+void EnsembleSweep::greedySelection( const MemberPredictions& selectionPredictions, const DatasetBase& selectionSet, const MemberPredictions& testPredictions, const DatasetBase& testSet )
+///forward selection with repetition: a member chosen several times weighs more in the average
+{
+    uint memberNum = ensemble->getMemberNets().size();
+    Result greedy( ensemble->getEnsembleParams(), true );
+    greedy.memberWeights.assign( memberNum, 0.0 );
+    std::vector<double> candidateValues( memberNum );
+    bool bFirst = true;
+    double currentValue = 0.0;
+    for( uint step = 0; step < params.greedySteps; step++ )
+    {
+    //---criterion value in the selection set with each member added once more
+        ThreadHandler::parallelFor( 0, memberNum, [&]( uint blockBegin, uint blockEnd, uint )
+        {
+            for( uint m = blockBegin; m < blockEnd; m++ )
+            {
+                std::vector<double> candidateWeights = greedy.memberWeights;
+                candidateWeights[m] += 1.0;
+                candidateValues[m] = ensemble->calculateMetrics( selectionPredictions.combine( candidateWeights ).data(), selectionSet.getOutputs(), selectionSet.getInstanceWeights() ).getMember( params.greedyCriterion );
+            }
+        }, 1 );
+
+    //---keep the best one if it improves the ensemble. The first one on ties
+        uint best = 0;
+        for( uint m = 1; m < memberNum; m++ )
+        {
+            if( bBetter( candidateValues[m], candidateValues[best], params.greedyCriterion ) )
+                best = m;
+        }
+        if( ! bFirst && ! bBetter( candidateValues[best], currentValue, params.greedyCriterion ) )
+            break;
+        greedy.memberWeights[best] += 1.0;
+        currentValue = candidateValues[best];
+        bFirst = false;
+    }
+    evaluate( greedy, selectionPredictions, selectionSet, testPredictions, testSet );
+    results.push_back( greedy );
+}
+
+std::string EnsembleSweep::makeResultText( const Result& result, int criterion )
+{
+    std::stringstream text;
+    if( result.bGreedy )
+        text << "greedy by " << Emitter::metricNames[criterion];
+    else if( result.ensembleParams.qualityCriterion == NO_METRIC )
+        text << "all members";
+    else
+        text << Emitter::metricNames[ result.ensembleParams.qualityCriterion ] << ( result.ensembleParams.qualityCriterion < METRIC_LOSS_NUM ? " <= " : " >= " ) << result.ensembleParams.qualityThreshold << ( result.ensembleParams.bWeighted ? " weighted" : "" );
+    text << " (" << result.memberNum << " members)  " << Emitter::setNames[INDEX_SET_TRAIN] << " " << Emitter::metricNames[criterion] << ": " << result.selectionMetrics.getMember( criterion )
+         << "  " << Emitter::setNames[INDEX_SET_TEST] << " " << Emitter::metricNames[criterion] << ": " << result.testMetrics.getMember( criterion );
+    return text.str();
+}
@@ -65,7 +65,7 @@ NeuralWebSP GeneticAlgorithm::popNet( uint netIndex )
 
 
 // ======================================================================================================= *API* =======================================================================================================
-void GeneticAlgorithm::train( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint generationNum, bool evaluateAll )
+void GeneticAlgorithm::train( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint generationNum, bool evaluateAll )
 {
 	if( evaluateAll == true )
 		evaluateWholePopulation( inputs, outputs, instanceWeights );
@@ -81,7 +81,7 @@ void GeneticAlgorithm::train( const std::vector<std::vector<double>>& inputs, co
 	}
 }
 
-void GeneticAlgorithm::evaluateWholePopulation( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights )
+void GeneticAlgorithm::evaluateWholePopulation( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights )
 { 
 	totalMetrics.reset( 0.0 );
 	for( uint n = 0; n < currentPopulation.size(); n++ ) 
@@ -120,7 +120,7 @@ void GeneticAlgorithm::selectParents()
 	}
 }
 
-void GeneticAlgorithm::mmxCross( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights )
+void GeneticAlgorithm::mmxCross( const DataMatrix& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights )
 {
 //---create copies of any of the parents for the children
 	for( uint c = 0; c < gaParams.outspringNum; c++ )
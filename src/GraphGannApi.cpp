@@ -0,0 +1,231 @@
+#define GRAPHGANN_EXPORTS //export the API from the shared library on Windows
+#include "GraphGannApi.h"
+
+#include "defines.hpp"
+#include "Parser.hpp" //options, reference net and trained parameters
+#include "NeuralWeb.hpp" //nets
+#include "NeuralWebEnsemble.hpp" //ensembles
+#include "DataMatrix.hpp" //caller inputs wrapped without copying
+#include "ThreadHandler.hpp" //threadNum of the options
+
+#include <memory> //models
+#include <vector> //outputs, weights, names
+#include <string> //names, error messages
+#include <sstream> //messages of the loads
+#include <mutex> //getLoadMutex()
+#include <algorithm> //std::max in gg_load_ensemble()
+#include <cstring> //std::strncpy in setError()
+
+
+///a loaded net or ensemble: the reference net its members are copies of, the predictor and the input names
+struct gg_model
+{
+    NeuralWebSP referenceNet;
+    std::shared_ptr<NeuralWebBase> predictor; //the net or the ensemble
+    uint memberNum;
+    std::vector<std::string> inputNames; //in the order of the input columns
+};
+
+
+namespace
+{
+    inline std::mutex& getLoadMutex() { static std::mutex mutex; return mutex; } //loads set the global threadNum of the options: serialized
+
+    void setError( char* error, size_t errorSize, const std::string& message ) //copy a message into the caller buffer, truncated and terminated
+    {
+        if( error == nullptr || errorSize == 0 )
+            return;
+        std::strncpy( error, message.c_str(), errorSize - 1 );
+        error[ errorSize - 1 ] = '\0';
+    }
+
+    //options (or the defaults) and the reference net. Null if any file fails, with the reason in message
+    NeuralWebSP loadReferenceNet( Parser& parser, const char* optionsFile, const char* referenceNetFile, std::string& message )
+    {
+        if( referenceNetFile == nullptr )
+        {
+            message = "Error: no reference net file\n";
+            return nullptr;
+        }
+        if( optionsFile != nullptr && ! parser.parseOptions( optionsFile ) )
+        {
+            message = "Error: cannot open the options file " + std::string( optionsFile ) + "\n";
+            return nullptr;
+        }
+        ThreadHandler::setThreadNum( parser.getUintParam( "threadNum" ) );
+        if( ! parser.parseNetwork( FLAG_NULL, referenceNetFile ) )
+        {
+            message = "Error: cannot load the reference net " + std::string( referenceNetFile ) + "\n";
+            return nullptr;
+        }
+        NeuralWebSP referenceNet = std::make_shared<NeuralWeb>( parser );
+        parser.setHeader( referenceNet->getHeader() );
+        return referenceNet;
+    }
+
+    gg_model* makeModel( const NeuralWebSP& referenceNet, const std::shared_ptr<NeuralWebBase>& predictor, uint memberNum )
+    {
+        gg_model* model = new gg_model;
+        model->referenceNet = referenceNet;
+        model->predictor = predictor;
+        model->memberNum = memberNum;
+        std::vector<std::string> header = referenceNet->getHeader();
+        model->inputNames.assign( header.begin() + 1, header.end() ); //the first name is the output
+        return model;
+    }
+
+    //caller rows as a read-only matrix, without copying them
+    inline DataMatrix wrapInputs( const gg_model* model, const double* inputs, size_t rowNum, size_t rowStride )
+    {
+        return DataMatrix( inputs, static_cast<uint>( rowNum ), model->inputNames.size(), static_cast<uint>( rowStride ), nullptr );
+    }
+
+    inline int checkArguments( const gg_model* model, const double* inputs, size_t rowNum, size_t rowStride, const double* outputs )
+    {
+        if( model == nullptr || inputs == nullptr || outputs == nullptr || rowNum == 0 || rowNum > UINT32_MAX )
+            return GG_ERROR_ARGUMENT;
+        if( rowStride < model->inputNames.size() || rowStride > UINT32_MAX )
+            return GG_ERROR_STRIDE;
+        return GG_OK;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////* LOAD *///////////////////////////////////////////////////////////////////////////////////////////////
+int gg_api_version( void )
+{
+    return GG_API_VERSION;
+}
+
+gg_model* gg_load_net( const char* optionsFile, const char* referenceNetFile, const char* trainedNetFile, char* error, size_t errorSize )
+{
+    std::lock_guard<std::mutex> lock( getLoadMutex() );
+    std::stringstream messages; //errors and warnings of the parser, returned instead of printed
+    Parser parser;
+    parser.setMessageStream( messages );
+    std::string message;
+    NeuralWebSP referenceNet = loadReferenceNet( parser, optionsFile, referenceNetFile, message );
+    if( referenceNet != nullptr && ( trainedNetFile == nullptr || ! parser.parseNetworkBinary( trainedNetFile, referenceNet->getTopologyHash(), referenceNet->getParamNum() ) ) )
+        message = "Error: cannot load the trained net " + std::string( trainedNetFile == nullptr ? "(none)" : trainedNetFile ) + "\n";
+    if( ! message.empty() )
+    {
+        setError( error, errorSize, messages.str() + message );
+        return nullptr;
+    }
+
+    NeuralWebSP trainedNet = std::make_shared<NeuralWeb>( referenceNet.get() );
+    trainedNet->setParamValues( parser.getParamValues().data() );
+    trainedNet->setTestMetrics( parser.getMetrics() );
+    setError( error, errorSize, messages.str() ); //warnings
+    return makeModel( referenceNet, trainedNet, 1 );
+}
+
+gg_model* gg_load_ensemble( const char* optionsFile, const char* referenceNetFile, const char* bundleFile, char* error, size_t errorSize )
+{
+    std::lock_guard<std::mutex> lock( getLoadMutex() );
+    std::stringstream messages; //errors and warnings of the parser, returned instead of printed
+    Parser parser;
+    parser.setMessageStream( messages );
+    std::string message;
+    NeuralWebSP referenceNet = loadReferenceNet( parser, optionsFile, referenceNetFile, message );
+    uint netNum = parser.getUintParam( "netNum" );
+    if( referenceNet != nullptr && ( bundleFile == nullptr || ! parser.parseEnsembleBinary( bundleFile, referenceNet->getTopologyHash(), referenceNet->getParamNum(), netNum, parser.getUintParam( "netIndex" ) ) ) )
+        message = "Error: cannot load the ensemble bundle " + std::string( bundleFile == nullptr ? "(none)" : bundleFile ) + "\n";
+    if( ! message.empty() )
+    {
+        setError( error, errorSize, messages.str() + message );
+        return nullptr;
+    }
+
+//---each row of the parameter matrix into a copy of the reference net, in order (as MainClass::loadEnsemble())
+    std::shared_ptr<NeuralWebEnsemble> ensemble = std::make_shared<NeuralWebEnsemble>( parser );
+    const std::vector<double>& paramValues = parser.getParamValues();
+    const std::vector<double>& metrics = parser.getMetrics();
+    uint paramNum = referenceNet->getParamNum();
+    uint metricNum = metrics.size() / std::max( 1u, netNum );
+    for( uint n = 0; n < netNum; n++ )
+    {
+        NeuralWebSP memberNet = std::make_shared<NeuralWeb>( referenceNet.get() );
+        memberNet->setParamValues( paramValues.data() + static_cast<size_t>( n ) * paramNum );
+        memberNet->setTestMetrics( std::vector<double>( metrics.begin() + n * metricNum, metrics.begin() + ( n + 1 ) * metricNum ) );
+        ensemble->addMemberNet( memberNet );
+    }
+    setError( error, errorSize, messages.str() );
+    return makeModel( referenceNet, ensemble, netNum );
+}
+
+void gg_free( gg_model* model )
+{
+    delete model;
+}
+
+
+//////////////////////////////////////////////////////////////////////////* INFO *///////////////////////////////////////////////////////////////////////////////////////////////
+unsigned gg_input_count( const gg_model* model )
+{
+    return model == nullptr ? 0 : model->inputNames.size();
+}
+
+const char* gg_input_name( const gg_model* model, unsigned index )
+{
+    return model == nullptr || index >= model->inputNames.size() ? nullptr : model->inputNames[index].c_str();
+}
+
+unsigned gg_member_count( const gg_model* model )
+{
+    return model == nullptr ? 0 : model->memberNum;
+}
+
+unsigned gg_metric_count( void )
+{
+    return METRIC_NUM;
+}
+
+const char* gg_metric_name( unsigned index )
+{
+    for( std::map<std::string, int>::const_iterator metric = Parser::metricNM.begin(); metric != Parser::metricNM.end(); metric++ )
+    {
+        if( metric->second == static_cast<int>( index ) )
+            return metric->first.c_str();
+    }
+    return nullptr;
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PREDICTION *///////////////////////////////////////////////////////////////////////////////////////////////
+int gg_predict( const gg_model* model, const double* inputs, size_t rowNum, size_t rowStride, double* predictions )
+{
+    int result = checkArguments( model, inputs, rowNum, rowStride, predictions );
+    if( result != GG_OK )
+        return result;
+    model->predictor->predictBatch( wrapInputs( model, inputs, rowNum, rowStride ), 0, rowNum, predictions );
+    return GG_OK;
+}
+
+int gg_evaluate( const gg_model* model, const double* inputs, size_t rowNum, size_t rowStride, const double* outputs, const double* instanceWeights, double* metrics, double* predictions )
+{
+    int result = checkArguments( model, inputs, rowNum, rowStride, outputs );
+    if( result != GG_OK )
+        return result;
+    if( metrics == nullptr )
+        return GG_ERROR_ARGUMENT;
+
+//---instance weights adding up to 1, as the datasets weight them
+    std::vector<double> weights( rowNum, 1.0 / rowNum );
+    if( instanceWeights != nullptr )
+    {
+        double weightSum = 0.0;
+        for( size_t r = 0; r < rowNum; r++ )
+            weightSum += instanceWeights[r];
+        for( size_t r = 0; r < rowNum; r++ )
+            weights[r] = weightSum > 0.0 ? instanceWeights[r] / weightSum : 0.0;
+    }
+
+    std::vector<double> ownPredictions( predictions == nullptr ? rowNum : 0 );
+    double* setPredictions = predictions == nullptr ? ownPredictions.data() : predictions;
+    model->predictor->predictBatch( wrapInputs( model, inputs, rowNum, rowStride ), 0, rowNum, setPredictions );
+    Metrics setMetrics = model->predictor->calculateMetrics( setPredictions, std::vector<double>( outputs, outputs + rowNum ), weights );
+    for( uint m = 0; m < METRIC_NUM; m++ )
+        metrics[m] = setMetrics.getMember( m );
+    return GG_OK;
+}
@@ -0,0 +1,92 @@
+#include "InstanceFilterIndex.hpp"
+#include "DatasetBase.hpp" //filter datasets. Not included in the hpp file to avoid circular include with DatasetBase
+
+#include <algorithm> //std::stable_sort in indexSupersets()
+#include <numeric> //std::iota in indexSupersets()
+
+
+InstanceFilterIndex::Bits InstanceFilterIndex::pack( const InputSpan& instance, uint inputValue )
+{
+    Bits bits( ( instance.size() + 63 ) / 64, 0 );
+    for( uint i = 0; i < instance.size(); i++ )
+    {
+        if( ( instance[i] >= 0.5 ) == ( inputValue == 1 ) )
+            bits[ i / 64 ] |= static_cast<uint64_t>( 1 ) << ( i % 64 );
+    }
+    return bits;
+}
+
+void InstanceFilterIndex::indexEqual( const DatasetBase* filter )
+{
+    bEqual = true;
+    for( uint c = 0; c < filter->getInputs().size(); c++ )
+        equalSet.insert( pack( filter->getInputs()[c] ) );
+}
+
+void InstanceFilterIndex::indexSupersets( const DatasetBase* filter, uint inputValue, uint classValue )
+{
+    bSuperset = true;
+    supersetInputValue = inputValue;
+
+//---masks of the filter instances with the class of interest. Trivial instances (no input with inputValue, any instance would be a superset) are skipped
+    std::vector<Bits> masks;
+    for( uint c = 0; c < filter->getInputs().size(); c++ )
+    {
+        if( filter->getBoolOutputs()[c] != classValue ) //if the class does not match the one of interest, skip instance
+            continue;
+        Bits mask = pack( filter->getInputs()[c], inputValue );
+        if( popcount( mask ) > 0 )
+            masks.push_back( mask );
+    }
+
+//---sort by popcount and keep only the minimal ones: a superset of a bigger mask is a superset of any mask contained in it
+    std::vector<uint> order( masks.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::vector<uint> popcounts( masks.size() );
+    for( uint m = 0; m < masks.size(); m++ )
+        popcounts[m] = popcount( masks[m] );
+    std::stable_sort( order.begin(), order.end(), [&popcounts]( uint a, uint b ) { return popcounts[a] < popcounts[b]; } );
+
+    supersetMasks.clear();
+    supersetPopcounts.clear();
+    for( uint o = 0; o < order.size(); o++ )
+    {
+        const Bits& mask = masks[ order[o] ];
+        bool bContainsKept = false;
+        for( uint k = 0; k < supersetMasks.size() && ! bContainsKept; k++ )
+        {
+            bool bSubset = true;
+            for( uint w = 0; w < mask.size() && bSubset; w++ )
+                bSubset = ( supersetMasks[k][w] & ~mask[w] ) == 0;
+            bContainsKept = bSubset;
+        }
+        if( ! bContainsKept )
+        {
+            supersetMasks.push_back( mask );
+            supersetPopcounts.push_back( popcounts[ order[o] ] );
+        }
+    }
+}
+
+bool InstanceFilterIndex::findEqual( const InputSpan& instance ) const
+{
+    return bEqual && equalSet.find( pack( instance ) ) != equalSet.end();
+}
+
+bool InstanceFilterIndex::findSubset( const InputSpan& instance ) const
+{
+    if( ! bSuperset || supersetMasks.empty() )
+        return false;
+
+    Bits bits = pack( instance, supersetInputValue );
+    uint bitNum = popcount( bits );
+    for( uint m = 0; m < supersetMasks.size() && supersetPopcounts[m] <= bitNum; m++ ) //masks with more bits cannot be subsets
+    {
+        bool bSubset = true;
+        for( uint w = 0; w < bits.size() && bSubset; w++ )
+            bSubset = ( supersetMasks[m][w] & ~bits[w] ) == 0;
+        if( bSubset )
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,149 @@
+#include "KnockoutScreen.hpp"
+#include "ThreadHandler.hpp" //screen()
+
+#include <algorithm> //std::sort, std::min, std::max
+#include <chrono> //screening time
+#include <cmath> //std::abs
+#include <sstream> //makeSummary()
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+bool KnockoutScreen::screen( const DatasetBase& dataset )
+{
+    if( ! plan->getBValid() )
+    {
+        std::cout << "Error: the nets cannot be compiled (different topologies or product terms), knockouts need the compiled nets\n";
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const DataMatrix& inputs = dataset.getInputs();
+    rowNum = inputs.size();
+
+//---tasks: a range of the blocks of NET_PLAN_BLOCK_ROWS instances by a range of the knockouts, as many as threads. Knockouts are split first, the blocks only when there are fewer knockouts than threads
+    std::vector<NetPlan::Knockout> knockouts = makeKnockouts();
+    uint threadNum = ThreadHandler::getThreadNum();
+    uint blockNum = ( rowNum + NET_PLAN_BLOCK_ROWS - 1 ) / NET_PLAN_BLOCK_ROWS;
+    uint knockoutRangeNum = std::max<uint>( 1, std::min<uint>( knockouts.size(), threadNum ) );
+    uint blockRangeNum = std::max<uint>( 1, std::min<uint>( blockNum, threadNum / knockoutRangeNum ) );
+    size_t blockValueNum = plan->getValueNum( NET_PLAN_BLOCK_ROWS );
+
+//---each task calculates the baseline values of a block and recalculates the cone of each of its knockouts from them, before the next block. Only the values of a block per thread are kept, and sums per knockout and block range
+    const MetricsKernelBase& metricsKernel = evaluator->getMetricsKernel();
+    std::vector<MetricsKernelBase::Sums> baselineSums( blockRangeNum );
+    std::vector<KnockoutSums> knockoutSums( blockRangeNum * knockouts.size() ); //[block range][knockout]
+    ThreadHandler::parallelFor( 0, blockRangeNum * knockoutRangeNum, [&]( uint taskBegin, uint taskEnd, uint )
+    {
+        std::vector<double> baselineValues( blockValueNum );
+        std::vector<double> knockedValues( blockValueNum );
+        double baseline[NET_PLAN_BLOCK_ROWS];
+        double predictions[NET_PLAN_BLOCK_ROWS];
+        for( uint t = taskBegin; t < taskEnd; t++ )
+        {
+            uint blockRange = t / knockoutRangeNum;
+            uint knockoutRange = t % knockoutRangeNum;
+            uint knockoutBegin = static_cast<uint64_t>( knockouts.size() ) * knockoutRange / knockoutRangeNum;
+            uint knockoutEnd = static_cast<uint64_t>( knockouts.size() ) * ( knockoutRange + 1 ) / knockoutRangeNum;
+            uint blockBegin = static_cast<uint64_t>( blockNum ) * blockRange / blockRangeNum;
+            uint blockEnd = static_cast<uint64_t>( blockNum ) * ( blockRange + 1 ) / blockRangeNum;
+            for( uint b = blockBegin; b < blockEnd; b++ )
+            {
+                uint first = b * NET_PLAN_BLOCK_ROWS;
+                uint blockRowNum = std::min<uint>( rowNum - first, NET_PLAN_BLOCK_ROWS );
+                plan->calculateBlock( inputs, first, blockRowNum, baselineValues.data(), baseline );
+                if( knockoutRange == 0 ) //the baseline metrics once per block
+                    metricsKernel.accumulate( baselineSums[blockRange], baseline, dataset.getOutputs().data() + first, dataset.getInstanceWeights().data() + first, blockRowNum );
+                for( uint k = knockoutBegin; k < knockoutEnd; k++ )
+                {
+                    plan->predictKnockoutBlock( baselineValues.data(), knockedValues.data(), blockRowNum, knockouts[k], predictions );
+                    addBlock( knockoutSums[ blockRange * knockouts.size() + k ], predictions, baseline, first, blockRowNum, dataset );
+                }
+            }
+        }
+    }, 1 );
+
+//---the sums of the block ranges merged in order: shifts and metrics of each knockout
+    for( uint r = 1; r < blockRangeNum; r++ )
+        baselineSums[0].merge( baselineSums[r] );
+    baselineMetrics = metricsKernel.finish( baselineSums[0] );
+    results.assign( knockouts.size(), Result() );
+    for( uint k = 0; k < knockouts.size(); k++ )
+    {
+        KnockoutSums& sums = knockoutSums[k];
+        for( uint r = 1; r < blockRangeNum; r++ )
+        {
+            const KnockoutSums& rangeSums = knockoutSums[ r * knockouts.size() + k ];
+            sums.shiftSum += rangeSums.shiftSum;
+            sums.absShiftSum += rangeSums.absShiftSum;
+            sums.maxAbsShift = std::max( sums.maxAbsShift, rangeSums.maxAbsShift );
+            sums.flipNum += rangeSums.flipNum;
+            sums.metricSums.merge( rangeSums.metricSums );
+        }
+        results[k].meanShift = rowNum > 0 ? sums.shiftSum / rowNum : 0.0;
+        results[k].meanAbsShift = rowNum > 0 ? sums.absShiftSum / rowNum : 0.0;
+        results[k].maxAbsShift = sums.maxAbsShift;
+        results[k].flipNum = sums.flipNum;
+        results[k].metrics = metricsKernel.finish( sums.metricSums );
+
+    //---names from the reference net
+        const NetPlan::Knockout& knockout = knockouts[k];
+        results[k].bArc = knockout.term >= 0;
+        results[k].coneSize = knockout.cone.size();
+        if( results[k].bArc )
+        {
+            Arc* arc = referenceNet->getArcs()[ plan->getTermArcId( knockout.term ) ].get();
+            results[k].name = arc->getParent()->getName() + " -> " + arc->getChild()->getName();
+        }
+        else
+            results[k].name = referenceNet->getNodes()[ plan->getNodeId( knockout.node ) ]->getName();
+    }
+
+//---the largest effects first
+    std::stable_sort( results.begin(), results.end(), []( const Result& result1, const Result& result2 ) { return result1.meanAbsShift > result2.meanAbsShift; } );
+    seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    return true;
+}
+
+std::string KnockoutScreen::makeSummary() const
+{
+    uint arcNum = std::count_if( results.begin(), results.end(), []( const Result& result ) { return result.bArc; } );
+    std::stringstream summary;
+    summary << "knockout screening: " << results.size() - arcNum << " nodes and " << arcNum << " arcs over " << rowNum << " instances in " << seconds << " s\n";
+    for( uint r = 0; r < std::min<uint>( results.size(), KNOCKOUT_SUMMARY_RESULTS ); r++ )
+    {
+        summary << "  " << results[r].name << ": mean shift " << results[r].meanShift << ", mean abs shift " << results[r].meanAbsShift << ", " << results[r].flipNum << " class flips, "
+                << "lossW " << results[r].metrics.getMember( INDEX_METRIC_LOSS_W ) << " (intact " << baselineMetrics.getMember( INDEX_METRIC_LOSS_W ) << ")\n";
+    }
+    return summary.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<NetPlan::Knockout> KnockoutScreen::makeKnockouts() const
+{
+    std::vector<NetPlan::Knockout> knockouts;
+    for( uint n = 0; n < plan->getNodeNum(); n++ )
+    {
+        if( ! plan->getBOutput( n ) )
+            knockouts.push_back( plan->makeKnockout( n ) );
+        for( uint t = plan->getTermBegin( n ); params.bArcs && t < plan->getTermBegin( n + 1 ); t++ )
+        {
+            if( plan->getTermParent( t ) >= 0 )
+                knockouts.push_back( plan->makeKnockout( n, t ) );
+        }
+    }
+    return knockouts;
+}
+
+void KnockoutScreen::addBlock( KnockoutSums& sums, const double* predictions, const double* baseline, uint first, uint blockRowNum, const DatasetBase& dataset ) const
+{
+    for( uint r = 0; r < blockRowNum; r++ )
+    {
+        double shift = predictions[r] - baseline[r];
+        sums.shiftSum += shift;
+        sums.absShiftSum += std::abs( shift );
+        sums.maxAbsShift = std::max( sums.maxAbsShift, std::abs( shift ) );
+        if( ( predictions[r] >= params.classThreshold ) != ( baseline[r] >= params.classThreshold ) )
+            sums.flipNum++;
+    }
+    evaluator->getMetricsKernel().accumulate( sums.metricSums, predictions, dataset.getOutputs().data() + first, dataset.getInstanceWeights().data() + first, blockRowNum );
+}
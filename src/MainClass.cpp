@@ -1,11 +1,21 @@
 #include "MainClass.hpp"
 #include "Metrics.hpp" //progEvaluateEnsemble()
 #include "NeuralWebEnsemble.hpp" //ensemble programs
-
-#include <algorithm> //next_permutation in makeAllCombinations()
+#include "CombinationSearch.hpp" //progSearchCombinationsEnsemble()
+#include "EnsembleSweep.hpp" //progSweepEnsemble()
+#include "PredictionServer.hpp" //progServeEnsemble()
+#include "PredictionPipeline.hpp" //progPredictOutputsEnsemble()
+#include "KnockoutScreen.hpp" //progKnockoutScreen()
+#include "NodeAttribution.hpp" //progAttribution()
+#include "CombinationStream.hpp" //progMakeInputCombinations(), progPredictCombinationsStream()
+#include "ThreadHandler.hpp" //init(), loadEnsemble()
+#include "MappedFile.hpp" //getModificationTime() in loadEnsemble(), loadDataset()
+
+#include <algorithm> //next_permutation in makeAllCombinations(), std::find in loadEnsemble()
+#include <chrono> //loading time in loadEnsemble(), sweep time in progSweepEnsemble()
 
 //static
-std::vector<ProgramPointer> MainClass::programs( { MainClass::progTrainOnly, MainClass::progKFold, MainClass::progKFoldFair, MainClass::progKFoldFairEnsemble, MainClass::progTrainAndSaveNets, MainClass::progEvaluateEnsemble, MainClass::progPredictOutputsEnsemble, MainClass::progSplitDataset, MainClass::progMakeInputCombinations } );
+std::vector<ProgramPointer> MainClass::programs( { MainClass::progTrainOnly, MainClass::progKFold, MainClass::progKFoldFair, MainClass::progKFoldFairEnsemble, MainClass::progTrainAndSaveNets, MainClass::progEvaluateEnsemble, MainClass::progPredictOutputsEnsemble, MainClass::progSplitDataset, MainClass::progMakeInputCombinations, MainClass::progSearchCombinationsEnsemble, MainClass::progPredictCombinationsStream, MainClass::progMergePredictionParts, MainClass::progConvertDataset, MainClass::progConvertPredictions, MainClass::progSweepEnsemble, MainClass::progServeEnsemble, MainClass::progKnockoutScreen, MainClass::progAttribution } );
 
 
 
@@ -125,21 +135,26 @@ void MainClass::progKFoldFairEnsemble()
             printMetrics( currentFold  * 2, currentFold * 2 + 1, currentNetIndex, false, "_" + std::to_string( currentFold ) );
             ensemble.addMemberNet( bestNet );
         }
-    //---evaluate ensemble
+    //---evaluate ensemble: every member predicts each set once, the ensemble and member metrics come from those predictions
         emitter.printMessage( "\nENSEMBLE METRICS FOR FOLD " + std::to_string( currentFold) );
+        const Dataset& valDataset = *partialDatasets[ currentFold * 2 ];
+        const Dataset& fairDataset = *partialDatasets[ currentFold * 2 + 1 ];
+        MemberPredictions valMemberPredictions = ensemble.predictMembers( valDataset.getInputs() );
+        MemberPredictions fairMemberPredictions = ensemble.predictMembers( fairDataset.getInputs() );
         //val
-        ensemble.evaluateWeighted( partialDatasets[ currentFold * 2 ]->getInputs(), partialDatasets[ currentFold * 2 ]->getOutputs(), partialDatasets[ currentFold * 2 ]->getInstanceWeights(), INDEX_SET_VAL );
-        emitter.printAll( &ensemble, partialDatasets[ currentFold * 2 ].get(), INDEX_SET_VAL, currentFold, false, parser.getIntParam( "savePredictions"), true );
-        //fair test
-        ensemble.evaluateWeighted( partialDatasets[ currentFold * 2 + 1 ]->getInputs(), partialDatasets[ currentFold * 2 + 1 ]->getOutputs(), partialDatasets[ currentFold * 2 + 1 ]->getInstanceWeights(), INDEX_SET_TEST );
-        emitter.printAll( &ensemble, partialDatasets[ currentFold * 2 + 1 ].get(), INDEX_SET_TEST, currentFold, false, parser.getIntParam( "savePredictions"), true );
+        ensemble.evaluatePredictions( ensemble.predictFromMembers( valMemberPredictions ).data(), valDataset.getOutputs(), valDataset.getInstanceWeights(), INDEX_SET_VAL );
+        emitter.printAll( &ensemble, &valDataset, INDEX_SET_VAL, currentFold, false, parser.getIntParam( "savePredictions"), true );
+        //fair test (all test: the predictions of the set are the predictions to save)
+        std::vector<double> fairPredictions = ensemble.predictFromMembers( fairMemberPredictions );
+        ensemble.evaluatePredictions( fairPredictions.data(), fairDataset.getOutputs(), fairDataset.getInstanceWeights(), INDEX_SET_TEST );
+        emitter.printAll( &ensemble, &fairDataset, INDEX_SET_TEST, currentFold, false, parser.getIntParam( "savePredictions"), true, "", &fairPredictions );
 
     //evaluate separately each of the ensemble member nets and average
         //val
-        Metrics avgValMetrics = ensemble.averageMetrics( partialDatasets[ currentFold * 2 ]->getInputs(), partialDatasets[ currentFold * 2 ]->getOutputs(), partialDatasets[ currentFold * 2 ]->getInstanceWeights(), INDEX_SET_VAL );
+        Metrics avgValMetrics = ensemble.averageMetrics( valMemberPredictions, valDataset.getOutputs(), valDataset.getInstanceWeights(), INDEX_SET_VAL );
         emitter.printExternalMetrics( &avgValMetrics, "avg val  " );
         //fair test
-        Metrics avgFairMetrics = ensemble.averageMetrics( partialDatasets[ currentFold * 2 + 1 ]->getInputs(), partialDatasets[ currentFold * 2 + 1 ]->getOutputs(), partialDatasets[ currentFold * 2 + 1 ]->getInstanceWeights(), INDEX_SET_TEST );
+        Metrics avgFairMetrics = ensemble.averageMetrics( fairMemberPredictions, fairDataset.getOutputs(), fairDataset.getInstanceWeights(), INDEX_SET_TEST );
         emitter.printExternalMetrics( &avgFairMetrics, "avg fair " );
 
         summaryEnsembleFairMetrics.add( &ensemble.getTestMetrics() );
@@ -177,7 +192,7 @@ void MainClass::progTrainAndSaveNets()
         //---train a net and delete it after having accessed its data
             trainNet( ( currentNetIndex - parser.getIntParam( "netIndex" ) ) * 2, true );    
         //---load fair dataset
-            parser.parseDataset( FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, parser.getIntParam( "datasetIndex" ) ) );
+            loadDataset( MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, parser.getIntParam( "datasetIndex" ) ) );
             partialDatasets.push_back( std::make_shared<Dataset>( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) ) );
             partialDatasets.back()->weightInstances( parser.getRealParam( "instanceWeightByOutput" ), parser.getRealParam( "instanceWeightByInput" ) );
             partialDatasets.back()->makeAllTest();
@@ -208,34 +223,37 @@ void MainClass::progEvaluateEnsemble()
 
 //---load all the nets in the ensemble
     NeuralWebEnsemble ensemble( parser );
-    for( uint n = parser.getIntParam( "netIndex" ); n < params.k; n++ )
-        ensemble.addMemberNet( NeuralWebSP( loadTrainedNet( n ) ) );
-    std::cout << "nets loaded\n";
+    if( ! loadEnsemble( ensemble ) )
+        return;
 
 //---copy train dataset
     partialDatasets.push_back( std::make_shared<Dataset>( &dataset ) );
     partialDatasets.back()->makeAllTraining();
 
 //---parse fair dataset
-    parser.parseDataset( FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, parser.getIntParam( "datasetIndex" ) ) );
+    loadDataset( MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, parser.getIntParam( "datasetIndex" ) ) );
     partialDatasets.push_back( std::make_shared<Dataset>( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) ) );
     partialDatasets.back()->weightInstances( parser.getRealParam( "instanceWeightByOutput"), parser.getRealParam( "instanceWeightByInput") );
     partialDatasets.back()->makeAllTest();
 
-//---evaluate ensemble
+//---evaluate ensemble: every member predicts each set once, the ensemble and member metrics come from those predictions. Both sets are a single split with all the cases, so their predictions are the ones to save
+    MemberPredictions trainMemberPredictions = ensemble.predictMembers( partialDatasets[0]->getInputs() );
+    MemberPredictions fairMemberPredictions = ensemble.predictMembers( partialDatasets[1]->getInputs() );
     //train + val (named "train")
-    ensemble.evaluateWeighted( partialDatasets[0]->getInputs(), partialDatasets[0]->getOutputs(), partialDatasets[0]->getInstanceWeights(), INDEX_SET_TRAIN );
-    emitter.printAll( &ensemble, partialDatasets[0].get(), INDEX_SET_TRAIN, 0, false, parser.getIntParam( "savePredictions"), true );
+    std::vector<double> trainPredictions = ensemble.predictFromMembers( trainMemberPredictions );
+    ensemble.evaluatePredictions( trainPredictions.data(), partialDatasets[0]->getOutputs(), partialDatasets[0]->getInstanceWeights(), INDEX_SET_TRAIN );
+    emitter.printAll( &ensemble, partialDatasets[0].get(), INDEX_SET_TRAIN, 0, false, parser.getIntParam( "savePredictions"), true, "", &trainPredictions );
     //fair test
-    ensemble.evaluateWeighted( partialDatasets[1]->getInputs(), partialDatasets[1]->getOutputs(), partialDatasets[1]->getInstanceWeights(), INDEX_SET_TEST );
-    emitter.printAll( &ensemble, partialDatasets[1].get(), INDEX_SET_TEST, 0, false, parser.getIntParam( "savePredictions"), true );
+    std::vector<double> fairPredictions = ensemble.predictFromMembers( fairMemberPredictions );
+    ensemble.evaluatePredictions( fairPredictions.data(), partialDatasets[1]->getOutputs(), partialDatasets[1]->getInstanceWeights(), INDEX_SET_TEST );
+    emitter.printAll( &ensemble, partialDatasets[1].get(), INDEX_SET_TEST, 0, false, parser.getIntParam( "savePredictions"), true, "", &fairPredictions );
 
 //evaluate separately each of the ensemble member nets and average
     //train + val (named "train")
-    Metrics avgTrainMetrics = ensemble.averageMetrics( partialDatasets[0]->getInputs(), partialDatasets[0]->getOutputs(), partialDatasets[0]->getInstanceWeights(), INDEX_SET_TRAIN );
+    Metrics avgTrainMetrics = ensemble.averageMetrics( trainMemberPredictions, partialDatasets[0]->getOutputs(), partialDatasets[0]->getInstanceWeights(), INDEX_SET_TRAIN );
     emitter.printExternalMetrics( &avgTrainMetrics, "avg train " );
     //fair test
-    Metrics avgFairMetrics = ensemble.averageMetrics( partialDatasets[1]->getInputs(), partialDatasets[1]->getOutputs(), partialDatasets[1]->getInstanceWeights(), INDEX_SET_TEST );
+    Metrics avgFairMetrics = ensemble.averageMetrics( fairMemberPredictions, partialDatasets[1]->getOutputs(), partialDatasets[1]->getInstanceWeights(), INDEX_SET_TEST );
     emitter.printExternalMetrics( &avgFairMetrics, "avg fair " );
 
 //---clean
@@ -243,6 +261,104 @@ void MainClass::progEvaluateEnsemble()
     generatedDatasets.clear();
 }
 
+void MainClass::progSweepEnsemble()
+{
+    std::cout << "program = sweep the settings of the ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
+//---init
+    params.k = parser.getIntParam( "netIndex" ) + parser.getIntParam( "netNum" );
+
+//---load all the nets in the ensemble
+    NeuralWebEnsemble ensemble( parser );
+    if( ! loadEnsemble( ensemble ) )
+        return;
+
+//---train dataset (selection set) and fair dataset (test set), as in progEvaluateEnsemble()
+    partialDatasets.push_back( std::make_shared<Dataset>( &dataset ) );
+    loadDataset( MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, parser.getIntParam( "datasetIndex" ) ) );
+    partialDatasets.push_back( std::make_shared<Dataset>( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) ) );
+    partialDatasets.back()->weightInstances( parser.getRealParam( "instanceWeightByOutput"), parser.getRealParam( "instanceWeightByInput") );
+
+//---every member predicts each set once. Every setting is evaluated from those predictions
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    MemberPredictions trainMemberPredictions = ensemble.predictMembers( partialDatasets[0]->getInputs() );
+    MemberPredictions fairMemberPredictions = ensemble.predictMembers( partialDatasets[1]->getInputs() );
+    EnsembleSweep ensembleSweep( parser, &ensemble );
+    ensembleSweep.sweep( trainMemberPredictions, *partialDatasets[0], fairMemberPredictions, *partialDatasets[1] );
+    std::cout << ensembleSweep.makeSummary() << "swept in " << std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - start ).count() << " ms\n";
+    emitter.printMessage( ensembleSweep.makeSummary() );
+    emitter.printEnsembleSweep( ensembleSweep );
+
+//---clean
+    partialDatasets.clear();
+}
+
+void MainClass::progServeEnsemble()
+{
+    std::cout << "program = serve the predictions of the ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
+//---init
+    params.k = parser.getIntParam( "netIndex" ) + parser.getIntParam( "netNum" );
+
+//---load all the nets in the ensemble once, for all the requests
+    NeuralWebEnsemble ensemble( parser );
+    if( ! loadEnsemble( ensemble ) )
+        return;
+
+//---answer requests until a client sends shutdown
+    PredictionServer server( parser, &ensemble, net->getInputLayer().size() );
+    if( ! server.serve() )
+        return;
+    std::cout << server.makeSummary();
+    emitter.printMessage( server.makeSummary() );
+}
+
+void MainClass::progKnockoutScreen()
+{
+    std::cout << "program = knockout screening of the ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
+//---init
+    params.k = parser.getIntParam( "netIndex" ) + parser.getIntParam( "netNum" );
+
+//---load all the nets in the ensemble and compile the members with their weights
+    NeuralWebEnsemble ensemble( parser );
+    if( ! loadEnsemble( ensemble ) )
+        return;
+    std::vector<const NeuralWeb*> memberNets;
+    for( uint n = 0; n < ensemble.getMemberNets().size(); n++ )
+        memberNets.push_back( ensemble.getMemberNets()[n].get() );
+    NetPlan plan( memberNets, ensemble.getMemberWeights() );
+
+//---every knockout over the whole dataset
+    KnockoutScreen knockoutScreen( parser, &plan, net.get(), &ensemble );
+    if( ! knockoutScreen.screen( dataset ) )
+        return;
+    std::cout << knockoutScreen.makeSummary();
+    emitter.printMessage( knockoutScreen.makeSummary() );
+    emitter.printKnockoutScreen( knockoutScreen );
+}
+
+void MainClass::progAttribution()
+{
+    std::cout << "program = node attribution of the ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
+//---init
+    params.k = parser.getIntParam( "netIndex" ) + parser.getIntParam( "netNum" );
+
+//---load all the nets in the ensemble and compile the members with their weights
+    NeuralWebEnsemble ensemble( parser );
+    if( ! loadEnsemble( ensemble ) )
+        return;
+    std::vector<const NeuralWeb*> memberNets;
+    for( uint n = 0; n < ensemble.getMemberNets().size(); n++ )
+        memberNets.push_back( ensemble.getMemberNets()[n].get() );
+    NetPlan plan( memberNets, ensemble.getMemberWeights() );
+
+//---attributions of every instance of the dataset
+    NodeAttribution nodeAttribution( parser, &plan, net.get() );
+    if( ! nodeAttribution.attribute( dataset ) )
+        return;
+    std::cout << nodeAttribution.makeSummary();
+    emitter.printMessage( nodeAttribution.makeSummary() );
+    emitter.printAttributions( nodeAttribution );
+}
+
 void MainClass::progPredictOutputsEnsemble()
 {
     std::cout << "prediction with ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
@@ -251,22 +367,136 @@ void MainClass::progPredictOutputsEnsemble()
 
 //---load all the nets in the ensemble
     NeuralWebEnsemble ensemble( parser );
-    for( uint n = parser.getIntParam( "netIndex" ); n < params.k; n++ )
-        ensemble.addMemberNet( NeuralWebSP( loadTrainedNet( n) ) );
+    if( ! loadEnsemble( ensemble ) )
+        return;
     
-//---parse dataset (input combinations) 
-    parser.parseDataset( FLAG_NULL, MAKE_FILENAME( OUTFILE_INPUTCOMBIS, parser.getIntParam( "zerosNum" ) ) );
-    partialDatasets.push_back( std::make_shared<Dataset>( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) ) );
+//---stream the dataset (input combinations or the given file): read, predicted and printed by chunks, each stage in its own thread, so only a few chunks are in memory
+    std::string inputFileName = MAKE_FILENAME( OUTFILE_INPUTCOMBIS, parser.getIntParam( "zerosNum" ) );
+    std::string fileName = makePredictionFileName( MAKE_FILENAME3( OUTFILE_DATAPRED_FINAL, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) );
+    const std::string& externalFileName = parser.getStrParam( "predictionInputFile" );
+    if( externalFileName != PARSER_NO_FILE ) //predictions named after the file instead of zerosNum
+    {
+        inputFileName = FOLDER_DATA + externalFileName;
+        fileName = makePredictionFileName( MAKE_FILENAME2( OUTFILE_DATAPRED_FINAL + "_" + externalFileName.substr( 0, externalFileName.rfind( '.' ) ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) );
+    }
+    uint64_t options = makePredictionOptions( FLAG_DATA_ALL_FILTER );
+    PredictionPipeline pipeline( parser, &ensemble, &emitter );
+    if( ! pipeline.run( parser, inputFileName, fileName, options ) )
+    {
+        std::cout << "Error: cannot predict " << inputFileName << "\n";
+        return;
+    }
+    std::cout << pipeline.makeSummary();
+    emitter.printMessage( pipeline.makeSummary() );
+}
+
+void MainClass::progSearchCombinationsEnsemble()
+{
+    std::cout << "search of input combinations with " << parser.getIntParam( "zerosNum" ) << " zeros with ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
+//---init
+    params.k = parser.getIntParam( "netIndex" ) + parser.getIntParam( "netNum" );
+
+//---load all the nets in the ensemble
+    NeuralWebEnsemble ensemble( parser );
+    if( ! loadEnsemble( ensemble ) )
+        return;
+
+//---search the combinations (filtered by the base dataset) instead of parsing and predicting all of them
+    CombinationSearch combinationSearch( parser, &ensemble, &dataset );
+    combinationSearch.search( dataset.getInputs()[0].size() );
+    std::cout << combinationSearch.makeSummary() << "\n";
+    emitter.printMessage( combinationSearch.makeSummary() );
+
+//---save predicted dataset. Same format as progPredictOutputsEnsemble()
+    partialDatasets.push_back( std::make_shared<Dataset>( combinationSearch.getInputs(), std::vector<double>( combinationSearch.getInputs().size(), 1.0 ), std::vector<double>(), parser.getRealParam( "classThreshold" ) ) );
+    generatedDatasets.emplace_back( new Dataset( combinationSearch.getInputs(), combinationSearch.getOutputs(), {}, parser.getRealParam( "classThreshold" ) ) );
+    emitter.printDataset( *partialDatasets[0], *generatedDatasets[0], makePredictionOptions( FLAG_DATA_ALL ), makePredictionFileName( MAKE_FILENAME3( OUTFILE_DATAPRED_SEARCH, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) ) );
 
-//---generate and save predicted dataset
-    generatedDatasets.emplace_back( new Dataset( parser.getInputs(), {}, {}, parser.getRealParam( "classThreshold" ) ) );
-    generatedDatasets[0]->generateOutputs( &ensemble );
-    emitter.printDataset( partialDatasets[0].get(), generatedDatasets[0].get(), FLAG_DATA_ALL_FILTER, MAKE_FILENAME3( OUTFILE_DATAPRED_FINAL, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ), parser.getRealParam( "predictionPrintThresholdL" ), parser.getRealParam( "predictionPrintThresholdU" ) );
-    
 //---clean
     partialDatasets.clear();
     generatedDatasets.clear();
 }
+
+void MainClass::progPredictCombinationsStream()
+{
+    uint partIndex = parser.getUintParam( "combisPartIndex" );
+    uint partNum = parser.getUintParam( "combisPartNum" );
+    std::cout << "streamed prediction of input combinations with " << parser.getIntParam( "zerosNum" ) << " zeros (part " << partIndex << " of " << partNum << ") with ensemble of " << parser.getIntParam( "netNum" ) << " nets starting at " << parser.getIntParam( "netIndex" )  << "\n\n";
+    if( partIndex >= partNum )
+    {
+        std::cout << "Error: combisPartIndex must be lower than combisPartNum\n";
+        return;
+    }
+//---init
+    params.k = parser.getIntParam( "netIndex" ) + parser.getIntParam( "netNum" );
+
+//---load all the nets in the ensemble
+    NeuralWebEnsemble ensemble( parser );
+    if( ! loadEnsemble( ensemble ) )
+        return;
+
+//---range of combinations of this part. A single part is printed directly to the final file
+    CombinationStream combinationStream( dataset.getInputs()[0].size(), parser.getIntParam( "zerosNum" ) );
+    uint64_t first, last;
+    CombinationStream::partRange( combinationStream.getCombinationNum(), partIndex, partNum, first, last );
+    combinationStream = CombinationStream( dataset.getInputs()[0].size(), parser.getIntParam( "zerosNum" ), DEFAULT_DATASET_COMBI_INVERTED, first, last );
+
+    std::string fileName = makePredictionFileName( partNum > 1 ? MAKE_FILENAME4( OUTFILE_DATAPRED_PART, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ), partIndex ) 
+                                                          : MAKE_FILENAME3( OUTFILE_DATAPRED_FINAL, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) );
+    uint64_t options = makePredictionOptions( FLAG_DATA_ALL_FILTER );
+    emitter.printDatasetHeader( options, fileName );
+
+//---generate, filter, predict and print the combinations by chunks (bounded memory)
+    InstanceFilterIndex filterIndex = makeCombinationsFilter();
+    std::vector<std::vector<double>> chunk;
+    uint64_t printedNum = 0;
+    while( combinationStream.nextChunk( chunk, parser.getUintParam( "combisChunkSize" ) ) )
+    {
+        Dataset combinationsDataset( chunk, std::vector<double>( chunk.size(), 1.0 ), {}, parser.getRealParam( "classThreshold" ) );
+        combinationsDataset.filterInstances( filterIndex );
+        Dataset predictedDataset( combinationsDataset.getInputs(), {}, {}, parser.getRealParam( "classThreshold" ) );
+        predictedDataset.generateOutputs( &ensemble );
+        emitter.printDatasetChunk( combinationsDataset, predictedDataset, printedNum, options, fileName, parser.getRealParam( "predictionPrintThresholdL" ), parser.getRealParam( "predictionPrintThresholdU" ) );
+    }
+    std::cout << "combinations " << first << " to " << last << " of " << combinationStream.getCombinationNum() << " predicted, " << printedNum << " printed\n";
+}
+
+void MainClass::progMergePredictionParts()
+{
+    std::cout << "merge of " << parser.getIntParam( "combisPartNum" ) << " prediction parts\n\n";
+    std::vector<std::string> partFileNames;
+    for( uint p = 0; p < parser.getUintParam( "combisPartNum" ); p++ )
+        partFileNames.push_back( makePredictionFileName( MAKE_FILENAME4( OUTFILE_DATAPRED_PART, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ), p ) ) );
+
+    std::string fileName = makePredictionFileName( MAKE_FILENAME3( OUTFILE_DATAPRED_FINAL, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) );
+    bool bMerged = parser.getIntParam( "predictionFormat" ) == PREDICTION_FORMAT_BINARY ? Emitter::mergePredictionFilesBinary( partFileNames, fileName ) : Emitter::mergeDatasetFiles( partFileNames, fileName );
+    if( ! bMerged )
+        std::cout << "Error: prediction parts not merged\n";
+}
+
+void MainClass::progConvertPredictions()
+{
+    std::cout << "program = convert binary predictions to text\n\n";
+    std::vector<std::string> fileNames; //text names of the files made by the combination programs
+    fileNames.push_back( MAKE_FILENAME3( OUTFILE_DATAPRED_FINAL, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) );
+    fileNames.push_back( MAKE_FILENAME3( OUTFILE_DATAPRED_SEARCH, parser.getIntParam( "zerosNum" ), parser.getIntParam( "netNum" ), parser.getIntParam( "netIndex" ) ) );
+
+//---decode and print by chunks (bounded memory). The filter was applied when the binary file was made
+    for( uint f = 0; f < fileNames.size(); f++ )
+    {
+        if( ! parser.parsePredictionsBinary( MAKE_BINARY_FILENAME( fileNames[f] ), 0, 0 ) ) //missing or not valid
+            continue;
+        emitter.printDatasetHeader( FLAG_DATA_ALL, fileNames[f] );
+        uint64_t printedNum = 0;
+        while( parser.parsePredictionsBinary( MAKE_BINARY_FILENAME( fileNames[f] ), printedNum, parser.getUintParam( "combisChunkSize" ) ) && ! parser.getInputs().empty() )
+        {
+            Dataset correctDataset( parser.getInputs(), parser.getOutputs(), {}, parser.getRealParam( "classThreshold" ) );
+            Dataset predictedDataset( parser.getInputs(), parser.getPredictions(), {}, parser.getRealParam( "classThreshold" ) );
+            emitter.printDatasetChunk( correctDataset, predictedDataset, printedNum, FLAG_DATA_ALL, fileNames[f] );
+        }
+        std::cout << "converted " << MAKE_BINARY_FILENAME( fileNames[f] ) << ": " << printedNum << " rows\n";
+    }
+}
 //========================================================== end of EVALUATION AND PREDICTION PROGRAMS =======================================================
 
 
@@ -284,7 +514,7 @@ void MainClass::progSplitDataset()
 //---make folds
     Dataset wholeDataset( &dataset );
 
-    if( params.k >= partialDatasets.back()->getInputs().size() ) //if k => number of cases, leave one out
+    if( params.k >= dataset.getInputs().size() ) //if k => number of cases, leave one out
          wholeDataset.leaveOneOut();
     else //stratified k-fold otherwise
         wholeDataset.makeStratifiedKFold( *randomnessHandler.getDataDistributionRE(0), params.k );
@@ -293,8 +523,8 @@ void MainClass::progSplitDataset()
     for( currentFold = 0; currentFold < params.k; currentFold++ )
     {
         std::cout << "making data split " << currentFold << "\n";
-        emitter.printDataset( wholeDataset.getTrainingFold().get(), wholeDataset.getTrainingFold().get(), FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TRAIN, currentFold ) );
-        emitter.printDataset( wholeDataset.getTestFold().get(), wholeDataset.getTestFold().get(), FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, currentFold ) );
+        saveDataset( *wholeDataset.getTrainingFold(), FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TRAIN, currentFold ) );
+        saveDataset( *wholeDataset.getTestFold(), FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, currentFold ) );
         wholeDataset.nextFold();
     }
 }
@@ -302,21 +532,62 @@ void MainClass::progSplitDataset()
 void MainClass::progMakeInputCombinations()
 {
     std::cout << "program = save all posible input combinations with " << parser.getIntParam( "zerosNum" ) << " zeros \n\n";
-    Dataset combinationsDataset( {}, {}, {}, parser.getRealParam( "classThreshold") );
-    combinationsDataset.makeInputCombinations( dataset.getInputs()[0].size(), parser.getIntParam( "zerosNum" ) );
-    
+    std::string fileName = MAKE_FILENAME( OUTFILE_INPUTCOMBIS, parser.getIntParam( "zerosNum" ) );
+    uint64_t options = parser.getIntParam( "combisFormat" ) == COMBIS_FORMAT_COMPACT ? FLAG_DATA_COMPACT : FLAG_NULL;
+    emitter.printDatasetHeader( options, fileName );
+
+//---generate, filter and print the combinations by chunks (bounded memory)
+    CombinationStream combinationStream( dataset.getInputs()[0].size(), parser.getIntParam( "zerosNum" ) );
+    InstanceFilterIndex filterIndex = makeCombinationsFilter();
+    std::vector<std::vector<double>> chunk;
+    uint64_t printedNum = 0;
+    while( combinationStream.nextChunk( chunk, parser.getUintParam( "combisChunkSize" ) ) )
+    {
+        Dataset combinationsDataset( chunk, std::vector<double>( chunk.size(), 1.0 ), {}, parser.getRealParam( "classThreshold") );
+        combinationsDataset.filterInstances( filterIndex );
+        emitter.printDatasetChunk( combinationsDataset, combinationsDataset, printedNum, options, fileName );
+    }
+}
+
+void MainClass::progConvertDataset()
+{
+    std::cout << "program = convert the dataset and its splits to binary\n\n";
+    params.k = parser.getIntParam( "k" );
+
+//---whole dataset and train and test splits of each fold, if made
+    std::vector<std::string> fileNames( 1, DEFAULT_PARSER_INFILE_DATA );
+    for( uint f = 0; f < params.k; f++ )
+    {
+        fileNames.push_back( MAKE_FILENAME( OUTFILE_DATASPLIT_TRAIN, f ) );
+        fileNames.push_back( MAKE_FILENAME( OUTFILE_DATASPLIT_TEST, f ) );
+    }
+
+    for( uint f = 0; f < fileNames.size(); f++ )
+    {
+        if( ! parser.parseDataset( FLAG_NULL, fileNames[f] ) ) //splits not made
+            continue;
+        Dataset textDataset( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) );
+        if( emitter.printDatasetBinary( textDataset, FLAG_NULL, MAKE_BINARY_FILENAME( fileNames[f] ) ) )
+            std::cout << "converted " << fileNames[f] << "\n";
+        else
+            std::cout << "Error: cannot save " << MAKE_BINARY_FILENAME( fileNames[f] ) << "\n";
+    }
+}
+
+InstanceFilterIndex MainClass::makeCombinationsFilter() const
+{
+    InstanceFilterIndex filterIndex;
     switch( parser.getUintParam( "combisFilterMode") ) //filter the input combinations
     {
         case 1: //remove equal
-            combinationsDataset.filterInstancesEqual( &dataset );
+            filterIndex.indexEqual( &dataset );
         case 2: //remove supersets
-            combinationsDataset.filterInstancesSuperset( &dataset, parser.getUintParam( "combisFilterInput"), parser.getUintParam( "combisFilterClass") );
+            filterIndex.indexSupersets( &dataset, parser.getUintParam( "combisFilterInput"), parser.getUintParam( "combisFilterClass") );
             break;
         default: //no filter
             break;
     }
-    
-    emitter.printDataset( combinationsDataset, combinationsDataset, 0, MAKE_FILENAME( OUTFILE_INPUTCOMBIS, parser.getIntParam( "zerosNum" ) ) );
+    return filterIndex;
 }
 //================================================================ end of DATASET PROGRAMS ==============================================================
 
@@ -329,11 +600,16 @@ void MainClass::progMakeInputCombinations()
 
 
 ///////////////////////////////////////////////////////////////////////// *BASIC* ///////////////////////////////////////////////////////////////////////////////////////////////////
-void MainClass::init()
+bool MainClass::init()
 {
+//---global settings
+    ThreadHandler::setThreadNum( parser.getUintParam( "threadNum" ) );
+    DatasetBase::setBKeepSimilarityMatrix( parser.getIntParam( "simMatrix" ) == 1 );
+    DatasetBase::setSimilarityMode( parser.getUintParam( "simMode" ), parser.getUintParam( "simCheckNum" ) );
+
 //---parse untrained net
-    parser.parseNetwork( FLAG_NULL );
-    net = std::make_shared<NeuralWeb>( parser );
+    if( ! loadReferenceNet( DEFAULT_PARSER_INFILE_NET_W ) )
+        return false;
 
  //---if convert to fully-connected ff option
     if( parser.getIntParam( "make_ff" ) == 1 )
@@ -345,8 +621,8 @@ void MainClass::init()
         }
         else //if evaluating program, load the ff net
         {
-            parser.parseNetwork( FLAG_NULL, FILE_NET_FF );
-            net = std::make_shared<NeuralWeb>( parser );
+            if( ! loadReferenceNet( FILE_NET_FF ) )
+                return false;
         }
     }
 
@@ -361,27 +637,29 @@ void MainClass::init()
         }
         else //if evaluating program, load the crazy net
         {
-            parser.parseNetwork( FLAG_NULL, FILE_NET_CRAZY );
-            net = std::make_shared<NeuralWeb>( parser );
+            if( ! loadReferenceNet( FILE_NET_CRAZY ) )
+                return false;
         } 
     }
 
 //---set headers
     parser.setHeader( net->getHeader() );
     emitter.setHeader( net->getHeader() );
+    emitter.setNetFormat( parser.getUintParam( "netFormat" ) );
+    emitter.setBSaveThresholdCurves( parser.getIntParam( "saveThresholdCurves" ) );
 
 //---parse non-weighted dataset and weight it
     //---load base dataset (whole dataset or previously made training split)
     if( parser.getIntParam( "datasetIndex" ) == INDEX_WHOLE_DATASET ) //load wholse dataset
-        parser.parseDataset( FLAG_NULL );
+        loadDataset( DEFAULT_PARSER_INFILE_DATA );
     else //load a previously made training split
-        parser.parseDataset( FLAG_NULL, MAKE_FILENAME( OUTFILE_DATASPLIT_TRAIN, parser.getIntParam( "datasetIndex" ) ) );
+        loadDataset( MAKE_FILENAME( OUTFILE_DATASPLIT_TRAIN, parser.getIntParam( "datasetIndex" ) ) );
 
     dataset = Dataset( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) );
-    dataset.weightInstances( parser.getRealParam( "instanceWeightByOutput"), parser.getRealParam( "instanceWeightByInput") );
+    dataset.weightInstances( parser.getRealParam( "instanceWeightByOutput"), parser.getRealParam( "instanceWeightByInput"), parser.getIntParam( "simWeight" ) == 1 );
 
 //---save the weighted dataset to file
-    emitter.printDataset( dataset, dataset, FLAG_DATA_WEIGHT, DEFAULT_PARSER_INFILE_DATA_W );
+    saveDataset( dataset, FLAG_DATA_WEIGHT, DEFAULT_PARSER_INFILE_DATA_W );
     std::cout << "instance weight done\n";
 
 
@@ -389,20 +667,69 @@ void MainClass::init()
     popCreator.init( net, randomnessHandler, parser.getRealParam( "maxActivation" ), parser.getRealParam( "minActivation" ) );
 
     std::cout << "init done\n";
+    return true;
+}
+
+bool MainClass::loadReferenceNet( const std::string& fileName )
+{
+    if( ! parser.parseNetwork( FLAG_NULL, fileName ) )
+    {
+        std::cout << "Error: cannot load the net " << fileName << "\n";
+        return false;
+    }
+    net = std::make_shared<NeuralWeb>( parser );
+    return true;
+}
+
+bool MainClass::loadDataset( const std::string& fileName )
+{
+    if( parser.getIntParam( "datasetFormat" ) != DATASET_FORMAT_BINARY )
+        return parser.parseDataset( FLAG_NULL, fileName );
+
+//---map the binary file if it is newer than the text file (not edited or made again after converting). Otherwise, parse the text file and save it as binary for the next runs
+    int64_t binaryTime = MappedFile::getModificationTime( MAKE_BINARY_FILENAME( fileName ) );
+    bool bStale = binaryTime >= 0 && MappedFile::getModificationTime( fileName ) >= binaryTime;
+    if( binaryTime >= 0 && ! bStale && parser.parseDataset( FLAG_NULL, MAKE_BINARY_FILENAME( fileName ) ) )
+        return true;
+    std::cout << "converting " << fileName << " to binary" << ( bStale ? " (the text file is newer)\n" : "\n" );
+    if( ! parser.parseDataset( FLAG_NULL, fileName ) )
+        return false;
+    emitter.printDatasetBinary( Dataset( parser.getInputs(), parser.getOutputs(), parser.getInstanceWeights(), parser.getRealParam( "classThreshold" ) ), FLAG_NULL, MAKE_BINARY_FILENAME( fileName ) );
+    return true;
+}
+
+bool MainClass::saveDataset( const Dataset& datasetToSave, uint64_t options, const std::string& fileName )
+{
+    if( parser.getIntParam( "datasetFormat" ) == DATASET_FORMAT_BINARY )
+        return emitter.printDatasetBinary( datasetToSave, options, MAKE_BINARY_FILENAME( fileName ) );
+    return emitter.printDataset( datasetToSave, datasetToSave, options, fileName );
 }
 
-NeuralWeb* MainClass::loadTrainedNet( uint netIndex )
+NeuralWeb* MainClass::loadTrainedNet( uint netIndex, Parser& netParser ) const
 {
+//---binary file: the parameter vector goes straight into a copy of the reference net
+    if( parser.getIntParam( "netFormat" ) != NET_FORMAT_TEXT && netParser.parseNetworkBinary( MAKE_BINARY_FILENAME( MAKE_FILENAME( OUTFILE_NET_W, netIndex ) ), net->getTopologyHash(), net->getParamNum() ) )
+    {
+        NeuralWeb* trainedNet = new NeuralWeb( net.get() );
+        trainedNet->setParamValues( netParser.getParamValues().data() );
+        trainedNet->setTestMetrics( netParser.getMetrics() );
+        return trainedNet;
+    }
+
 //---load the trained net (no arc signs info)
-    parser.parseNetwork( FLAG_NET_TRAINED, MAKE_FILENAME( OUTFILE_NET_W, netIndex ), MAKE_FILENAME( OUTFILE_NET_ACTI, netIndex ), MAKE_FILENAME( OUTFILE_NET_METRICS, netIndex ) );
-    NeuralWeb* trainedNetBad = new NeuralWeb( parser );
+    if( ! netParser.parseNetwork( FLAG_NET_TRAINED, MAKE_FILENAME( OUTFILE_NET_W, netIndex ), MAKE_FILENAME( OUTFILE_NET_ACTI, netIndex ), MAKE_FILENAME( OUTFILE_NET_METRICS, netIndex ) ) )
+    {
+        std::cout << "Error: cannot load the trained net " << MAKE_FILENAME( OUTFILE_NET_W, netIndex ) << " (with its scales and metrics files)\n";
+        return nullptr;
+    }
+    NeuralWeb* trainedNetBad = new NeuralWeb( netParser );
 
 //---transfer the scale and weight values to a copy of the untrained reference net (with arc sign info)
     NeuralWeb* trainedNet = new NeuralWeb( net.get() );
     trainedNet->transferParams( trainedNetBad );
 
 //---load metrics into the net
-    trainedNet->setTestMetrics( parser.getMetrics() );
+    trainedNet->setTestMetrics( netParser.getMetrics() );
     //trainedNet->setMetrics( parser.getMetrics(), INDEX_SET_VAL );
 
 //---clean
@@ -410,6 +737,63 @@ NeuralWeb* MainClass::loadTrainedNet( uint netIndex )
     return trainedNet;
 }
 
+bool MainClass::loadEnsemble( NeuralWebEnsemble& ensemble )
+{
+    uint netIndex = parser.getUintParam( "netIndex" );
+    uint netNum = parser.getUintParam( "netNum" );
+    std::string bundleFileName = MAKE_BINARY_FILENAME( MAKE_FILENAME2( OUTFILE_NET_ENSEMBLE, netNum, netIndex ) );
+    bool bBinary = parser.getIntParam( "netFormat" ) != NET_FORMAT_TEXT;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::vector<NeuralWebSP> memberNets( netNum );
+
+//---the bundle is used only if every member file is older (not retrained after bundling)
+    int64_t bundleTime = bBinary ? MappedFile::getModificationTime( bundleFileName ) : -1;
+    for( uint n = netIndex; n < netIndex + netNum && bundleTime >= 0; n++ )
+    {
+        if( MappedFile::getModificationTime( MAKE_BINARY_FILENAME( MAKE_FILENAME( OUTFILE_NET_W, n ) ) ) >= bundleTime || MappedFile::getModificationTime( MAKE_FILENAME( OUTFILE_NET_W, n ) ) >= bundleTime )
+            bundleTime = -1;
+    }
+
+//---bundle: each row of the parameter matrix goes straight into a copy of the reference net
+    bool bBundle = bundleTime >= 0 && parser.parseEnsembleBinary( bundleFileName, net->getTopologyHash(), net->getParamNum(), netNum, netIndex );
+    if( bBundle )
+    {
+        const std::vector<double>& paramValues = parser.getParamValues();
+        const std::vector<double>& metrics = parser.getMetrics();
+        uint paramNum = net->getParamNum();
+        uint metricNum = metrics.size() / std::max( 1u, netNum );
+        ThreadHandler::parallelFor( 0, netNum, [&]( uint blockBegin, uint blockEnd, uint )
+        {
+            for( uint n = blockBegin; n < blockEnd; n++ )
+            {
+                memberNets[n] = std::make_shared<NeuralWeb>( net.get() );
+                memberNets[n]->setParamValues( paramValues.data() + static_cast<size_t>( n ) * paramNum );
+                memberNets[n]->setTestMetrics( std::vector<double>( metrics.begin() + n * metricNum, metrics.begin() + ( n + 1 ) * metricNum ) );
+            }
+        }, 1 );
+    }
+//---member files: parsed in parallel with a parser per thread, then bundled for the next runs
+    else
+    {
+        std::vector<Parser> netParsers( ThreadHandler::getThreadNum(), parser.makeNetParser() );
+        ThreadHandler::parallelFor( 0, netNum, [&]( uint blockBegin, uint blockEnd, uint threadIndex )
+        {
+            for( uint n = blockBegin; n < blockEnd; n++ )
+                memberNets[n] = NeuralWebSP( loadTrainedNet( netIndex + n, netParsers[threadIndex] ) );
+        }, 1 );
+        if( std::find( memberNets.begin(), memberNets.end(), nullptr ) != memberNets.end() )
+            return false;
+        if( bBinary && ! Emitter::printEnsembleBinary( memberNets, netIndex, bundleFileName ) )
+            std::cout << "Warning: could not save the ensemble bundle " << bundleFileName << "\n";
+    }
+
+//---in order, so the ensemble is the same however it was loaded
+    for( uint n = 0; n < netNum; n++ )
+        ensemble.addMemberNet( memberNets[n] );
+    std::cout << netNum << " nets loaded" << ( bBundle ? " from the ensemble bundle" : "" ) << " in " << std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - startTime ).count() << " ms\n";
+    return true;
+}
+
 void MainClass::trainNet( uint datasetIndex, bool bMakeValSplit )
 {
     uint qualityCriterion = parser.getUintParam( "bestNetCriterion" );
@@ -0,0 +1,92 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h> //mmap, munmap
+    #include <sys/stat.h> //fstat
+    #include <fcntl.h> //open
+    #include <unistd.h> //close
+    #include <cstdint> //intptr_t
+#endif
+
+
+int64_t MappedFile::getModificationTime( const std::string& fileName )
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if( ! GetFileAttributesExA( fileName.c_str(), GetFileExInfoStandard, &attributes ) )
+        return -1;
+    uint64_t ticks = ( static_cast<uint64_t>( attributes.ftLastWriteTime.dwHighDateTime ) << 32 ) | attributes.ftLastWriteTime.dwLowDateTime; //100 ns since 1601
+    return ( static_cast<int64_t>( ticks ) - 116444736000000000LL ) * 100;
+#else
+    struct stat fileStat;
+    if( stat( fileName.c_str(), &fileStat ) != 0 )
+        return -1;
+    #ifdef __APPLE__
+    return static_cast<int64_t>( fileStat.st_mtimespec.tv_sec ) * 1000000000LL + fileStat.st_mtimespec.tv_nsec;
+    #else
+    return static_cast<int64_t>( fileStat.st_mtim.tv_sec ) * 1000000000LL + fileStat.st_mtim.tv_nsec;
+    #endif
+#endif
+}
+
+bool MappedFile::open( const std::string& fileName, std::ostream& messages )
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if( file == INVALID_HANDLE_VALUE )
+        return false;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx( file, &fileSize );
+    fileHandle = file;
+    size = static_cast<size_t>( fileSize.QuadPart );
+    if( size == 0 ) //empty files cannot be mapped
+        return true;
+    mappingHandle = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if( mappingHandle != nullptr )
+        data = static_cast<const char*>( MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+#else
+    int fd = ::open( fileName.c_str(), O_RDONLY );
+    if( fd < 0 )
+        return false;
+    struct stat fileStat;
+    fstat( fd, &fileStat );
+    fileHandle = reinterpret_cast<void*>( static_cast<intptr_t>( fd ) + 1 ); //+1 so that descriptor 0 is not null
+    size = static_cast<size_t>( fileStat.st_size );
+    if( size == 0 ) //empty files cannot be mapped
+        return true;
+    void* mapped = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( mapped != MAP_FAILED )
+        data = static_cast<const char*>( mapped );
+#endif
+    if( data == nullptr )
+    {
+        messages << "Error: cannot map file " << fileName << "\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if( data != nullptr )
+        UnmapViewOfFile( data );
+    if( mappingHandle != nullptr )
+        CloseHandle( mappingHandle );
+    if( fileHandle != nullptr )
+        CloseHandle( fileHandle );
+#else
+    if( data != nullptr )
+        munmap( const_cast<char*>( data ), size );
+    if( fileHandle != nullptr )
+        ::close( static_cast<int>( reinterpret_cast<intptr_t>( fileHandle ) - 1 ) );
+#endif
+    data = nullptr;
+    size = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
@@ -0,0 +1,21 @@
+#include "MemberPredictions.hpp"
+
+
+std::vector<double> MemberPredictions::combine( const std::vector<double>& memberWeights ) const
+///members added in order, as NeuralWebEnsemble::predict() does, so the averages are the same to the last bit
+{
+    std::vector<double> outputs( instanceNum, 0.0 );
+    double totalWeight = 0.0;
+    for( uint m = 0; m < memberNum; m++ )
+    {
+        if( memberWeights[m] <= 0.0 )
+            continue;
+        totalWeight += memberWeights[m];
+        const double* memberOutputs = getMember( m );
+        for( uint d = 0; d < instanceNum; d++ )
+            outputs[d] += memberWeights[m] * memberOutputs[d];
+    }
+    for( uint d = 0; d < instanceNum; d++ )
+        outputs[d] = totalWeight > 0.0 ? outputs[d] / totalWeight : -1.0;
+    return outputs;
+}
@@ -0,0 +1,389 @@
+#include "NetPlan.hpp"
+#include "NeuralWeb.hpp" //compiled nets. Not included in the hpp file to avoid circular include with NeuralWebEnsemble
+#include "ThreadHandler.hpp" //predictRows()
+
+#include <algorithm> //std::fill, std::min, std::copy
+#include <utility> //std::pair in the constructor
+
+
+NetPlan::NetPlan( const std::vector<const NeuralWeb*>& nets, const std::vector<double>& netWeights )
+: bValid(false), inputNum(0), nodeNum(0), memberNum(0), outputSlot(0), totalWeight(0.0)
+{
+    if( nets.empty() )
+        return;
+    const NeuralWeb* reference = nets[0];
+    const std::vector<NodeSP>& nodes = reference->getNodes();
+
+//---input slots in the input layer order
+    std::vector<int> nodeSlots( nodes.size(), -1 );
+    inputNum = reference->getInputLayer().size();
+    for( uint i = 0; i < inputNum; i++ )
+        nodeSlots[ reference->getInputLayer()[i]->getId() ] = i;
+
+//---calculated nodes: depth-first from the output over the parents (the nodes Node::forwardProp() reaches), each one after its parents
+    std::vector<Node*> order;
+    std::vector<std::pair<Node*, uint>> stack( 1, std::make_pair( reference->getOutputLayer().get(), 0u ) ); //node and next parent to visit
+    std::vector<bool> bOpen( nodes.size(), false );
+    while( ! stack.empty() )
+    {
+        Node* node = stack.back().first;
+        if( nodeSlots[ node->getId() ] >= 0 ) //input or already calculated
+        {
+            stack.pop_back();
+            continue;
+        }
+        bOpen[ node->getId() ] = true;
+        if( stack.back().second < node->getParents().size() )
+        {
+            Arc* arc = node->getParents()[ stack.back().second++ ];
+            if( arc->getOrder() > 1 ) //product terms are not compiled
+                return;
+            Node* parent = arc->getParent();
+            if( parent != nullptr && nodeSlots[ parent->getId() ] < 0 )
+            {
+                if( bOpen[ parent->getId() ] ) //cycle
+                    return;
+                stack.push_back( std::make_pair( parent, 0u ) );
+            }
+            continue;
+        }
+        nodeSlots[ node->getId() ] = inputNum + order.size();
+        order.push_back( node );
+        stack.pop_back();
+    }
+    nodeNum = order.size();
+    outputSlot = nodeSlots[ reference->getOutputLayer()->getId() ];
+
+    for( uint n = 0; n < nodeNum; n++ )
+    {
+        termBegins.push_back( termParents.size() );
+        for( uint p = 0; p < order[n]->getParents().size(); p++ )
+        {
+            Arc* arc = order[n]->getParents()[p];
+            termParents.push_back( arc->getParent() == nullptr ? -1 : nodeSlots[ arc->getParent()->getId() ] );
+            termArcIds.push_back( arc->getId() );
+        }
+        functions.push_back( order[n]->getActivationFunction() );
+        nodeIds.push_back( order[n]->getId() );
+    }
+    termBegins.push_back( termParents.size() );
+
+//---members: the nets with weight > 0, with their weights and scales side by side
+    std::vector<const NeuralWeb*> members;
+    uint64_t topologyHash = reference->getTopologyHash();
+    for( uint n = 0; n < nets.size(); n++ )
+    {
+        if( netWeights[n] <= 0.0 )
+            continue;
+        if( nets[n]->getTopologyHash() != topologyHash )
+            return;
+        members.push_back( nets[n] );
+        memberWeights.push_back( netWeights[n] );
+        totalWeight += netWeights[n];
+    }
+    memberNum = members.size();
+    if( memberNum == 0 )
+        return;
+
+    termWeights.resize( termParents.size() * memberNum );
+    nodeScales.resize( nodeNum * memberNum );
+    for( uint m = 0; m < memberNum; m++ )
+    {
+        for( uint t = 0; t < termParents.size(); t++ )
+            termWeights[ t * memberNum + m ] = members[m]->getArcs()[ termArcIds[t] ]->getWeight();
+        for( uint n = 0; n < nodeNum; n++ )
+            nodeScales[ n * memberNum + m ] = members[m]->getNodes()[ order[n]->getId() ]->getScales()[0];
+    }
+    bValid = true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+double NetPlan::predict( const InputSpan& input ) const
+{
+    thread_local std::vector<double> values; //reused by the calls of each thread
+    values.resize( getValueNum( 1 ) );
+    double output;
+    loadRow( input, 0, 1, values.data() );
+    predictBlock( values.data(), 1, &output );
+    return output;
+}
+
+double NetPlan::predict( const SparseRow& input ) const
+{
+    thread_local std::vector<double> values;
+    values.resize( getValueNum( 1 ) );
+    double output;
+    loadRow( input, 0, 1, values.data() );
+    predictBlock( values.data(), 1, &output );
+    return output;
+}
+
+void NetPlan::predictBatch( const DataMatrix& inputs, uint first, uint rowNum, double* outputs ) const
+{
+    predictRows( inputs, first, rowNum, outputs );
+}
+
+void NetPlan::predictBatch( const SparseRows& inputs, uint first, uint rowNum, double* outputs ) const
+{
+    predictRows( inputs, first, rowNum, outputs );
+}
+
+void NetPlan::predictMembersBatch( const DataMatrix& inputs, uint first, uint rowNum, double* memberOutputs, size_t memberStride ) const
+{
+    predictRows( inputs, first, rowNum, memberOutputs, memberStride );
+}
+
+void NetPlan::calculateBlock( const DataMatrix& inputs, uint first, uint rowNum, double* values, double* outputs ) const
+{
+    loadBlock( inputs, first, rowNum, values );
+    predictBlock( values, rowNum, outputs );
+}
+
+NetPlan::Knockout NetPlan::makeKnockout( uint node, int term ) const
+{
+    Knockout knockout;
+    knockout.node = node;
+    knockout.term = term;
+    knockout.bInCone.assign( nodeNum, false );
+    knockout.bInCone[node] = true;
+    knockout.cone.push_back( node );
+
+//---the nodes after it with a parent in the cone (parents are always before their children)
+    for( uint n = node + 1; n < nodeNum; n++ )
+    {
+        for( uint t = termBegins[n]; t < termBegins[n + 1] && ! knockout.bInCone[n]; t++ )
+        {
+            if( termParents[t] >= static_cast<int>( inputNum ) && knockout.bInCone[ termParents[t] - inputNum ] )
+            {
+                knockout.bInCone[n] = true;
+                knockout.cone.push_back( n );
+            }
+        }
+    }
+    return knockout;
+}
+
+void NetPlan::predictKnockoutBlock( const double* values, double* knockedValues, uint rowNum, const Knockout& knockout, double* outputs ) const
+{
+//---the knocked node (0, or without the arc) and the rest of the cone, the parents out of the cone from the cached values
+    for( uint c = 0; c < knockout.cone.size(); c++ )
+    {
+        uint n = knockout.cone[c];
+        for( uint m = 0; m < memberNum; m++ )
+        {
+            double* nodeValues = slotValues( knockedValues, inputNum + n, m, rowNum );
+            if( n == knockout.node && knockout.term < 0 )
+                std::fill( nodeValues, nodeValues + rowNum, 0.0 );
+            else
+                calculateNode( n, m, values, nodeValues, rowNum, knockedValues, &knockout.bInCone, n == knockout.node ? knockout.term : -1 );
+        }
+    }
+    averageMembers( knockout.bInCone[ outputSlot - inputNum ] ? knockedValues : values, rowNum, outputs );
+}
+
+void NetPlan::attributeBlock( const DataMatrix& inputs, uint first, uint rowNum, uint stepNum, double* slotAttributions, double* termAttributions, double* outputs ) const
+{
+    thread_local std::vector<double> values; //reused by the calls of each thread
+    thread_local std::vector<double> previousValues;
+    thread_local std::vector<double> gradients;
+    values.resize( getValueNum( rowNum ) );
+    previousValues.resize( getValueNum( rowNum ) );
+    gradients.resize( getValueNum( rowNum ) );
+    std::fill( slotAttributions, slotAttributions + static_cast<size_t>( inputNum + nodeNum ) * rowNum, 0.0 );
+    std::fill( termAttributions, termAttributions + termParents.size() * rowNum, 0.0 );
+
+//---gradient x activation at the inputs
+    if( stepNum == 0 )
+    {
+        calculateBlock( inputs, first, rowNum, values.data(), outputs );
+        addAttributions( values.data(), nullptr, gradients.data(), rowNum, slotAttributions, termAttributions );
+        return;
+    }
+
+//---path-integrated: the gradient at each step times the change of the values since the previous step, from the all-0 input to the inputs. The last step predicts the inputs
+    loadBlock( inputs, first, rowNum, previousValues.data(), 0.0 );
+    calculateBlock( previousValues.data(), rowNum );
+    for( uint s = 1; s <= stepNum; s++ )
+    {
+        loadBlock( inputs, first, rowNum, values.data(), static_cast<double>( s ) / stepNum );
+        predictBlock( values.data(), rowNum, outputs );
+        addAttributions( values.data(), previousValues.data(), gradients.data(), rowNum, slotAttributions, termAttributions );
+        values.swap( previousValues );
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+void NetPlan::loadRow( const InputSpan& input, uint row, uint rowNum, double* values ) const
+{
+    for( uint i = 0; i < inputNum; i++ )
+        values[ static_cast<size_t>( i ) * rowNum + row ] = input[i];
+}
+
+void NetPlan::loadRow( const SparseRow& input, uint row, uint rowNum, double* values ) const
+{
+    for( uint i = 0; i < inputNum; i++ )
+        values[ static_cast<size_t>( i ) * rowNum + row ] = input.getDefaultValue();
+    for( uint i = 0; i < input.length; i++ )
+        values[ static_cast<size_t>( input.indexes[i] ) * rowNum + row ] = input.getIndexedValue();
+}
+
+void NetPlan::loadBlock( const DataMatrix& inputs, uint first, uint rowNum, double* values, double inputScale ) const
+{
+    for( uint b = 0; b < rowNum; b++ )
+        loadRow( inputs[ first + b ], b, rowNum, values );
+    if( inputScale == 1.0 )
+        return;
+    for( size_t v = 0; v < static_cast<size_t>( inputNum ) * rowNum; v++ )
+        values[v] *= inputScale;
+}
+
+void NetPlan::calculateNode( uint node, uint member, const double* values, double* nodeValues, uint rowNum, const double* knockedValues, const std::vector<bool>* bKnocked, int skippedTerm ) const
+///same operations in the same order as Node::forwardProp(), so the member outputs are the same to the last bit
+{
+    std::fill( nodeValues, nodeValues + rowNum, 0.0 );
+    for( uint t = termBegins[node]; t < termBegins[node + 1]; t++ ) //weighted sum in the order of the parent arcs
+    {
+        if( static_cast<int>( t ) == skippedTerm )
+            continue;
+        double weight = termWeights[ t * memberNum + member ];
+        if( termParents[t] < 0 ) //bias
+        {
+            for( uint r = 0; r < rowNum; r++ )
+                nodeValues[r] += weight;
+            continue;
+        }
+        bool bKnockedParent = bKnocked != nullptr && static_cast<uint>( termParents[t] ) >= inputNum && ( *bKnocked )[ termParents[t] - inputNum ];
+        const double* parentValues = slotValues( bKnockedParent ? knockedValues : values, termParents[t], member, rowNum );
+        for( uint r = 0; r < rowNum; r++ )
+            nodeValues[r] += weight * parentValues[r];
+    }
+    double scale = nodeScales[ node * memberNum + member ];
+    for( uint r = 0; r < rowNum; r++ )
+        nodeValues[r] *= scale;
+    functions[node]->calculateBatch( nodeValues, rowNum );
+}
+
+void NetPlan::calculateBlock( double* values, uint rowNum ) const
+{
+//---calculated nodes in order, each one for every member over the whole block
+    for( uint n = 0; n < nodeNum; n++ )
+    {
+        for( uint m = 0; m < memberNum; m++ )
+            calculateNode( n, m, values, slotValues( values, inputNum + n, m, rowNum ), rowNum );
+    }
+}
+
+void NetPlan::averageMembers( const double* values, uint rowNum, double* outputs ) const
+///same order as NeuralWebEnsemble::predict() too
+{
+//---weighted average of the member outputs, added in member order
+    std::fill( outputs, outputs + rowNum, 0.0 );
+    for( uint m = 0; m < memberNum; m++ )
+    {
+        const double* memberOutputs = slotValues( values, outputSlot, m, rowNum );
+        for( uint r = 0; r < rowNum; r++ )
+            outputs[r] += memberWeights[m] * memberOutputs[r];
+    }
+    for( uint r = 0; r < rowNum; r++ )
+        outputs[r] = totalWeight > 0.0 ? outputs[r] / totalWeight : -1.0;
+}
+
+void NetPlan::predictBlock( double* values, uint rowNum, double* outputs ) const
+{
+    calculateBlock( values, rowNum );
+    averageMembers( values, rowNum, outputs );
+}
+
+void NetPlan::addAttributions( const double* values, const double* previousValues, double* gradients, uint rowNum, double* slotAttributions, double* termAttributions ) const
+{
+//---the prediction is the weighted average of the member outputs
+    std::fill( gradients, gradients + getValueNum( rowNum ), 0.0 );
+    for( uint m = 0; m < memberNum; m++ )
+    {
+        double* outputGradients = slotValues( gradients, outputSlot, m, rowNum );
+        std::fill( outputGradients, outputGradients + rowNum, totalWeight > 0.0 ? memberWeights[m] / totalWeight : 0.0 );
+    }
+
+//---calculated nodes backwards, children before parents: gradient of the weighted sum (delta) to the parents and the terms. The input slots are shared, so they add up the gradients of all the members
+    thread_local std::vector<double> deltas;
+    deltas.resize( rowNum );
+    for( uint n = nodeNum; n-- > 0; )
+    {
+        for( uint m = 0; m < memberNum; m++ )
+        {
+            const double* nodeGradients = slotValues( gradients, inputNum + n, m, rowNum );
+            functions[n]->derivativeBatch( slotValues( values, inputNum + n, m, rowNum ), deltas.data(), rowNum );
+            double scale = nodeScales[ n * memberNum + m ];
+            for( uint r = 0; r < rowNum; r++ )
+                deltas[r] *= nodeGradients[r] * scale;
+            for( uint t = termBegins[n]; t < termBegins[n + 1]; t++ )
+            {
+                if( termParents[t] < 0 ) //bias
+                    continue;
+                double weight = termWeights[ t * memberNum + m ];
+                const double* parentValues = slotValues( values, termParents[t], m, rowNum );
+                double* parentGradients = slotValues( gradients, termParents[t], m, rowNum );
+                double* termRow = termAttributions + static_cast<size_t>( t ) * rowNum;
+                for( uint r = 0; r < rowNum; r++ )
+                    parentGradients[r] += deltas[r] * weight;
+                if( previousValues == nullptr )
+                {
+                    for( uint r = 0; r < rowNum; r++ )
+                        termRow[r] += deltas[r] * weight * parentValues[r];
+                    continue;
+                }
+                const double* previousParentValues = slotValues( previousValues, termParents[t], m, rowNum );
+                for( uint r = 0; r < rowNum; r++ )
+                    termRow[r] += deltas[r] * weight * ( parentValues[r] - previousParentValues[r] );
+            }
+        }
+    }
+
+//---slots: gradient times value (or its change), the members of the calculated nodes added
+    for( uint slot = 0; slot < inputNum + nodeNum; slot++ )
+    {
+        double* slotRow = slotAttributions + static_cast<size_t>( slot ) * rowNum;
+        for( uint m = 0; m < ( slot < inputNum ? 1 : memberNum ); m++ )
+        {
+            const double* slotGradients = slotValues( gradients, slot, m, rowNum );
+            const double* slotValueRow = slotValues( values, slot, m, rowNum );
+            if( previousValues == nullptr )
+            {
+                for( uint r = 0; r < rowNum; r++ )
+                    slotRow[r] += slotGradients[r] * slotValueRow[r];
+                continue;
+            }
+            const double* previousSlotValues = slotValues( previousValues, slot, m, rowNum );
+            for( uint r = 0; r < rowNum; r++ )
+                slotRow[r] += slotGradients[r] * ( slotValueRow[r] - previousSlotValues[r] );
+        }
+    }
+}
+
+template<typename Rows>
+void NetPlan::predictRows( const Rows& inputs, uint first, uint rowNum, double* outputs, size_t memberStride ) const
+{
+    ThreadHandler::parallelFor( first, first + rowNum, [&]( uint blockBegin, uint blockEnd, uint )
+    {
+        std::vector<double> values( getValueNum( NET_PLAN_BLOCK_ROWS ) );
+        for( uint r = blockBegin; r < blockEnd; r += NET_PLAN_BLOCK_ROWS )
+        {
+            uint blockRowNum = std::min<uint>( blockEnd - r, NET_PLAN_BLOCK_ROWS );
+            for( uint b = 0; b < blockRowNum; b++ )
+                loadRow( inputs[ r + b ], b, blockRowNum, values.data() );
+            if( memberStride == 0 )
+            {
+                predictBlock( values.data(), blockRowNum, outputs + ( r - first ) );
+                continue;
+            }
+            calculateBlock( values.data(), blockRowNum );
+            for( uint m = 0; m < memberNum; m++ )
+            {
+                const double* memberValues = slotValues( values.data(), outputSlot, m, blockRowNum );
+                std::copy( memberValues, memberValues + blockRowNum, outputs + m * memberStride + ( r - first ) );
+            }
+        }
+    }, NET_PLAN_MIN_BLOCK_ROWS );
+}
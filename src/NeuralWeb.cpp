@@ -39,6 +39,39 @@ std::vector<std::string> NeuralWeb::getHeader() const
 	return header;
 }
 
+uint64_t NeuralWeb::getTopologyHash() const
+///FNV-1a over the node names and the arcs. Biases are arcs without parent
+{
+	uint64_t hash = 1469598103934665603ULL;
+	auto add = [&hash]( uint64_t value ) { for( uint b = 0; b < 8; b++ ) hash = ( hash ^ ( ( value >> ( 8 * b ) ) & 0xff ) ) * 1099511628211ULL; };
+	add( nodes.size() );
+	for( uint n = 0; n < nodes.size(); n++ )
+	{
+		add( nodes[n]->getName().size() );
+		for( uint c = 0; c < nodes[n]->getName().size(); c++ )
+			add( static_cast<unsigned char>( nodes[n]->getName()[c] ) );
+	}
+	add( arcs.size() );
+	for( uint a = 0; a < arcs.size(); a++ )
+	{
+		add( arcs[a]->getParent() == nullptr ? UINT64_MAX : arcs[a]->getParent()->getId() );
+		add( arcs[a]->getChild()->getId() );
+		add( arcs[a]->getSign() );
+	}
+	return hash;
+}
+
+std::vector<double> NeuralWeb::getParamValues() const
+{
+	std::vector<double> paramValues;
+	paramValues.reserve( getParamNum() );
+	for( uint a = 0; a < arcs.size(); a++ )
+		paramValues.push_back( arcs[a]->getWeight() );
+	for( uint n = 0; n < nodes.size(); n++ )
+		paramValues.insert( paramValues.end(), nodes[n]->getScales().begin(), nodes[n]->getScales().end() );
+	return paramValues;
+}
+
 ////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////
 
 //==================================== STRUCTURE ============================================
@@ -51,6 +84,17 @@ void NeuralWeb::transferParams( const NeuralWeb* originalNeuralWeb )
 		arcs[a]->setWeight( originalNeuralWeb->getArcs()[a]->getWeight() );
 }
 
+void NeuralWeb::setParamValues( const double* paramValues )
+{
+	for( uint a = 0; a < arcs.size(); a++ )
+		arcs[a]->setWeight( *( paramValues++ ) );
+	for( uint n = 0; n < nodes.size(); n++ )
+	{
+		for( uint s = 0; s < nodes[n]->getScales().size(); s++ )
+			nodes[n]->setScale( *( paramValues++ ), s );
+	}
+}
+
 void NeuralWeb::findLayers() 
 {
 	inputLayer.clear();
@@ -130,16 +174,38 @@ void NeuralWeb::normalizeWeights()
 
 
 //==================================== ML ============================================
-double NeuralWeb::predict( const std::vector<std::vector<double>>& inputs, uint index ) const
+double NeuralWeb::predict( const InputSpan& input ) const
 {
 //---set the inputs in the input layer
     for( uint i = 0; i < inputLayer.size(); i++ )
-        inputLayer[i]->setValue( inputs[index][i] );
+        inputLayer[i]->setValue( input[i] );
 //---reset all nodes to "not calculated" state and forward pass
     resetNodes();
     return outputLayer->forwardProp(); //return the real value of the output node as the prediction
 }
 
+double NeuralWeb::predict( const SparseRow& input ) const
+{
+//---set the inputs in the input layer: all of them to the default value, then the listed ones
+    for( uint i = 0; i < inputLayer.size(); i++ )
+        inputLayer[i]->setValue( input.getDefaultValue() );
+    for( uint i = 0; i < input.length; i++ )
+        inputLayer[ input.indexes[i] ]->setValue( input.getIndexedValue() );
+//---reset all nodes to "not calculated" state and forward pass
+    resetNodes();
+    return outputLayer->forwardProp();
+}
+
+void NeuralWeb::predictBounds( const std::vector<double>& lInputs, const std::vector<double>& uInputs, double& lOutput, double& uOutput ) const
+{
+//---set the input intervals in the input layer
+    for( uint i = 0; i < inputLayer.size(); i++ )
+        inputLayer[i]->setBounds( lInputs[i], uInputs[i] );
+//---reset all nodes to "not calculated" state and forward pass of the intervals
+    resetNodes();
+    outputLayer->forwardPropBounds( lOutput, uOutput );
+}
+
 
 //==================================== MODIFY STRUCTURE ============================================
 void NeuralWeb::convertToFF( const std::vector<uint>& nodeNumPerLayer )
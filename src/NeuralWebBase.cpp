@@ -1,28 +1,38 @@
 #include "NeuralWebBase.hpp"
 
 
-double NeuralWebBase::evaluateWeighted( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex )
+void NeuralWebBase::predictBatch( const DataMatrix& inputs, uint first, uint rowNum, double* outputs ) const
 {
-    double equalW = 1.0 / inputs.size(); //weight for unweighted metrics i.e. all the cases have the same weight
-    Metrics& currentMetrics = setIndex == INDEX_SET_TRAIN ? trainMetrics : testMetrics;
-    currentMetrics.reset( 0.0 );
+    for( uint d = 0; d < rowNum; d++ )
+        outputs[d] = predict( inputs[ first + d ] );
+}
+
+void NeuralWebBase::predictBatch( const SparseRows& inputs, uint first, uint rowNum, double* outputs ) const
+{
+    for( uint d = 0; d < rowNum; d++ )
+        outputs[d] = predict( inputs[ first + d ] );
+}
 
-    for ( uint d = 0; d < inputs.size(); d++ )
-    {
-    	double predicted = predict( inputs, d );
-        
-    //calculate loss
-        double baseLoss = lossFunction->evaluate( predicted, outputs[d] );
-        currentMetrics.changeMember( equalW * baseLoss, INDEX_METRIC_LOSS );
-        currentMetrics.changeMember( instanceWeights[d] * baseLoss, INDEX_METRIC_LOSS_W );
+template<typename Rows>
+double NeuralWebBase::evaluateRows( const Rows& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex )
+{
+    std::vector<double> predictions( inputs.size() );
+    predictBatch( inputs, 0, inputs.size(), predictions.data() );
+    return evaluatePredictions( predictions.data(), outputs, instanceWeights, setIndex );
+}
 
-    //calculate accuracy
-        if( ( predicted >= params.classThreshold && outputs[d] >= params.classThreshold ) || ( predicted < params.classThreshold && outputs[d] < params.classThreshold ) )
-        {
-            currentMetrics.changeMember( equalW, INDEX_METRIC_ACC );
-            currentMetrics.changeMember( instanceWeights[d], INDEX_METRIC_ACC_W );
-        }
-    }
+double NeuralWebBase::evaluatePredictions( const double* predictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex )
+{
+    Metrics& currentMetrics = setIndex == INDEX_SET_TRAIN ? trainMetrics : testMetrics;
+    currentMetrics.members = calculateMetrics( predictions, outputs, instanceWeights ).members;
     return currentMetrics.getMember( INDEX_METRIC_LOSS_W ); 
 }
 
+Metrics NeuralWebBase::calculateMetrics( const double* predictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights ) const
+{
+    return metricsKernel->calculate( predictions, outputs.data(), instanceWeights.data(), outputs.size() ); //all the metrics in a single pass
+}
+
+//the row types of evaluateWeighted()
+template double NeuralWebBase::evaluateRows<DataMatrix>( const DataMatrix&, const std::vector<double>&, const std::vector<double>&, uint );
+template double NeuralWebBase::evaluateRows<SparseRows>( const SparseRows&, const std::vector<double>&, const std::vector<double>&, uint );
@@ -1,52 +1,157 @@
 #include "NeuralWebEnsemble.hpp"
 
-double NeuralWebEnsemble::predict( const std::vector<std::vector<double>>& inputs, uint index ) const
+double NeuralWebEnsemble::predict( const InputSpan& input ) const
+{
+	const NetPlan* currentPlan = getPlan();
+	return currentPlan->getBValid() ? currentPlan->predict( input ) : predictRow( input );
+}
+
+double NeuralWebEnsemble::predict( const SparseRow& input ) const
+{
+	const NetPlan* currentPlan = getPlan();
+	return currentPlan->getBValid() ? currentPlan->predict( input ) : predictRow( input );
+}
+
+void NeuralWebEnsemble::predictBatch( const DataMatrix& inputs, uint first, uint rowNum, double* outputs ) const
+{
+	const NetPlan* currentPlan = getPlan();
+	if( currentPlan->getBValid() )
+		currentPlan->predictBatch( inputs, first, rowNum, outputs );
+	else
+		NeuralWebBase::predictBatch( inputs, first, rowNum, outputs );
+}
+
+void NeuralWebEnsemble::predictBatch( const SparseRows& inputs, uint first, uint rowNum, double* outputs ) const
+{
+	const NetPlan* currentPlan = getPlan();
+	if( currentPlan->getBValid() )
+		currentPlan->predictBatch( inputs, first, rowNum, outputs );
+	else
+		NeuralWebBase::predictBatch( inputs, first, rowNum, outputs );
+}
+
+template<typename Row>
+double NeuralWebEnsemble::predictRow( const Row& input ) const
 {
 	double totalPrediction = 0.0;
 	double totalWeight = 0.0;
 	for( uint n = 0; n < memberNets.size(); n++ )
 	{
-		if( ensembleParams.qualityCriterion == NO_METRIC ) //no criterion = all nets included and no weighting
+		double weight = memberWeight( n, ensembleParams );
+		if( weight > 0.0 )
 		{
-			totalWeight += 1.0;
-			totalPrediction += memberNets[n]->predict( inputs, index );
+			totalWeight += weight;
+			totalPrediction += weight * memberNets[n]->predict( input );
 		}
-		else
+	}
+	return totalWeight > 0.0 ? totalPrediction / totalWeight : -1.0; //return average or -1 if no member fulfilled the criterion (avoids division by 0)
+}
+
+//the row types of predict()
+template double NeuralWebEnsemble::predictRow<InputSpan>( const InputSpan& ) const;
+template double NeuralWebEnsemble::predictRow<SparseRow>( const SparseRow& ) const;
+
+void NeuralWebEnsemble::predictBounds( const std::vector<double>& lInputs, const std::vector<double>& uInputs, double& lOutput, double& uOutput ) const
+///the weights are positive, so the weighted average of the member bounds bounds the weighted average of the member predictions
+{
+	double totalLBound = 0.0;
+	double totalUBound = 0.0;
+	double totalWeight = 0.0;
+	for( uint n = 0; n < memberNets.size(); n++ )
+	{
+		double weight = memberWeight( n, ensembleParams );
+		if( weight > 0.0 )
 		{
-			double qualityValue = memberNets[n]->getSavedMetrics().getMember( ensembleParams.qualityCriterion );
-
-			if( ensembleParams.qualityCriterion < METRIC_LOSS_NUM ) //criterion is loss = higher is worse. Reverse weighting
-			{
-				if(  qualityValue <= ensembleParams.qualityThreshold )
-				{
-					totalWeight += ensembleParams.bWeighted ? ( ensembleParams.qualityThreshold - qualityValue ) : 1.0;
-					totalPrediction += ( ensembleParams.bWeighted ? ( ensembleParams.qualityThreshold - qualityValue ) : 1.0  ) * memberNets[n]->predict( inputs, index );
-				}
-			}
-			else //criterion is accuracy = higher is better. Direct weighting (fitness is not considered as a valid criterion)
-			{
-				if( qualityValue >= ensembleParams.qualityThreshold )
-				{
-					totalWeight += ensembleParams.bWeighted ? qualityValue : 1.0;
-					totalPrediction += ( ensembleParams.bWeighted ? qualityValue : 1.0 ) * memberNets[n]->predict( inputs, index );
-				}
-			}
+			double lMember, uMember;
+			memberNets[n]->predictBounds( lInputs, uInputs, lMember, uMember );
+			totalWeight += weight;
+			totalLBound += weight * lMember;
+			totalUBound += weight * uMember;
 		}
 	}
-	return totalWeight > 0.0 ? totalPrediction / totalWeight : -1.0; //return average or -1 if no member fulfilled the criterion (avoids division by 0)
+	lOutput = totalWeight > 0.0 ? totalLBound / totalWeight : -1.0; //same convention as predict()
+	uOutput = totalWeight > 0.0 ? totalUBound / totalWeight : -1.0;
 }
 
-Metrics NeuralWebEnsemble::averageMetrics( const std::vector<std::vector<double>>& inputs, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex )
+MemberPredictions NeuralWebEnsemble::predictMembers( const DataMatrix& inputs ) const
+{
+	MemberPredictions memberPredictions( memberNets.size(), inputs.size() );
+	std::vector<const NeuralWeb*> nets( memberNets.size() );
+	for( uint n = 0; n < memberNets.size(); n++ )
+		nets[n] = memberNets[n].get();
+	NetPlan allMembers( nets, std::vector<double>( memberNets.size(), 1.0 ) ); //every member, whatever its weight
+	if( allMembers.getBValid() )
+		allMembers.predictMembersBatch( inputs, 0, inputs.size(), memberPredictions.getMemberEditable( 0 ), inputs.size() );
+	else
+	{
+		for( uint n = 0; n < memberNets.size(); n++ )
+			memberNets[n]->predictBatch( inputs, 0, inputs.size(), memberPredictions.getMemberEditable( n ) );
+	}
+	return memberPredictions;
+}
+
+std::vector<double> NeuralWebEnsemble::getMemberWeights( const EnsembleParams& xEnsembleParams ) const
+{
+	std::vector<double> memberWeights( memberNets.size() );
+	for( uint n = 0; n < memberNets.size(); n++ )
+		memberWeights[n] = memberWeight( n, xEnsembleParams );
+	return memberWeights;
+}
+
+Metrics NeuralWebEnsemble::averageMetrics( const MemberPredictions& memberPredictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, uint setIndex )
 {
 //--evaluate all the members and add up their metrics
 	Metrics resultMetrics(0.0);
 	for( uint n = 0; n < memberNets.size(); n++ )
 	{
 		memberNets[n]->initReflection();
-		memberNets[n]->evaluateWeighted( inputs, outputs, instanceWeights, setIndex );
+		memberNets[n]->evaluatePredictions( memberPredictions.getMember( n ), outputs, instanceWeights, setIndex );
 		resultMetrics.add( &memberNets[n]->getTestMetrics() );
 	}
 //---divide the total metrics by the number of member nets
 	resultMetrics.scale( 1.0 / memberNets.size() );
 	return resultMetrics;
 }
+
+double NeuralWebEnsemble::memberWeight( uint memberIndex, const EnsembleParams& xEnsembleParams ) const
+{
+	if( xEnsembleParams.qualityCriterion == NO_METRIC ) //no criterion = all nets included and no weighting
+		return 1.0;
+
+	double qualityValue = memberNets[memberIndex]->getSavedMetrics().getMember( xEnsembleParams.qualityCriterion );
+
+	if( xEnsembleParams.qualityCriterion < METRIC_LOSS_NUM ) //criterion is loss = higher is worse. Reverse weighting
+	{
+		if( qualityValue <= xEnsembleParams.qualityThreshold )
+			return xEnsembleParams.bWeighted ? ( xEnsembleParams.qualityThreshold - qualityValue ) : 1.0;
+	}
+	else //criterion is accuracy = higher is better. Direct weighting (fitness is not considered as a valid criterion)
+	{
+		if( qualityValue >= xEnsembleParams.qualityThreshold )
+			return xEnsembleParams.bWeighted ? qualityValue : 1.0;
+	}
+	return 0.0; //the net does not fulfil the criterion
+}
+
+const NetPlan* NeuralWebEnsemble::getPlan() const
+///the member weights and the active members are fixed once per set of members instead of for every instance. Made under the lock and then published, so the predictions of each instance only make an atomic load
+{
+	const NetPlan* currentPlan = publishedPlan.load( std::memory_order_acquire );
+	if( currentPlan != nullptr )
+		return currentPlan;
+
+	std::lock_guard<std::mutex> lock( planMutex );
+	if( plan == nullptr )
+	{
+		std::vector<const NeuralWeb*> nets( memberNets.size() );
+		std::vector<double> netWeights( memberNets.size() );
+		for( uint n = 0; n < memberNets.size(); n++ )
+		{
+			nets[n] = memberNets[n].get();
+			netWeights[n] = memberWeight( n, ensembleParams );
+		}
+		plan = std::make_shared<const NetPlan>( nets, netWeights );
+		publishedPlan.store( plan.get(), std::memory_order_release );
+	}
+	return plan.get();
+}
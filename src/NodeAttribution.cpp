@@ -0,0 +1,111 @@
+#include "NodeAttribution.hpp"
+#include "ThreadHandler.hpp" //attribute()
+
+#include <algorithm> //std::stable_sort, std::min, std::max
+#include <chrono> //attribution time
+#include <cmath> //std::abs
+#include <sstream> //makeSummary()
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+bool NodeAttribution::attribute( const DatasetBase& dataset )
+{
+    if( ! plan->getBValid() )
+    {
+        std::cout << "Error: the nets cannot be compiled (different topologies or product terms), attributions need the compiled nets\n";
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const DataMatrix& inputs = dataset.getInputs();
+    rowNum = inputs.size();
+    makeNodeNames();
+    uint slotNum = nodeNames.size();
+    uint termNum = plan->getTermNum();
+
+//---blocks of NET_PLAN_BLOCK_ROWS instances in parallel, each in a forward and a reverse sweep (per step), transposed into the [ instance ][ node ] matrices
+    uint blockNum = ( rowNum + NET_PLAN_BLOCK_ROWS - 1 ) / NET_PLAN_BLOCK_ROWS;
+    attributions.assign( static_cast<size_t>( rowNum ) * slotNum, 0.0 );
+    predictions.assign( rowNum, 0.0 );
+    std::vector<double> termAttributions( static_cast<size_t>( rowNum ) * termNum );
+    ThreadHandler::parallelFor( 0, blockNum, [&]( uint blockBegin, uint blockEnd, uint )
+    {
+        std::vector<double> blockSlots( static_cast<size_t>( slotNum ) * NET_PLAN_BLOCK_ROWS );
+        std::vector<double> blockTerms( static_cast<size_t>( termNum ) * NET_PLAN_BLOCK_ROWS );
+        for( uint b = blockBegin; b < blockEnd; b++ )
+        {
+            uint first = b * NET_PLAN_BLOCK_ROWS;
+            uint blockRowNum = std::min<uint>( rowNum - first, NET_PLAN_BLOCK_ROWS );
+            plan->attributeBlock( inputs, first, blockRowNum, params.stepNum, blockSlots.data(), blockTerms.data(), predictions.data() + first );
+            for( uint r = 0; r < blockRowNum; r++ )
+            {
+                for( uint s = 0; s < slotNum; s++ )
+                    attributions[ static_cast<size_t>( first + r ) * slotNum + s ] = blockSlots[ static_cast<size_t>( s ) * blockRowNum + r ];
+                for( uint t = 0; t < termNum; t++ )
+                    termAttributions[ static_cast<size_t>( first + r ) * termNum + t ] = blockTerms[ static_cast<size_t>( t ) * blockRowNum + r ];
+            }
+        }
+    }, NET_PLAN_MIN_BLOCK_ROWS / NET_PLAN_BLOCK_ROWS );
+
+//---summary of every node and arc (biases are not arcs), the largest contributions first
+    summaries.clear();
+    for( uint s = 0; s < slotNum; s++ )
+        summaries.push_back( summarize( attributions.data() + s, slotNum, nodeNames[s], s < plan->getInputNum() ? Summary::INPUT : Summary::NODE ) );
+    for( uint t = 0; t < termNum; t++ )
+    {
+        if( plan->getTermParent( t ) < 0 )
+            continue;
+        Arc* arc = referenceNet->getArcs()[ plan->getTermArcId( t ) ].get();
+        summaries.push_back( summarize( termAttributions.data() + t, termNum, arc->getParent()->getName() + " -> " + arc->getChild()->getName(), Summary::ARC ) );
+    }
+    inputSum = 0.0;
+    for( uint s = 0; s < plan->getInputNum(); s++ )
+        inputSum += summaries[s].mean;
+    std::stable_sort( summaries.begin(), summaries.end(), []( const Summary& summary1, const Summary& summary2 ) { return summary1.meanAbs > summary2.meanAbs; } );
+    seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    return true;
+}
+
+std::string NodeAttribution::makeSummary() const
+{
+    double meanPrediction = 0.0;
+    for( uint r = 0; r < rowNum; r++ )
+        meanPrediction += predictions[r] / rowNum;
+    std::stringstream summary;
+    summary << "attribution (" << ( params.stepNum == 0 ? std::string( "gradient x activation" ) : "path-integrated in " + std::to_string( params.stepNum ) + " steps" ) << "): " << nodeNames.size() << " nodes over " << rowNum << " instances in " << seconds << " s\n";
+    summary << "mean prediction " << meanPrediction << ", mean sum of the input attributions " << inputSum << ( params.stepNum > 0 ? " (the prediction minus that of the all-0 input when the steps are enough)" : "" ) << "\n";
+    for( uint s = 0; s < std::min<uint>( summaries.size(), ATTRIBUTION_SUMMARY_RESULTS ); s++ )
+        summary << "  " << summaries[s].name << ": mean " << summaries[s].mean << ", mean abs " << summaries[s].meanAbs << " [" << summaries[s].minValue << ", " << summaries[s].maxValue << "]\n";
+    return summary.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+void NodeAttribution::makeNodeNames()
+{
+    nodeNames.clear();
+    for( uint i = 0; i < plan->getInputNum(); i++ )
+        nodeNames.push_back( referenceNet->getInputLayer()[i]->getName() );
+    for( uint n = 0; n < plan->getNodeNum(); n++ )
+        nodeNames.push_back( referenceNet->getNodes()[ plan->getNodeId( n ) ]->getName() );
+}
+
+NodeAttribution::Summary NodeAttribution::summarize( const double* values, size_t stride, const std::string& name, Summary::Type type ) const
+{
+    Summary summary;
+    summary.name = name;
+    summary.type = type;
+    if( rowNum == 0 )
+        return summary;
+    summary.minValue = summary.maxValue = values[0];
+    for( uint r = 0; r < rowNum; r++ )
+    {
+        double value = values[ r * stride ];
+        summary.mean += value;
+        summary.meanAbs += std::abs( value );
+        summary.minValue = std::min( summary.minValue, value );
+        summary.maxValue = std::max( summary.maxValue, value );
+    }
+    summary.mean /= rowNum;
+    summary.meanAbs /= rowNum;
+    return summary;
+}
@@ -3,6 +3,15 @@
 #include <algorithm> //std::count for arcs separator
 #include <sstream> //parsing lines
 #include <fstream> //input files
+#include <cstring> //std::memcmp, std::memcpy in parseDataset()
+#include <climits> //UINT_MAX in parseDatasetBinary()
+#include <cstdlib> //std::strtod in parseNumber()
+#include <cctype> //std::isspace in parseNumber()
+#include <chrono> //rows per second in parseDataset()
+#include <unordered_map> //node name indexes in parseNetwork(), input name indexes in makeInputOrder()
+#include <unordered_set> //arc keys for finding duplicates in parseNetwork()
+#include "MappedFile.hpp" //parseDataset()
+#include "ThreadHandler.hpp" //parseDatasetText(), parsePredictionsBinary()
 
 //static
 std::map<std::string, FunctionBase::FunctionType> Parser::functionTypeNM = { { "satExponential", FunctionBase::FunctionType::SAT_EXPONENTIAL }, { "sigmoid", FunctionBase::FunctionType::SIGMOID } };
@@ -40,7 +49,7 @@ bool Parser::parseOptions( const std::string& fileName )
 		else if( strParams.find( paramName ) != strParams.end() )
 			strParams[ paramName ] = value;
 		else
-			std::cout << "!!!  wrong param \"" << paramName << "\" !!!\n"; //error msg if the param is not in any of the param maps
+			*messages << "!!!  wrong param \"" << paramName << "\" !!!\n"; //error msg if the param is not in any of the param maps
 	}
 	optionsFile.close();
 
@@ -62,71 +71,55 @@ bool Parser::parseNetwork( uint64_t options, const std::string& fileNameNet, con
 	if( ! netFile.is_open() )
 		return false;
 
+	FunctionBase::FunctionType functionType = functionTypeNM.find( strParams.find( "functionType" )->second )->second;
+	std::unordered_map<std::string, uint> nodeIndexes; //index in nodes of each node name
+	std::unordered_set<uint64_t> arcKeys; //parent and child indexes of each arc, for finding duplicates
+	uint duplicateNum = 0;
 	std::string line; 
-	while( std::getline( netFile, line ) )
+	std::vector<std::string> fields;
+	for( uint lineNumber = 1; std::getline( netFile, line ); lineNumber++ )
 	{
-		std::string parentName;
-		std::string childName;
+		if( ! line.empty() && line.back() == '\r' )
+			line.pop_back();
+		if( line.empty() )
+			continue;
 
-		std::string signStr;
+	//---get the info in each sentence: parent and child node and sign (untrained)/weight (trained)
+		splitLine( line, PARSER_NET_ARCS_SEPARATOR, fields );
+		if( fields.size() < ( GET_FLAG( options, FLAG_NET_TRAINED ) ? 3 : 2 ) )
+		{
+			*messages << "Error: malformed arc at line " << lineNumber << " of " << fileNameNet << "\n";
+			return false;
+		}
+		const std::string& parentName = fields[0];
+		const std::string& childName = fields.size() >= 3 ? fields[2] : fields[1]; //if single separator, positive sign
 		Arc::Sign sign = Arc::Sign::POS;
-		std::string weightStr;
 		double weight = INI_ARC_WEIGHT;
-		
-	//---get the info in each sentence: parent and child node and sign (untrained)/weight (trained)
-		std::stringstream lineStream( line );
-		std::getline( lineStream, parentName, PARSER_NET_ARCS_SEPARATOR );
 
 		if( GET_FLAG( options, FLAG_NET_TRAINED ) ) //if trained, parse weight
+			weight = std::stod( fields[1] );
+		else if( fields.size() >= 3 ) //if not trained, parse sign
 		{
-			std::getline( lineStream, weightStr, PARSER_NET_ARCS_SEPARATOR );
-			weight = std::stod( weightStr );
-		}
-		else //if not trained, parse sign
-		{
-			if( std::count( line.begin(), line.end(), PARSER_NET_ARCS_SEPARATOR ) >= 2 ) //if single separator, positive sign, do nothing
-			{
-				std::getline( lineStream, signStr, PARSER_NET_ARCS_SEPARATOR );
-
-				if( signStr == PARSER_NET_ARCS_SIGN_NEG )
-					sign = Arc::Sign::NEG;
-				else if( signStr == PARSER_NET_ARCS_SIGN_ANY )
-					sign = Arc::Sign::ANY;
-			}
+			if( fields[1] == PARSER_NET_ARCS_SIGN_NEG )
+				sign = Arc::Sign::NEG;
+			else if( fields[1] == PARSER_NET_ARCS_SIGN_ANY )
+				sign = Arc::Sign::ANY;
 		}
-		std::getline( lineStream, childName, PARSER_NET_ARCS_SEPARATOR );
 
 	//---create nodes if not created yet
-		bool foundParent = false;
-		bool foundChild = false;
-		NodeSP parent = nullptr;
-		NodeSP child = nullptr;
-
-		//search for the nodes in the previously created ones
-		for( uint n = 0; n < nodes.size() && ( foundParent == false || foundChild == false ); n++ )
-		{
-			if( nodes[n]->getName() == parentName )
-			{
-				foundParent = true;
-				parent = nodes[n];
-			}
-			if( nodes[n]->getName() == childName )
-			{
-				foundChild = true;
-				child = nodes[n];
-			}
-		}
-		//if not found, add them
-		if( foundParent == false )
-		{
-			parent = std::make_shared<Node>( nodes.size(), parentName, functionTypeNM.find( strParams.find( "functionType" )->second )->second );
-			nodes.push_back( parent );
-		}
-		if( foundChild == false )
-		{
-			child = std::make_shared<Node>( nodes.size(), childName, functionTypeNM.find( strParams.find( "functionType" )->second )->second );
-			nodes.push_back( child );
-		}
+		std::pair<std::unordered_map<std::string, uint>::iterator, bool> parentEntry = nodeIndexes.insert( std::make_pair( parentName, nodes.size() ) );
+		bool foundParent = ! parentEntry.second;
+		if( ! foundParent )
+			nodes.push_back( std::make_shared<Node>( nodes.size(), parentName, functionType ) );
+		std::pair<std::unordered_map<std::string, uint>::iterator, bool> childEntry = nodeIndexes.insert( std::make_pair( childName, nodes.size() ) );
+		bool foundChild = ! childEntry.second;
+		if( ! foundChild )
+			nodes.push_back( std::make_shared<Node>( nodes.size(), childName, functionType ) );
+		NodeSP parent = nodes[ parentEntry.first->second ];
+		NodeSP child = nodes[ childEntry.first->second ];
+
+		if( ! arcKeys.insert( ( static_cast<uint64_t>( parent->getId() ) << 32 ) | child->getId() ).second && duplicateNum++ < PARSER_NET_MAX_ISSUES_PRINTED )
+			*messages << "Warning: duplicate arc " << parentName << " -> " << childName << " at line " << lineNumber << " of " << fileNameNet << "\n";
 
 	//---create arc
 		arcs.push_back( std::make_shared<Arc>( arcs.size(), sign, parent.get(), child.get(), foundParent, foundChild ) ); //problem: trained nets will be given positive sign for all arcs. Always parse both trained and untrained and transfer param values
@@ -136,13 +129,17 @@ bool Parser::parseNetwork( uint64_t options, const std::string& fileNameNet, con
 		parent->addChild( arcs.back().get() );
 		child->addParent( arcs.back().get() );
 	}
+	netFile.close();
+	if( duplicateNum > 0 )
+		*messages << "Warning: " << duplicateNum << " duplicate arcs in " << fileNameNet << "\n";
+	if( ! checkNetwork( fileNameNet ) )
+		return false;
 
 	if( ! GET_FLAG( options, FLAG_NET_TRAINED ) ) //create all the bias at the end so they are the last arcs
 	{
 		for( uint n = 0; n < nodes.size(); n++ )
 			nodes[n]->createBias( arcs );
 	}
-	netFile.close();
 
 	if( ! GET_FLAG( options, FLAG_NET_TRAINED ) ) //untrained nets have no sacales and metrics files, so it's done
     	return true;
@@ -155,21 +152,14 @@ bool Parser::parseNetwork( uint64_t options, const std::string& fileNameNet, con
 
 	while( std::getline( actiFile, line ) )
 	{
-		std::string nodeName;
-		std::string actiStr;
 	//---get the info in each line: node name and scale value
-		std::stringstream lineStream( line );
-		std::getline( lineStream, nodeName, PARSER_NET_SCALES_SEPARATOR );
-		std::getline( lineStream, actiStr, PARSER_NET_SCALES_SEPARATOR );
+		splitLine( line, PARSER_NET_SCALES_SEPARATOR, fields );
+		if( fields.size() < 2 )
+			continue;
 	//---find the node and set its scale
-		for( uint n = 0; n < nodes.size(); n++ )
-		{
-			if( nodes[n]->getName() == nodeName )
-			{
-				nodes[n]->setScale( std::stod( actiStr) );
-				break;
-			}
-		}
+		std::unordered_map<std::string, uint>::const_iterator found = nodeIndexes.find( fields[0] );
+		if( found != nodeIndexes.end() )
+			nodes[ found->second ]->setScale( std::stod( fields[1] ) );
 	}
 	actiFile.close();
 
@@ -193,86 +183,663 @@ bool Parser::parseNetwork( uint64_t options, const std::string& fileNameNet, con
     return true;
 }
 
+bool Parser::parseNetworkBinary( const std::string& fileName, uint64_t topologyHash, uint paramNum )
+{
+	paramValues.clear();
+	metrics.clear();
+
+	MappedFile netFile;
+	if( ! netFile.open( fileName, *messages ) )
+		return false;
+
+	NetFileHeader fileHeader;
+	if( netFile.getSize() < sizeof( fileHeader ) || std::memcmp( netFile.getData(), PARSER_NET_BINARY_MAGIC, sizeof( fileHeader.magic ) ) != 0 )
+	{
+		*messages << "Error: " << fileName << " is not a binary net file\n";
+		return false;
+	}
+	std::memcpy( &fileHeader, netFile.getData(), sizeof( fileHeader ) );
+	if( fileHeader.version != PARSER_NET_BINARY_VERSION || netFile.getSize() < sizeof( fileHeader ) + ( static_cast<uint64_t>( fileHeader.paramNum ) + fileHeader.metricNum ) * sizeof( double ) )
+	{
+		*messages << "Error: corrupted binary net " << fileName << "\n";
+		return false;
+	}
+	if( fileHeader.topologyHash != topologyHash || fileHeader.paramNum != paramNum )
+	{
+		*messages << "Error: the net in " << fileName << " has a different topology than the reference net\n";
+		return false;
+	}
+
+	const double* values = reinterpret_cast<const double*>( netFile.getData() + sizeof( fileHeader ) ); //the header keeps the values aligned
+	paramValues.assign( values, values + fileHeader.paramNum );
+	metrics.assign( values + fileHeader.paramNum, values + fileHeader.paramNum + fileHeader.metricNum );
+	return true;
+}
+
+bool Parser::parseEnsembleBinary( const std::string& fileName, uint64_t topologyHash, uint paramNum, uint memberNum, uint firstNetIndex )
+{
+	paramValues.clear();
+	metrics.clear();
+
+	MappedFile ensembleFile;
+	if( ! ensembleFile.open( fileName, *messages ) )
+		return false;
+
+	EnsembleFileHeader fileHeader;
+	if( ensembleFile.getSize() < sizeof( fileHeader ) || std::memcmp( ensembleFile.getData(), PARSER_ENSEMBLE_BINARY_MAGIC, sizeof( fileHeader.magic ) ) != 0 )
+	{
+		*messages << "Error: " << fileName << " is not an ensemble bundle file\n";
+		return false;
+	}
+	std::memcpy( &fileHeader, ensembleFile.getData(), sizeof( fileHeader ) );
+	uint64_t valueNum = static_cast<uint64_t>( fileHeader.memberNum ) * ( static_cast<uint64_t>( fileHeader.paramNum ) + fileHeader.metricNum );
+	if( fileHeader.version != PARSER_ENSEMBLE_BINARY_VERSION || ensembleFile.getSize() < sizeof( fileHeader ) + valueNum * sizeof( double ) )
+	{
+		*messages << "Error: corrupted ensemble bundle " << fileName << "\n";
+		return false;
+	}
+	if( fileHeader.topologyHash != topologyHash || fileHeader.paramNum != paramNum || fileHeader.memberNum != memberNum || fileHeader.firstNetIndex != firstNetIndex )
+	{
+		*messages << "Error: the ensemble in " << fileName << " does not match the reference net or the requested nets\n";
+		return false;
+	}
+
+	const double* values = reinterpret_cast<const double*>( ensembleFile.getData() + sizeof( fileHeader ) ); //the header keeps the values aligned
+	const double* memberMetrics = values + static_cast<size_t>( fileHeader.memberNum ) * fileHeader.paramNum;
+	paramValues.assign( values, memberMetrics );
+	metrics.assign( memberMetrics, memberMetrics + static_cast<size_t>( fileHeader.memberNum ) * fileHeader.metricNum );
+	return true;
+}
+
+bool Parser::parsePredictionsBinary( const std::string& fileName, uint64_t firstRow, uint rowNum )
+{
+	inputs.clear();
+	outputs.clear();
+	instanceWeights.clear();
+	predictions.clear();
+
+	MappedFile predictionFile;
+	if( ! predictionFile.open( fileName, *messages ) )
+		return false;
+
+	PredictionFileHeader fileHeader;
+	if( predictionFile.getSize() < sizeof( fileHeader ) || std::memcmp( predictionFile.getData(), PARSER_PRED_BINARY_MAGIC, sizeof( fileHeader.magic ) ) != 0 )
+	{
+		*messages << "Error: " << fileName << " is not a binary prediction file\n";
+		return false;
+	}
+	std::memcpy( &fileHeader, predictionFile.getData(), sizeof( fileHeader ) );
+	if( fileHeader.version != PARSER_PRED_BINARY_VERSION || fileHeader.recordBytes != 2 * sizeof( double ) + ( fileHeader.inputNum + 7 ) / 8 || ( predictionFile.getSize() - sizeof( fileHeader ) ) % fileHeader.recordBytes != 0 )
+	{
+		*messages << "Error: corrupted binary prediction file " << fileName << "\n";
+		return false;
+	}
+	if( fileHeader.inputNum + 1 != header.size() )
+	{
+		*messages << "Error: the predictions in " << fileName << " have " << fileHeader.inputNum << " inputs and the net " << header.size() - 1 << "\n";
+		return false;
+	}
+
+//---decode the records of the range in parallel. The records are not aligned: values are copied out
+	uint64_t fileRowNum = ( predictionFile.getSize() - sizeof( fileHeader ) ) / fileHeader.recordBytes;
+	uint rangeRowNum = firstRow < fileRowNum ? static_cast<uint>( std::min<uint64_t>( rowNum, fileRowNum - firstRow ) ) : 0;
+	const char* records = predictionFile.getData() + sizeof( fileHeader ) + firstRow * fileHeader.recordBytes;
+	inputs = DataMatrix( rangeRowNum, fileHeader.inputNum );
+	outputs.resize( rangeRowNum );
+	predictions.resize( rangeRowNum );
+	double* inputValues = rangeRowNum > 0 ? inputs.row( 0 ) : nullptr; //own block: taken once, out of the threads
+	ThreadHandler::parallelFor( 0, rangeRowNum, [&]( uint blockBegin, uint blockEnd, uint )
+	{
+		for( uint d = blockBegin; d < blockEnd; d++ )
+		{
+			const char* record = records + static_cast<uint64_t>( d ) * fileHeader.recordBytes;
+			std::memcpy( &outputs[d], record, sizeof( double ) );
+			std::memcpy( &predictions[d], record + sizeof( double ), sizeof( double ) );
+			const unsigned char* bits = reinterpret_cast<const unsigned char*>( record + 2 * sizeof( double ) );
+			double* row = inputValues + static_cast<size_t>( d ) * inputs.getStride();
+			for( uint i = 0; i < fileHeader.inputNum; i++ )
+				row[i] = ( bits[ i / 8 ] >> ( i % 8 ) ) & 1 ? 1.0 : 0.0;
+		}
+	}, PARSER_PRED_MIN_BLOCK_ROWS );
+	return true;
+}
+
 bool Parser::parseDataset( uint64_t options, const std::string& fileName )
 ///should be always called after parsing net and setting the header
 {
 	inputs.clear();
+	sparseInputs.clear();
 	outputs.clear();
 	instanceWeights.clear();
 	originalDataHeader.clear();
 
-	std::ifstream dataFile ( fileName );
-	if( ! dataFile.is_open() )
+	std::shared_ptr<MappedFile> dataFile = std::make_shared<MappedFile>();
+	if( ! dataFile->open( fileName, *messages ) )
 		return false;
-	
-	std::string line; 
 
-//---load the header
-	//different input order than input layer in the net. Requires reordering
-	std::getline( dataFile, line );
-	std::stringstream lineStream( line );
-	std::string element;
+//---binary files are used as they are, text files are parsed in parallel
+	bool bBinary = dataFile->getSize() >= std::strlen( PARSER_DATA_BINARY_MAGIC ) && std::memcmp( dataFile->getData(), PARSER_DATA_BINARY_MAGIC, std::strlen( PARSER_DATA_BINARY_MAGIC ) ) == 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if( ! ( bBinary ? parseDatasetBinary( options, dataFile, fileName ) : parseDatasetText( options, *dataFile, fileName ) ) )
+		return false;
+	double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	uint rowNum = outputs.size();
+
+	*messages << "dataset size: " << rowNum;
+	if( ! bBinary && seconds > 0.0 )
+		*messages << " (" << static_cast<uint64_t>( rowNum / seconds ) << " rows/s)";
+	*messages << "\n";
+
+//---inputs in the representation asked for, whatever the file has: index lists (FLAG_DATA_COMPACT) or dense rows
+	bool bCompactFile = ! bBinary && originalDataHeader.size() == 2 && originalDataHeader[1] == PARSER_DATA_COMPACT_COLUMN;
+	if( GET_FLAG( options, FLAG_DATA_COMPACT ) && ! bCompactFile )
+	{
+		sparseInputs = SparseRows::fromDense( inputs );
+		inputs.clear();
+	}
+	else if( ! GET_FLAG( options, FLAG_DATA_COMPACT ) && bCompactFile )
+	{
+		inputs = sparseInputs.toDense();
+		sparseInputs.clear();
+	}
+	if( GET_FLAG( options, FLAG_DATA_COMPACT ) )
+		*messages << "compact inputs: " << sparseInputs.getBytes() << " bytes (" << static_cast<uint64_t>( rowNum ) * ( ( header.size() - 1 ) * sizeof( double ) ) << " as dense rows)\n";
+
+//---equal instance weights created when no weights in the dataset
+	if( ! GET_FLAG( options, FLAG_DATA_WEIGHT ) )
+	{
+		double equalWeight = 1.0 / rowNum;
+		for( uint d = 0; d < rowNum; d++ )
+			instanceWeights.push_back(  equalWeight );
+	}
+	return true;
+}
+
 
+bool Parser::parseDatasetTextHeader( uint64_t options, const std::string& headerLine, DatasetTextLayout& layout )
+{
+	originalDataHeader.clear();
+	std::stringstream lineStream( headerLine );
+	std::string element;
 	while( std::getline( lineStream, element, PARSER_DATA_SEPARATOR ) )
 		originalDataHeader.push_back( element );
+	if( ! originalDataHeader.empty() && ! originalDataHeader.back().empty() && originalDataHeader.back().back() == '\r' )
+		originalDataHeader.back().pop_back();
+	layout.bWeights = GET_FLAG( options, FLAG_DATA_WEIGHT );
+	if( layout.bWeights && originalDataHeader.size() > 1 ) //the weights column is not an input
+		originalDataHeader.erase( originalDataHeader.begin() + 1 );
+
+//---change input order to match the input layer of the network. Compact files (FLAG_DATA_COMPACT) have a single column with the indexes of the 0 inputs, already in the net order
+	layout.bCompact = originalDataHeader.size() == 2 && originalDataHeader[1] == PARSER_DATA_COMPACT_COLUMN;
+	layout.inputNum = header.size() - 1;
+	layout.inputOrder.clear();
+	return layout.bCompact || makeInputOrder( layout.inputOrder );
+}
 
-//---change input order to match the input layer of the network
+bool Parser::parseDatasetTextRows( const DatasetTextLayout& layout, const char* text, const char* textEnd, uint firstLineNumber, const std::string& fileName, DataMatrix& rowInputs, SparseRows& rowSparseInputs, std::vector<double>& rowOutputs, std::vector<double>& rowWeights )
+{
+//---count the rows (non-empty lines) for sizing the dense inputs
+	uint rowNum = 0;
+	for( const char* line = text; line < textEnd; )
+	{
+		const char* lineEnd = std::find( line, textEnd, '\n' );
+		if( lineEnd > line && ( lineEnd - line > 1 || *line != '\r' ) )
+			rowNum++;
+		line = lineEnd + 1;
+	}
+	if( layout.bCompact )
+		rowSparseInputs = SparseRows( layout.inputNum, true );
+	else
+		rowInputs = DataMatrix( rowNum, layout.inputNum, DEFAULT_PARSER_DATA_INPUTVALUE );
+	rowOutputs.assign( rowNum, 0.0 );
+	rowWeights.assign( layout.bWeights ? rowNum : 0, 0.0 );
+
+//---parse the rows in order
+	uint r = 0;
+	uint errorNum = 0;
+	std::vector<uint32_t> rowIndexes;
+	uint lineNumber = firstLineNumber;
+	for( ; text < textEnd; lineNumber++ )
+	{
+		const char* lineEnd = std::find( text, textEnd, '\n' );
+		const char* valuesEnd = lineEnd > text && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+		if( valuesEnd > text )
+		{
+			std::string lastLine;
+			const char* rowBegin = text;
+			const char* rowEnd = valuesEnd;
+			if( lineEnd == textEnd ) //last line without line break: strtod needs a terminator after the values
+			{
+				lastLine.assign( text, valuesEnd );
+				rowBegin = lastLine.c_str();
+				rowEnd = rowBegin + lastLine.size();
+			}
+			bool bOk;
+			if( layout.bCompact )
+			{
+				bOk = parseCompactRow( rowBegin, rowEnd, layout.inputNum, layout.bWeights, rowOutputs[r], layout.bWeights ? &rowWeights[r] : nullptr, rowIndexes );
+				rowSparseInputs.appendRow( rowIndexes.data(), rowIndexes.size() );
+			}
+			else
+				bOk = parseDatasetRow( rowBegin, rowEnd, layout.inputOrder, layout.bWeights, rowOutputs[r], layout.bWeights ? &rowWeights[r] : nullptr, rowInputs.row( r ) );
+			if( ! bOk && errorNum++ < PARSER_DATA_MAX_ERRORS_PRINTED )
+				printMalformedRow( fileName, lineNumber, layout );
+			r++;
+		}
+		text = lineEnd + 1;
+	}
+	if( errorNum > 0 )
+		std::cout << "Error: " << errorNum << " malformed rows in " << fileName << " (lines " << firstLineNumber << " to " << lineNumber - 1 << ")\n";
+	return errorNum == 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+bool Parser::parseDatasetBinary( uint64_t options, const std::shared_ptr<MappedFile>& dataFile, const std::string& fileName )
+{
+//---check the header and that the sections fit in the file
+	DatasetFileHeader fileHeader;
+	if( dataFile->getSize() < sizeof( fileHeader ) )
+	{
+		*messages << "Error: truncated binary dataset " << fileName << "\n";
+		return false;
+	}
+	std::memcpy( &fileHeader, dataFile->getData(), sizeof( fileHeader ) );
+	if( fileHeader.version != PARSER_DATA_BINARY_VERSION )
+	{
+		*messages << "Error: binary dataset " << fileName << " has version " << fileHeader.version << ", expected " << PARSER_DATA_BINARY_VERSION << "\n";
+		return false;
+	}
+	bool bWeights = ( fileHeader.flags & PARSER_DATA_BINARY_FLAG_WEIGHTS ) != 0;
+	uint64_t dataBytes = fileHeader.rowNum * ( static_cast<uint64_t>( fileHeader.stride ) + 1 + ( bWeights ? 1 : 0 ) ) * sizeof( double );
+	if( fileHeader.stride < fileHeader.inputNum || fileHeader.rowNum > UINT_MAX || fileHeader.dataOffset % DATA_MATRIX_ALIGNMENT != 0
+		|| fileHeader.dataOffset < sizeof( fileHeader ) + fileHeader.namesBytes || fileHeader.dataOffset + dataBytes > dataFile->getSize() )
+	{
+		*messages << "Error: corrupted binary dataset " << fileName << "\n";
+		return false;
+	}
+	if( GET_FLAG( options, FLAG_DATA_WEIGHT ) && ! bWeights )
+	{
+		*messages << "Error: binary dataset " << fileName << " has no instance weights\n";
+		return false;
+	}
+
+//---load the names (output + inputs)
+	const char* names = dataFile->getData() + sizeof( fileHeader );
+	const char* namesEnd = names + fileHeader.namesBytes;
+	for( uint n = 0; n <= fileHeader.inputNum; n++ )
+	{
+		uint32_t length;
+		if( names + sizeof( length ) > namesEnd )
+			break;
+		std::memcpy( &length, names, sizeof( length ) );
+		names += sizeof( length );
+		if( length > static_cast<size_t>( namesEnd - names ) )
+			break;
+		originalDataHeader.push_back( std::string( names, length ) );
+		names += length;
+	}
+	if( originalDataHeader.size() != fileHeader.inputNum + 1 )
+	{
+		*messages << "Error: corrupted names in binary dataset " << fileName << "\n";
+		return false;
+	}
+
+//---inputs: wrap the mapped rows if they are in the net input order, reorder them into an own matrix otherwise
 	std::vector<uint> inputOrder;
-	for( uint dh = 1; dh < originalDataHeader.size(); dh++ )
+	if( ! makeInputOrder( inputOrder ) )
+		return false;
+	bool bSameOrder = inputOrder.size() == header.size() - 1;
+	for( uint i = 0; i < inputOrder.size() && bSameOrder; i++ )
+		bSameOrder = inputOrder[i] == i;
+
+	uint rowNum = static_cast<uint>( fileHeader.rowNum );
+	const double* values = reinterpret_cast<const double*>( dataFile->getData() + fileHeader.dataOffset );
+	if( bSameOrder )
+		inputs = DataMatrix( values, rowNum, fileHeader.inputNum, fileHeader.stride, dataFile ); //zero-copy: the pages are read when used
+	else
+	{
+		inputs = DataMatrix( rowNum, header.size() - 1, DEFAULT_PARSER_DATA_INPUTVALUE );
+		for( uint r = 0; r < rowNum; r++ )
+		{
+			const double* fileRow = values + static_cast<size_t>( r ) * fileHeader.stride;
+			double* row = inputs.row( r );
+			for( uint i = 0; i < inputOrder.size(); i++ )
+				row[ inputOrder[i] ] = fileRow[i];
+		}
+	}
+
+//---outputs and weights
+	const double* fileOutputs = values + static_cast<size_t>( rowNum ) * fileHeader.stride;
+	outputs.assign( fileOutputs, fileOutputs + rowNum );
+	if( GET_FLAG( options, FLAG_DATA_WEIGHT ) )
+		instanceWeights.assign( fileOutputs + rowNum, fileOutputs + 2 * static_cast<size_t>( rowNum ) );
+	return true;
+}
+
+bool Parser::parseDatasetText( uint64_t options, const MappedFile& dataFile, const std::string& fileName )
+{
+	const char* fileBegin = dataFile.getData();
+	const char* fileEnd = fileBegin + dataFile.getSize();
+	bool bWeights = GET_FLAG( options, FLAG_DATA_WEIGHT );
+
+//---load the header: columns of the file and their order in the input layer of the network
+	const char* headerEnd = std::find( fileBegin, fileEnd, '\n' );
+	DatasetTextLayout layout;
+	if( ! parseDatasetTextHeader( options, std::string( fileBegin, headerEnd ), layout ) )
+		return false;
+	bool bCompact = layout.bCompact;
+	const std::vector<uint>& inputOrder = layout.inputOrder;
+	uint inputNum = layout.inputNum;
+
+//---split the rows in line-aligned chunks, one or more per thread
+	const char* body = headerEnd == fileEnd ? fileEnd : headerEnd + 1;
+	uint chunkNum = std::max<uint64_t>( 1, std::min<uint64_t>( ThreadHandler::getThreadNum() * PARSER_DATA_CHUNKS_PER_THREAD, ( fileEnd - body ) / PARSER_DATA_MIN_CHUNK_BYTES ) );
+	std::vector<const char*> chunkBegins( chunkNum + 1, fileEnd );
+	chunkBegins[0] = body;
+	for( uint c = 1; c < chunkNum; c++ )
 	{
-		bool found = false;
-		for( uint h = 1; h < header.size(); h++ )
+		const char* chunkBegin = std::find( std::max( body + ( fileEnd - body ) / chunkNum * c, chunkBegins[c - 1] ), fileEnd, '\n' );
+		chunkBegins[c] = chunkBegin == fileEnd ? fileEnd : chunkBegin + 1;
+	}
+
+//---count the rows and lines of each chunk for knowing where each one starts in the dataset and in the file
+	std::vector<uint> chunkRows( chunkNum + 1, 0 ); //empty lines are not rows
+	std::vector<uint> chunkLines( chunkNum + 1, 0 );
+	ThreadHandler::parallelFor( 0, chunkNum, [&]( uint chunkBegin, uint chunkEnd, uint )
+	{
+		for( uint c = chunkBegin; c < chunkEnd; c++ )
 		{
-			if( originalDataHeader[dh] == header[h] )
+			for( const char* line = chunkBegins[c]; line < chunkBegins[c + 1]; chunkLines[c + 1]++ )
 			{
-				inputOrder.push_back( h -1 );
-				found = true;
-				break;
+				const char* lineEnd = std::find( line, chunkBegins[c + 1], '\n' );
+				if( lineEnd > line && ( lineEnd - line > 1 || *line != '\r' ) )
+					chunkRows[c + 1]++;
+				line = lineEnd + 1;
 			}
 		}
-		if( found == false )
+	} );
+	for( uint c = 0; c < chunkNum; c++ )
+	{
+		chunkRows[c + 1] += chunkRows[c];
+		chunkLines[c + 1] += chunkLines[c];
+	}
+
+//---parse the chunks in parallel directly into the dataset
+	uint rowNum = chunkRows[chunkNum];
+	if( ! bCompact )
+		inputs = DataMatrix( rowNum, inputNum, DEFAULT_PARSER_DATA_INPUTVALUE );
+	outputs.assign( rowNum, 0.0 );
+	if( bWeights )
+		instanceWeights.assign( rowNum, 0.0 );
+	double* inputValues = rowNum > 0 && ! bCompact ? inputs.row( 0 ) : nullptr;
+	uint stride = inputs.getStride();
+	std::vector<SparseRows> chunkSparseInputs( bCompact ? chunkNum : 0, SparseRows( inputNum, true ) ); //index lists of each chunk, joined after parsing
+
+	std::vector<std::vector<uint>> chunkErrors( chunkNum ); //line numbers of the malformed rows
+	ThreadHandler::parallelFor( 0, chunkNum, [&]( uint chunkBegin, uint chunkEnd, uint )
+	{
+		for( uint c = chunkBegin; c < chunkEnd; c++ )
 		{
-			std::cout << "\"" << originalDataHeader[dh] << "\" not found in the net inputs\n"; //error msg if an input from the dataset is not in the net's input layer
+			uint r = chunkRows[c];
+			uint lineNumber = chunkLines[c] + 2; //1-based, after the header
+			std::vector<uint32_t> rowIndexes;
+			for( const char* line = chunkBegins[c]; line < chunkBegins[c + 1]; lineNumber++ )
+			{
+				const char* lineEnd = std::find( line, chunkBegins[c + 1], '\n' );
+				const char* valuesEnd = lineEnd > line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+				if( valuesEnd > line )
+				{
+					std::string lastLine;
+					const char* rowBegin = line;
+					const char* rowEnd = valuesEnd;
+					if( lineEnd == fileEnd ) //last line without line break: strtod needs a terminator after the values
+					{
+						lastLine.assign( line, valuesEnd );
+						rowBegin = lastLine.c_str();
+						rowEnd = rowBegin + lastLine.size();
+					}
+					bool bOk;
+					if( bCompact )
+					{
+						bOk = parseCompactRow( rowBegin, rowEnd, inputNum, bWeights, outputs[r], bWeights ? &instanceWeights[r] : nullptr, rowIndexes );
+						chunkSparseInputs[c].appendRow( rowIndexes.data(), rowIndexes.size() );
+					}
+					else
+						bOk = parseDatasetRow( rowBegin, rowEnd, inputOrder, bWeights, outputs[r], bWeights ? &instanceWeights[r] : nullptr, inputValues + static_cast<size_t>( r ) * stride );
+					if( ! bOk )
+						chunkErrors[c].push_back( lineNumber );
+					r++;
+				}
+				line = lineEnd + 1;
+			}
+		}
+	} );
+
+//---reject the dataset if there are malformed rows
+	uint errorNum = 0;
+	for( uint c = 0; c < chunkNum; c++ )
+	{
+		for( uint e = 0; e < chunkErrors[c].size(); e++, errorNum++ )
+		{
+			if( errorNum < PARSER_DATA_MAX_ERRORS_PRINTED )
+				printMalformedRow( fileName, chunkErrors[c][e], layout );
+		}
+	}
+	if( errorNum > 0 )
+	{
+		*messages << "Error: " << errorNum << " malformed rows in " << fileName << "\n";
+		inputs.clear();
+		outputs.clear();
+		instanceWeights.clear();
+		return false;
+	}
+
+//---join the index lists of the chunks
+	if( bCompact )
+	{
+		uint64_t indexNum = 0;
+		for( uint c = 0; c < chunkNum; c++ )
+			indexNum += chunkSparseInputs[c].getIndexNum();
+		sparseInputs = SparseRows( inputNum, true );
+		sparseInputs.reserve( rowNum, indexNum );
+		for( uint c = 0; c < chunkNum; c++ )
+			sparseInputs.append( chunkSparseInputs[c] );
+	}
+	return true;
+}
+
+bool Parser::parseDatasetRow( const char* line, const char* lineEnd, const std::vector<uint>& inputOrder, bool bWeight, double& output, double* weight, double* row )
+{
+	const char* cursor = line;
+	if( ! parseNumber( cursor, lineEnd, output ) )
+		return false;
+	if( bWeight && ( cursor == lineEnd || ! parseNumber( ++cursor, lineEnd, *weight ) ) )
+		return false;
+	for( uint i = 0; i < inputOrder.size(); i++ )
+	{
+		if( cursor == lineEnd || ! parseNumber( ++cursor, lineEnd, row[ inputOrder[i] ] ) ) //fewer values than inputs
 			return false;
+	}
+	return cursor == lineEnd; //more values than inputs
+}
+
+bool Parser::parseCompactRow( const char* line, const char* lineEnd, uint inputNum, bool bWeight, double& output, double* weight, std::vector<uint32_t>& rowIndexes )
+{
+	rowIndexes.clear();
+	const char* cursor = line;
+	if( ! parseNumber( cursor, lineEnd, output ) )
+		return false;
+	if( bWeight && ( cursor == lineEnd || ! parseNumber( ++cursor, lineEnd, *weight ) ) )
+		return false;
+	if( cursor == lineEnd ) //the indexes column is required, even if empty (no 0 inputs)
+		return false;
+	cursor++;
+
+//---space-separated indexes, sorted and lower than the number of inputs
+	while( cursor < lineEnd )
+	{
+		if( *cursor == ' ' || *cursor == '\t' )
+		{
+			cursor++;
+			continue;
 		}
+		uint64_t index = 0;
+		const char* digitsBegin = cursor;
+		while( cursor < lineEnd && *cursor >= '0' && *cursor <= '9' && cursor - digitsBegin < PARSER_DATA_FAST_DIGITS )
+			index = index * 10 + ( *( cursor++ ) - '0' );
+		if( cursor == digitsBegin || ( cursor < lineEnd && *cursor != ' ' && *cursor != '\t' ) || index >= inputNum || ( ! rowIndexes.empty() && index <= rowIndexes.back() ) )
+			return false;
+		rowIndexes.push_back( static_cast<uint32_t>( index ) );
 	}
+	return true;
+}
 
-//---load the values
-	while( std::getline( dataFile, line ) )
+void Parser::printMalformedRow( const std::string& fileName, uint lineNumber, const DatasetTextLayout& layout )
+{
+	if( layout.bCompact )
+		std::cout << "Error: malformed row at line " << lineNumber << " of " << fileName << " (expected the output, " << ( layout.bWeights ? "the weight, " : "" ) << "and the sorted indexes of the 0 inputs, lower than " << layout.inputNum << ")\n";
+	else
+		std::cout << "Error: malformed row at line " << lineNumber << " of " << fileName << " (expected " << 1 + ( layout.bWeights ? 1 : 0 ) + layout.inputOrder.size() << " numbers)\n";
+}
+
+bool Parser::parseNumber( const char*& cursor, const char* end, double& value )
+{
+	while( cursor < end && ( *cursor == ' ' || *cursor == '\t' ) )
+		cursor++;
+
+//---short integers (the usual 0/1 values) are converted directly. Exact, same result as strtod
+	const char* digitsEnd = cursor;
+	uint64_t integer = 0;
+	while( digitsEnd < end && digitsEnd - cursor < PARSER_DATA_FAST_DIGITS && *digitsEnd >= '0' && *digitsEnd <= '9' )
+		integer = integer * 10 + ( *( digitsEnd++ ) - '0' );
+	if( digitsEnd > cursor && ( digitsEnd == end || *digitsEnd == PARSER_DATA_SEPARATOR || *digitsEnd == ' ' || *digitsEnd == '\t' ) )
 	{
-		std::stringstream lineStream( line );
-		std::string element;
+		value = static_cast<double>( integer );
+		cursor = digitsEnd;
+	}
+	else //anything else (sign, decimals, exponent...)
+	{
+		if( cursor == end || std::isspace( static_cast<unsigned char>( *cursor ) ) ) //empty field. strtod would skip the line break and read the next line
+			return false;
+		char* numberEnd;
+		value = std::strtod( cursor, &numberEnd );
+		if( numberEnd == cursor || numberEnd > end )
+			return false;
+		cursor = numberEnd;
+	}
 
-	//---load output
-		std::getline( lineStream, element, PARSER_DATA_SEPARATOR );
-		outputs.push_back( std::stod( element ) );
+//---the value must be followed by the separator or the end of the line
+	while( cursor < end && ( *cursor == ' ' || *cursor == '\t' ) )
+		cursor++;
+	return cursor == end || *cursor == PARSER_DATA_SEPARATOR;
+}
 
-	 //---if weighted flag, load the weight
-		if( GET_FLAG( options, FLAG_DATA_WEIGHT ) )
+bool Parser::checkNetwork( const std::string& fileName ) const
+///single traversal (Kahn's topological sort) for cycles, then a backward sweep in the found order for the nodes that do not lead to the output node (the one NeuralWeb::findLayers() picks)
+{
+//---topological order: a node is taken once all its parents are
+	std::vector<uint> pendingParents( nodes.size() );
+	std::vector<uint> order;
+	order.reserve( nodes.size() );
+	for( uint n = 0; n < nodes.size(); n++ )
+	{
+		pendingParents[n] = nodes[n]->getParents().size();
+		if( pendingParents[n] == 0 )
+			order.push_back( n );
+	}
+	for( uint o = 0; o < order.size(); o++ )
+	{
+		const std::vector<Arc*>& children = nodes[ order[o] ]->getChildren();
+		for( uint c = 0; c < children.size(); c++ )
+		{
+			uint child = children[c]->getChild()->getId();
+			if( --pendingParents[child] == 0 )
+				order.push_back( child );
+		}
+	}
+	if( order.size() < nodes.size() ) //the rest are in or after a cycle, which forward propagation cannot handle
+	{
+		uint printedNum = 0;
+		for( uint n = 0; n < nodes.size() && printedNum < PARSER_NET_MAX_ISSUES_PRINTED; n++ )
 		{
-			std::getline( lineStream, element, PARSER_DATA_SEPARATOR );
-			instanceWeights.push_back( std::stod( element ) );
+			if( pendingParents[n] > 0 )
+			{
+				*messages << "Error: node " << nodes[n]->getName() << " is in or after a cycle in " << fileName << "\n";
+				printedNum++;
+			}
 		}
+		return false;
+	}
 
-	//---load inputs, following the inputOrder
-		std::vector<double> temp( inputOrder.size(), DEFAULT_PARSER_DATA_INPUTVALUE );
-		uint counter = 0;
-		while( std::getline( lineStream, element, PARSER_DATA_SEPARATOR ) )
+//---nodes that reach the output node
+	int output = -1;
+	uint outputNum = 0;
+	for( uint n = 0; n < nodes.size(); n++ )
+	{
+		if( nodes[n]->getChildren().empty() && ! nodes[n]->getParents().empty() )
 		{
-			temp[ inputOrder[counter] ] = std::stod( element );
-			counter++;
+			output = n;
+			outputNum++;
 		}
-		inputs.push_back( temp );
 	}
-	dataFile.close();
-	std::cout << "dataset size: " << inputs.size() << "\n";
+	if( output < 0 )
+	{
+		*messages << "Error: no output node in " << fileName << "\n";
+		return false;
+	}
+	if( outputNum > 1 )
+		*messages << "Warning: " << outputNum << " nodes without children in " << fileName << ", " << nodes[output]->getName() << " is the output\n";
 
-//---equal instance weights created when no weights in the dataset
-	if( ! GET_FLAG( options, FLAG_DATA_WEIGHT ) )
+	std::vector<bool> bReachesOutput( nodes.size(), false );
+	bReachesOutput[output] = true;
+	uint unreachableNum = 0;
+	for( uint o = order.size(); o-- > 0; )
 	{
-		double equalWeight = 1.0 / inputs.size();
-		for( uint d = 0; d < inputs.size(); d++ )
-			instanceWeights.push_back(  equalWeight );
+		const std::vector<Arc*>& children = nodes[ order[o] ]->getChildren();
+		for( uint c = 0; c < children.size() && ! bReachesOutput[ order[o] ]; c++ )
+			bReachesOutput[ order[o] ] = bReachesOutput[ children[c]->getChild()->getId() ];
+		if( ! bReachesOutput[ order[o] ] && unreachableNum++ < PARSER_NET_MAX_ISSUES_PRINTED )
+			*messages << "Warning: node " << nodes[ order[o] ]->getName() << " does not reach the output node " << nodes[output]->getName() << "\n";
+	}
+	if( unreachableNum > 0 )
+		*messages << "Warning: " << unreachableNum << " nodes do not reach the output in " << fileName << "\n";
+	return true;
+}
+
+void Parser::splitLine( const std::string& line, char separator, std::vector<std::string>& fields )
+{
+	uint fieldNum = 0;
+	for( size_t start = 0; start <= line.size(); fieldNum++ )
+	{
+		size_t end = line.find( separator, start );
+		if( end == std::string::npos )
+			end = line.size();
+		if( fieldNum < fields.size() )
+			fields[fieldNum].assign( line, start, end - start ); //reuse the strings of the previous line
+		else
+			fields.push_back( line.substr( start, end - start ) );
+		start = end + 1;
+	}
+	fields.resize( fieldNum );
+}
+
+bool Parser::makeInputOrder( std::vector<uint>& inputOrder ) const
+{
+	std::unordered_map<std::string, uint> inputIndexes; //position in the net input layer of each input name
+	for( uint h = 1; h < header.size(); h++ )
+		inputIndexes[ header[h] ] = h - 1;
+
+	inputOrder.clear();
+	for( uint dh = 1; dh < originalDataHeader.size(); dh++ )
+	{
+		std::unordered_map<std::string, uint>::const_iterator found = inputIndexes.find( originalDataHeader[dh] );
+		if( found == inputIndexes.end() )
+		{
+			*messages << "\"" << originalDataHeader[dh] << "\" not found in the net inputs\n"; //error msg if an input from the dataset is not in the net's input layer
+			return false;
+		}
+		inputOrder.push_back( found->second );
 	}
 	return true;
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "PredictionPipeline.hpp"
+
+#include <thread> //reader and writer threads
+#include <chrono> //stage times
+#include <sstream> //makeSummary()
+#include <cstring> //std::strlen, std::memcmp for the binary magic
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+bool PredictionPipeline::run( Parser& parser, const std::string& inputFileName, const std::string& outputFileName, uint64_t options )
+///should be always called after parsing net and setting the header
+{
+    std::ifstream file( inputFileName, std::ios::binary );
+    if( ! file.is_open() )
+    {
+        std::cout << "Error: cannot open " << inputFileName << "\n";
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+//---binary files are mapped by the parser (their pages are read when used), text files are read by the reader thread after their header
+    char magic[ sizeof( PARSER_DATA_BINARY_MAGIC ) ] = {};
+    file.read( magic, std::strlen( PARSER_DATA_BINARY_MAGIC ) );
+    bool bBinary = file.gcount() == static_cast<std::streamsize>( std::strlen( PARSER_DATA_BINARY_MAGIC ) ) && std::memcmp( magic, PARSER_DATA_BINARY_MAGIC, std::strlen( PARSER_DATA_BINARY_MAGIC ) ) == 0;
+    Parser::DatasetTextLayout layout;
+    if( bBinary )
+    {
+        file.close();
+        if( ! parser.parseDataset( FLAG_NULL, inputFileName ) )
+            return false;
+    }
+    else
+    {
+        file.clear();
+        file.seekg( 0 );
+        std::string headerLine;
+        std::getline( file, headerLine );
+        if( ! parser.parseDatasetTextHeader( FLAG_NULL, headerLine, layout ) )
+            return false;
+    }
+
+    emitter->printDatasetHeader( options, outputFileName );
+
+//---reader and writer threads around the predictor, which is this thread
+    BoundedQueue<Chunk> readQueue( params.queueChunks );
+    BoundedQueue<Chunk> predictedQueue( params.queueChunks );
+    std::thread readerThread( [&]{ bBinary ? readMapped( parser, readQueue ) : readText( file, layout, inputFileName, readQueue ); } );
+    std::thread writerThread( &PredictionPipeline::write, this, std::ref( predictedQueue ), std::cref( outputFileName ), options );
+
+    Chunk chunk;
+    while( readQueue.pop( chunk ) )
+    {
+        std::chrono::steady_clock::time_point predictStart = std::chrono::steady_clock::now();
+        chunk.predictions.resize( chunk.outputs.size() );
+        if( chunk.bSparse )
+            predictor->predictBatch( chunk.sparseInputs, 0, chunk.outputs.size(), chunk.predictions.data() );
+        else
+            predictor->predictBatch( chunk.inputs, 0, chunk.outputs.size(), chunk.predictions.data() );
+        predictSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - predictStart ).count();
+        predictedQueue.push( std::move( chunk ) );
+    }
+    predictedQueue.close();
+    readerThread.join();
+    writerThread.join();
+
+    seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    readBlockedSeconds = readQueue.getPushWaitSeconds();
+    predictStarvedSeconds = readQueue.getPopWaitSeconds();
+    predictBlockedSeconds = predictedQueue.getPushWaitSeconds();
+    writeStarvedSeconds = predictedQueue.getPopWaitSeconds();
+    readPeakChunks = readQueue.getPeakSize();
+    predictedPeakChunks = predictedQueue.getPeakSize();
+    if( ! bReadOk )
+    {
+        std::cout << "Error: " << inputFileName << " has malformed rows, only the " << rowNum << " rows before them are predicted\n";
+        return false;
+    }
+    return true;
+}
+
+std::string PredictionPipeline::makeSummary() const
+{
+    std::stringstream summary;
+    summary << "prediction pipeline: " << rowNum << " rows in " << chunkNum << " chunks of " << params.chunkSize << ", " << printedNum << " printed\n";
+    summary << "throughput: " << ( seconds > 0.0 ? rowNum / seconds : 0.0 ) << " rows/s over " << seconds << " s\n";
+    summary << "stage times (s): read " << readSeconds << ", predict " << predictSeconds << ", write " << writeSeconds << "\n";
+    summary << "waits (s): read blocked " << readBlockedSeconds << ", predict starved " << predictStarvedSeconds << ", predict blocked " << predictBlockedSeconds << ", write starved " << writeStarvedSeconds << "\n";
+    summary << "peak queued chunks: " << readPeakChunks << " read, " << predictedPeakChunks << " predicted (of " << params.queueChunks << ")\n";
+    return summary.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+void PredictionPipeline::readText( std::ifstream& file, const Parser::DatasetTextLayout& layout, const std::string& fileName, BoundedQueue<Chunk>& readQueue )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string line;
+    std::string text; //lines of a chunk
+    std::vector<double> weights;
+    uint lineNumber = 2; //1-based, after the header
+    while( true )
+    {
+    //---lines of the next chunkSize rows (empty lines are not rows)
+        text.clear();
+        uint firstLineNumber = lineNumber;
+        for( uint r = 0; r < params.chunkSize && std::getline( file, line ); lineNumber++ )
+        {
+            text.append( line ).push_back( '\n' );
+            if( ! line.empty() && ( line.size() > 1 || line[0] != '\r' ) )
+                r++;
+        }
+        if( text.empty() )
+            break;
+
+    //---rows of the chunk: input values, or index lists if the file is compact
+        Chunk chunk;
+        chunk.bSparse = layout.bCompact;
+        if( ! Parser::parseDatasetTextRows( layout, text.data(), text.data() + text.size(), firstLineNumber, fileName, chunk.inputs, chunk.sparseInputs, chunk.outputs, weights ) )
+        {
+            bReadOk = false;
+            break;
+        }
+        if( ! pushChunk( chunk, readQueue ) )
+            break;
+    }
+    readQueue.close();
+    readSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() - readQueue.getPushWaitSeconds();
+}
+
+void PredictionPipeline::readMapped( const Parser& parser, BoundedQueue<Chunk>& readQueue )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const DataMatrix& inputs = parser.getInputs();
+    const std::vector<double>& outputs = parser.getOutputs();
+    std::vector<uint> rowIndexes;
+    for( uint first = 0; first < inputs.size(); first += params.chunkSize )
+    {
+        uint chunkSize = std::min( params.chunkSize, inputs.size() - first );
+        rowIndexes.resize( chunkSize );
+        for( uint r = 0; r < chunkSize; r++ )
+            rowIndexes[r] = first + r;
+        Chunk chunk;
+        chunk.inputs = inputs.gather( rowIndexes ); //no copy: the mapped rows are read by the predictor and the writer
+        chunk.outputs.assign( outputs.begin() + first, outputs.begin() + first + chunkSize );
+        if( ! pushChunk( chunk, readQueue ) )
+            break;
+    }
+    readQueue.close();
+    readSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() - readQueue.getPushWaitSeconds();
+}
+
+bool PredictionPipeline::pushChunk( Chunk& chunk, BoundedQueue<Chunk>& readQueue )
+{
+    if( chunk.outputs.empty() ) //only empty lines
+        return true;
+    rowNum += chunk.outputs.size();
+    chunkNum++;
+    return readQueue.push( std::move( chunk ) );
+}
+
+void PredictionPipeline::write( BoundedQueue<Chunk>& predictedQueue, const std::string& fileName, uint64_t options )
+///same chunks and format as printing the whole dataset by chunks, so the file is the same
+{
+    Chunk chunk;
+    while( predictedQueue.pop( chunk ) )
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        DataMatrix chunkInputs = chunk.bSparse ? chunk.sparseInputs.toDense() : chunk.inputs;
+        Dataset correctDataset( chunkInputs, chunk.outputs, {}, params.classThreshold );
+        Dataset predictedDataset( chunkInputs, chunk.predictions, {}, params.classThreshold );
+        emitter->printDatasetChunk( correctDataset, predictedDataset, printedNum, options, fileName, params.printThresholdL, params.printThresholdU );
+        writeSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    }
+}
@@ -0,0 +1,352 @@
+#include "PredictionServer.hpp"
+#include "DataMatrix.hpp" //batch inputs
+
+#include <thread> //batcher and connection threads
+#include <algorithm> //std::min, std::nth_element
+#include <sstream> //makeSummary(), makeStatsLine()
+#include <cstdlib> //std::strtod in answer()
+#include <cstdio> //std::snprintf in answer(), std::remove for the socket file
+#include <cstring> //std::memset, std::strncpy in openSocket()
+
+#ifndef _WIN32
+    #include <sys/socket.h> //socket, bind, listen, accept, recv, send
+    #include <sys/un.h> //sockaddr_un
+    #include <netinet/in.h> //sockaddr_in
+    #include <arpa/inet.h> //htons, htonl
+    #include <poll.h> //poll
+    #include <unistd.h> //close
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+bool PredictionServer::serve()
+{
+#ifdef _WIN32
+    std::cout << "Error: the prediction server needs POSIX sockets, not available on Windows\n";
+    return false;
+#else
+    int listenSocket = openSocket();
+    if( listenSocket < 0 )
+        return false;
+    if( params.bUnixSocket )
+        std::cout << "serving " << inputNum << " inputs per request on " << FILE_NAME_SERVER_SOCKET << "\n";
+    else
+        std::cout << "serving " << inputNum << " inputs per request on 127.0.0.1:" << params.port << "\n";
+
+    start = std::chrono::steady_clock::now();
+    std::thread batcherThread( &PredictionServer::runBatcher, this );
+    std::list<Connection> connections; //a list, so each thread keeps the address of its flag
+    while( ! bStop )
+    {
+        joinFinished( connections, false ); //so a long-running server only keeps the threads of the open connections
+        pollfd listenPoll = { listenSocket, POLLIN, 0 };
+        if( poll( &listenPoll, 1, SERVER_POLL_MS ) <= 0 ) //timeout: check bStop
+            continue;
+        int connectionSocket = accept( listenSocket, nullptr, nullptr );
+        if( connectionSocket >= 0 )
+        {
+            connections.emplace_back();
+            connections.back().thread = std::thread( &PredictionServer::runConnection, this, connectionSocket, &connections.back().bFinished );
+        }
+    }
+
+//---stop: the batcher predicts what is queued and returns, and the connections finish their current lines (lines queued after that get errors)
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        queueCondition.notify_all();
+    }
+    batcherThread.join();
+    joinFinished( connections, true );
+    close( listenSocket );
+    if( params.bUnixSocket )
+        std::remove( FILE_NAME_SERVER_SOCKET );
+    return true;
+#endif
+}
+
+std::string PredictionServer::makeSummary() const
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    std::stringstream summary;
+    summary << "prediction server: " << requestNum << " requests in " << batchNum << " batches (" << ( batchNum > 0 ? static_cast<double>( requestNum ) / batchNum : 0.0 ) << " per batch), " << errorNum << " errors\n";
+    summary << "throughput: " << ( seconds > 0.0 ? requestNum / seconds : 0.0 ) << " rows/s over " << seconds << " s\n";
+    summary << "latency (last " << std::min<uint64_t>( latencyNum, SERVER_LATENCY_WINDOW ) << " requests): p50 " << getLatencyPercentile( 0.5 ) << " us, p99 " << getLatencyPercentile( 0.99 ) << " us\n";
+    return summary.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+int PredictionServer::openSocket()
+{
+#ifdef _WIN32
+    return -1;
+#else
+    int listenSocket = -1;
+    int result = -1;
+    if( params.bUnixSocket )
+    {
+        sockaddr_un address;
+        std::memset( &address, 0, sizeof( address ) );
+        address.sun_family = AF_UNIX;
+        std::strncpy( address.sun_path, FILE_NAME_SERVER_SOCKET, sizeof( address.sun_path ) - 1 );
+        std::remove( FILE_NAME_SERVER_SOCKET ); //left by a server that did not stop
+        listenSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+        if( listenSocket >= 0 )
+            result = bind( listenSocket, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) );
+    }
+    else
+    {
+        sockaddr_in address;
+        std::memset( &address, 0, sizeof( address ) );
+        address.sin_family = AF_INET;
+        address.sin_port = htons( static_cast<uint16_t>( params.port ) );
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK ); //local clients only
+        listenSocket = socket( AF_INET, SOCK_STREAM, 0 );
+        int reuse = 1;
+        if( listenSocket >= 0 )
+        {
+            setsockopt( listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( reuse ) );
+            result = bind( listenSocket, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) );
+        }
+    }
+    if( result == 0 )
+        result = listen( listenSocket, SERVER_BACKLOG );
+    if( result != 0 )
+    {
+        std::cout << "Error: cannot listen on " << ( params.bUnixSocket ? std::string( FILE_NAME_SERVER_SOCKET ) : "port " + std::to_string( params.port ) ) << "\n";
+        if( listenSocket >= 0 )
+            close( listenSocket );
+        return -1;
+    }
+    return listenSocket;
+#endif
+}
+
+void PredictionServer::runBatcher()
+{
+    std::vector<Request*> batch;
+    std::vector<double> outputs;
+    std::unique_lock<std::mutex> lock( mutex );
+    while( true )
+    {
+        queueCondition.wait( lock, [this]() { return bStop || ! queue.empty(); } );
+        if( queue.empty() ) //stopped, with every queued request predicted
+        {
+            bBatcherStopped = true; //still under the lock, so no connection queues after this
+            doneCondition.notify_all();
+            break;
+        }
+
+    //---micro-batching: wait for more requests until the batch is full or the oldest one has waited batchWaitUs
+        std::chrono::steady_clock::time_point deadline = queue.front()->arrival + std::chrono::microseconds( params.batchWaitUs );
+        queueCondition.wait_until( lock, deadline, [this]() { return bStop || queue.size() >= params.maxBatch; } );
+        uint batchSize = std::min<size_t>( queue.size(), params.maxBatch );
+        batch.assign( queue.begin(), queue.begin() + batchSize );
+        queue.erase( queue.begin(), queue.begin() + batchSize );
+        lock.unlock();
+
+    //---predict the batch outside the lock, so the connections keep queueing
+        DataMatrix batchInputs( batchSize, inputNum );
+        for( uint r = 0; r < batchSize; r++ )
+            std::copy( batch[r]->inputs, batch[r]->inputs + inputNum, batchInputs.row( r ) );
+        outputs.resize( batchSize );
+        predictor->predictBatch( batchInputs, 0, batchSize, outputs.data() );
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        lock.lock();
+        for( uint r = 0; r < batchSize; r++ )
+        {
+            batch[r]->output = outputs[r];
+            batch[r]->bDone = true;
+            latencies[ latencyNum++ % SERVER_LATENCY_WINDOW ] = std::chrono::duration<double, std::micro>( now - batch[r]->arrival ).count();
+        }
+        requestNum += batchSize;
+        batchNum++;
+        doneCondition.notify_all();
+    }
+}
+
+void PredictionServer::runConnection( int socket, std::atomic<bool>* bFinished )
+{
+#ifndef _WIN32
+    #ifdef MSG_NOSIGNAL
+    const int sendFlags = MSG_NOSIGNAL; //a client that closes early must not kill the server (SIGPIPE)
+    #else
+    const int sendFlags = 0;
+    int noSigPipe = 1;
+    setsockopt( socket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof( noSigPipe ) );
+    #endif
+    std::string pending; //text received after the last complete line
+    char buffer[SERVER_READ_BYTES];
+    bool bClose = false;
+    while( ! bStop && ! bClose )
+    {
+        pollfd connectionPoll = { socket, POLLIN, 0 };
+        if( poll( &connectionPoll, 1, SERVER_POLL_MS ) <= 0 ) //timeout: check bStop
+            continue;
+        ssize_t readBytes = recv( socket, buffer, sizeof( buffer ), 0 );
+        if( readBytes <= 0 ) //closed by the client
+            break;
+        pending.append( buffer, readBytes );
+
+    //---answer every complete line received so far at once
+        std::string replies;
+        size_t lineEnd = pending.rfind( '\n' );
+        if( lineEnd != std::string::npos )
+        {
+            replies = answer( pending.substr( 0, lineEnd + 1 ), bClose );
+            pending.erase( 0, lineEnd + 1 );
+        }
+        if( pending.size() > SERVER_MAX_LINE_BYTES && ! bClose ) //a line that does not end: close instead of buffering it
+        {
+            replies += "error: line longer than " + std::to_string( SERVER_MAX_LINE_BYTES ) + " bytes, closing\n";
+            bClose = true;
+            std::lock_guard<std::mutex> lock( mutex );
+            errorNum++;
+        }
+        for( size_t sent = 0; sent < replies.size(); )
+        {
+            ssize_t sentBytes = send( socket, replies.data() + sent, replies.size() - sent, sendFlags );
+            if( sentBytes <= 0 )
+            {
+                bClose = true;
+                break;
+            }
+            sent += sentBytes;
+        }
+    }
+    close( socket );
+#endif
+    *bFinished = true;
+}
+
+void PredictionServer::joinFinished( std::list<Connection>& connections, bool bAll )
+{
+    for( std::list<Connection>::iterator connection = connections.begin(); connection != connections.end(); )
+    {
+        if( bAll || connection->bFinished )
+        {
+            connection->thread.join();
+            connection = connections.erase( connection );
+        }
+        else
+            ++connection;
+    }
+}
+
+std::string PredictionServer::answer( const std::string& lines, bool& bClose )
+{
+//---parse the lines: the inputs of the predictions in a single block, the commands and errors kept in order
+    enum LineType { LINE_PREDICTION, LINE_STATS, LINE_ERROR };
+    std::vector<LineType> lineTypes;
+    std::vector<double> inputs;
+    std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+    uint lineErrorNum = 0;
+    for( size_t lineStart = 0; lineStart < lines.size() && ! bClose; )
+    {
+        size_t lineEnd = lines.find( '\n', lineStart );
+        std::string line = lines.substr( lineStart, lineEnd - lineStart );
+        lineStart = lineEnd + 1;
+        line.erase( line.find_last_not_of( " \t\r" ) + 1 );
+        line.erase( 0, line.find_first_not_of( " \t" ) );
+        if( line.empty() )
+            continue;
+        if( line == SERVER_COMMAND_STATS )
+            lineTypes.push_back( LINE_STATS );
+        else if( line == SERVER_COMMAND_QUIT )
+            bClose = true;
+        else if( line == SERVER_COMMAND_SHUTDOWN )
+        {
+            bStop = true;
+            bClose = true;
+        }
+        else
+        {
+            size_t rowStart = inputs.size();
+            const char* position = line.c_str();
+            while( true )
+            {
+                while( *position == ' ' || *position == '\t' || *position == ',' || *position == ';' )
+                    position++;
+                if( *position == '\0' )
+                    break;
+                char* valueEnd;
+                double value = std::strtod( position, &valueEnd );
+                if( valueEnd == position ) //not a number
+                    break;
+                inputs.push_back( value );
+                position = valueEnd;
+            }
+            bool bValid = *position == '\0' && inputs.size() - rowStart == inputNum;
+            if( ! bValid )
+            {
+                inputs.resize( rowStart );
+                lineErrorNum++;
+            }
+            lineTypes.push_back( bValid ? LINE_PREDICTION : LINE_ERROR );
+        }
+    }
+
+//---queue the predictions together and wait for all of them. Requests point into inputs, which does not change from now on
+    uint predictionNum = inputs.size() / std::max( 1u, inputNum );
+    std::vector<Request> requests( predictionNum );
+    std::unique_lock<std::mutex> lock( mutex );
+    errorNum += lineErrorNum;
+    for( uint r = 0; r < predictionNum; r++ )
+    {
+        requests[r].inputs = inputs.data() + static_cast<size_t>( r ) * inputNum;
+        requests[r].output = 0.0;
+        requests[r].bDone = false;
+        requests[r].arrival = arrival;
+        if( ! bBatcherStopped ) //otherwise nobody would predict them: left not done
+            queue.push_back( &requests[r] );
+    }
+    queueCondition.notify_all();
+    doneCondition.wait( lock, [&]() { return predictionNum == 0 || requests.back().bDone || bBatcherStopped; } ); //batches are taken in order: the last one is done last. The batcher only stops with the queue empty
+    lock.unlock();
+
+//---replies in the order of the lines
+    std::string replies;
+    char number[32];
+    uint r = 0;
+    for( uint l = 0; l < lineTypes.size(); l++ )
+    {
+        if( lineTypes[l] == LINE_PREDICTION && ! requests[r].bDone )
+        {
+            replies += "error: the server is shutting down\n";
+            r++;
+        }
+        else if( lineTypes[l] == LINE_PREDICTION )
+        {
+            std::snprintf( number, sizeof( number ), "%.17g\n", requests[ r++ ].output ); //all the digits, so clients compare predictions exactly
+            replies += number;
+        }
+        else if( lineTypes[l] == LINE_STATS )
+            replies += makeStatsLine() + "\n";
+        else
+            replies += "error: expected " + std::to_string( inputNum ) + " numbers or a command (" SERVER_COMMAND_STATS ", " SERVER_COMMAND_QUIT ", " SERVER_COMMAND_SHUTDOWN ")\n";
+    }
+    return replies;
+}
+
+std::string PredictionServer::makeStatsLine() const
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    std::stringstream stats;
+    stats << "requests " << requestNum << " batches " << batchNum << " errors " << errorNum << " rows/s " << ( seconds > 0.0 ? requestNum / seconds : 0.0 )
+          << " p50_us " << getLatencyPercentile( 0.5 ) << " p99_us " << getLatencyPercentile( 0.99 );
+    return stats.str();
+}
+
+double PredictionServer::getLatencyPercentile( double fraction ) const
+{
+    uint64_t windowNum = std::min<uint64_t>( latencyNum, SERVER_LATENCY_WINDOW );
+    if( windowNum == 0 )
+        return 0.0;
+    std::vector<double> window( latencies.begin(), latencies.begin() + windowNum );
+    std::vector<double>::iterator position = window.begin() + std::min<uint64_t>( windowNum - 1, static_cast<uint64_t>( fraction * windowNum ) );
+    std::nth_element( window.begin(), position, window.end() );
+    return *position;
+}
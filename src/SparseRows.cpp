@@ -0,0 +1,50 @@
+#include "SparseRows.hpp"
+
+#include <algorithm> //std::min in toDense()
+
+
+//////////////////////////////////////////////////////////////////////////* STATIC *///////////////////////////////////////////////////////////////////////////////////////////////
+SparseRows SparseRows::fromDense( const DataMatrix& inputs, bool bInverted )
+{
+    SparseRows rows( inputs.getColNum(), bInverted );
+    rows.offsets.reserve( inputs.size() + 1 );
+    for( uint r = 0; r < inputs.size(); r++ )
+        rows.appendRow( inputs[r] );
+    return rows;
+}
+
+
+//////////////////////////////////////////////////////////////////////////* INSTANCE *///////////////////////////////////////////////////////////////////////////////////////////////
+void SparseRows::appendRow( const InputSpan& row )
+{
+    if( empty() && colNum == 0 ) //the first row of an empty set sets the number of columns
+        colNum = row.size();
+    for( uint i = 0; i < row.size(); i++ )
+    {
+        if( ( row[i] >= 0.5 ) != bInverted ) //1 input if not inverted, 0 input if inverted
+            indexes.push_back( i );
+    }
+    offsets.push_back( indexes.size() );
+}
+
+void SparseRows::append( const SparseRows& rows )
+{
+    uint64_t shift = indexes.size();
+    indexes.insert( indexes.end(), rows.indexes.begin(), rows.indexes.end() );
+    offsets.reserve( offsets.size() + rows.size() );
+    for( uint r = 1; r < rows.offsets.size(); r++ )
+        offsets.push_back( rows.offsets[r] + shift );
+}
+
+DataMatrix SparseRows::toDense( uint first, uint rowNum ) const
+{
+    first = std::min( first, size() );
+    rowNum = std::min( rowNum, size() - first );
+    DataMatrix dense( rowNum, colNum );
+    if( rowNum == 0 )
+        return dense;
+    double* values = dense.row( 0 ); //own block: taken once
+    for( uint r = 0; r < rowNum; r++ )
+        ( *this )[ first + r ].expand( values + static_cast<size_t>( r ) * dense.getStride() );
+    return dense;
+}
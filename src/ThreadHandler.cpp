@@ -0,0 +1,4 @@
+#include "ThreadHandler.hpp"
+
+//static
+uint ThreadHandler::threadNum = DEFAULT_THREAD_NUM;
@@ -0,0 +1,86 @@
+#include "ThresholdCurve.hpp"
+
+#include <algorithm> //std::sort
+#include <numeric> //std::iota
+#include <limits> //infinite threshold of the first point
+#include <sstream> //makeSummary()
+
+
+ThresholdCurve::ThresholdCurve( const double* predictions, const std::vector<double>& outputs, const std::vector<double>& instanceWeights, double classThreshold )
+: positiveNum(0.0), negativeNum(0.0), positiveWeight(0.0), negativeWeight(0.0)
+, rocAuc(-1.0), weightedRocAuc(-1.0), averagePrecision(-1.0), weightedAveragePrecision(-1.0), bestIndex(0), bestWeightedIndex(0)
+{
+//---instances by decreasing prediction: sorted once, O(N log N)
+    std::vector<uint> order( outputs.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(), [predictions]( uint a, uint b ) { return predictions[a] > predictions[b]; } );
+
+//---sweep: lowering the threshold to each distinct prediction moves its instances to predicted 1
+    points.push_back( Point( std::numeric_limits<double>::infinity() ) );
+    for( uint i = 0; i < order.size(); i++ )
+    {
+        uint d = order[i];
+        if( i == 0 || predictions[d] != points.back().threshold )
+        {
+            Point point = points.back();
+            point.threshold = predictions[d];
+            points.push_back( point );
+        }
+        if( outputs[d] >= classThreshold )
+        {
+            points.back().truePositives += 1.0;
+            points.back().weightedTruePositives += instanceWeights[d];
+            positiveNum += 1.0;
+            positiveWeight += instanceWeights[d];
+        }
+        else
+        {
+            points.back().falsePositives += 1.0;
+            points.back().weightedFalsePositives += instanceWeights[d];
+            negativeNum += 1.0;
+            negativeWeight += instanceWeights[d];
+        }
+    }
+    calculateAreas();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* API *///////////////////////////////////////////////////////////////////////////////////////////////
+std::string ThresholdCurve::makeSummary() const
+{
+    std::stringstream summary;
+    summary << "ROC AUC: " << rocAuc << " (weighted " << weightedRocAuc << ")  |   average precision: " << averagePrecision << " (weighted " << weightedAveragePrecision << ")  |   "
+            << "best threshold: " << points[bestIndex].threshold << " accuracy: " << getAccuracy( bestIndex ) << "  |   "
+            << "best weighted threshold: " << points[bestWeightedIndex].threshold << " accuracyW: " << getWeightedAccuracy( bestWeightedIndex );
+    return summary.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////////* PRIVATE *///////////////////////////////////////////////////////////////////////////////////////////////
+void ThresholdCurve::calculateAreas()
+///trapezoids between consecutive ROC points (ties make diagonal segments) and recall steps times precision for the precision-recall curve
+{
+    bool bRoc = positiveNum > 0.0 && negativeNum > 0.0; //both classes, else the rates are 0 / 0
+    bool bWeightedRoc = positiveWeight > 0.0 && negativeWeight > 0.0;
+    bool bPrecision = positiveNum > 0.0;
+    bool bWeightedPrecision = positiveWeight > 0.0;
+    rocAuc = bRoc ? 0.0 : -1.0;
+    weightedRocAuc = bWeightedRoc ? 0.0 : -1.0;
+    averagePrecision = bPrecision ? 0.0 : -1.0;
+    weightedAveragePrecision = bWeightedPrecision ? 0.0 : -1.0;
+    for( uint p = 1; p < points.size(); p++ )
+    {
+        if( bRoc )
+            rocAuc += ( getFalsePositiveRate( p ) - getFalsePositiveRate( p - 1 ) ) * ( getTruePositiveRate( p ) + getTruePositiveRate( p - 1 ) ) * 0.5;
+        if( bWeightedRoc )
+            weightedRocAuc += ( getFalsePositiveRate( p, true ) - getFalsePositiveRate( p - 1, true ) ) * ( getTruePositiveRate( p, true ) + getTruePositiveRate( p - 1, true ) ) * 0.5;
+        if( bPrecision )
+            averagePrecision += ( getTruePositiveRate( p ) - getTruePositiveRate( p - 1 ) ) * getPrecision( p );
+        if( bWeightedPrecision )
+            weightedAveragePrecision += ( getTruePositiveRate( p, true ) - getTruePositiveRate( p - 1, true ) ) * getPrecision( p, true );
+        if( getAccuracy( p ) > getAccuracy( bestIndex ) )
+            bestIndex = p;
+        if( getWeightedAccuracy( p ) > getWeightedAccuracy( bestWeightedIndex ) )
+            bestWeightedIndex = p;
+    }
+}